@@ -29,6 +29,7 @@
 
 #include <chimp/RuntimeDB.h>
 #include <chimp/interaction/Driver.h>
+#include <chimp/interaction/StatisticsMonitor.h>
 #include <chimp/interaction/filter/Or.h>
 #include <chimp/interaction/filter/Elastic.h>
 #include <chimp/interaction/filter/Label.h>
@@ -100,8 +101,10 @@ int main() {
   std::cout << "\n\nSimple 0-D test using each interaction set "
                "known to the runtime database:\n";
   std::vector< simtest::Particle > result_list;
+  typedef chimp::interaction::StatisticsMonitor<true> Monitor;
+  Monitor monitor;
   // FIXME:  Finish the implementation of the collision driver
-  chimp::interaction::Driver<>()(
+  chimp::interaction::Driver< Monitor >( monitor )(
     1e-3 /* s */,
     cell,
     db,
@@ -110,7 +113,9 @@ int main() {
   );
 
   /* lets print out some statistics. */
-  // FIXME:  where are we going to get these said statistics???
+  std::cout << "\nCollision statistics:\n";
+  Monitor::writeCSVHeader( std::cout );
+  monitor.writeCSV( std::cout, db, "0" );
   std::cout << std::endl;
 
   return 0;
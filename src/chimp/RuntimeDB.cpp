@@ -41,6 +41,8 @@
 #  include <xylose/strutil.h>
 #  include <xylose/compat/math.hpp>
 
+#  include <physical/physical.h>
+
 #  include <ostream>
 #  include <fstream>
 #  include <sstream>
@@ -57,7 +59,11 @@ namespace chimp {
   RuntimeDB<T>::RuntimeDB(const std::string & xml_doc)
     : xmlDb(xml_doc),
       default_ElasticCreator_vmax(0.0),
-      default_ElasticCreator_dv(0.0) {
+      default_ElasticCreator_dv(0.0),
+      default_ElasticCreator_tolerance(1e-3),
+      default_PreComputedSet_Emax(100.0 * physical::constant::si::eV),
+      default_PreComputedSet_nbins(1000u),
+      default_Set_maxSigmaV_Emax(1000.0 * physical::constant::si::eV) {
     /* Let's make sure that the calculator is prepared. */
     prepareCalculator(xmlDb);
 
@@ -125,6 +131,77 @@ namespace chimp {
   }
 
 
+  template < typename T >
+  typename RuntimeDB<T>::LHSRelatedInteractionCtx
+  RuntimeDB<T>::findAllTernaryInteractionCtx( const std::string & xpath_extra ) {
+    LHSRelatedInteractionCtx retval;
+
+    /* Visit each Interaction with total cross_section data once and index it
+     * by its sorted inputs, rather than querying for each triple of species. */
+    xml::Context::list xl = xmlDb.eval(
+      "//Interaction/cross_section/.."
+      + ( xpath_extra.size() > 0 ? '/' + xpath_extra : "" )
+    );
+
+    for ( xml::Context::list::const_iterator i = xl.begin(),
+                                          iend = xl.end();
+                                            i != iend; ++i ) {
+      xml::Context::list terms = i->eval("Eq/In/T");
+
+      int species[3];
+      int n_in = 0;
+      for ( xml::Context::list::const_iterator t = terms.begin(),
+                                            tend = terms.end();
+                                              t != tend; ++t ) {
+        const int s = findParticleIndx( t->query<std::string>("P") );
+        const int n = t->query<int>("n",1);
+
+        if ( s < 0 || n_in + n > 3 ) {
+          /* unloaded input or too many inputs. */
+          n_in = -1;
+          break;
+        }
+
+        for ( int k = 0; k < n; ++k )
+          species[n_in++] = s;
+      }
+
+      if ( n_in != 3 )
+        continue;
+
+      std::sort( species, species + 3 );
+      retval[ interaction::Input(species[0], species[1], species[2]) ]
+        .insert(*i);
+    }
+
+    /* now filter the interactions to get the desired subset. */
+    for ( typename LHSRelatedInteractionCtx::iterator i = retval.begin(),
+                                                    end = retval.end();
+                                                      i != end; ++i )
+      i->second = filter->filter( i->second );
+
+    return retval;
+  }
+
+
+  template < typename T >
+  std::string RuntimeDB<T>::getParticlesOutputFilter() const {
+    std::ostringstream istr;
+    typedef typename PropertiesVector::const_iterator PIter;
+    for ( PIter i = props.begin(), end = props.end(); i != end; ++i ) {
+      using property::name;
+      istr << ':' << i->name::value << ':';
+    }
+
+    return
+      "Eq/Out["
+        "T/P[     contains('" + istr.str() + "', concat(':',text(),':'))]"
+      "][not("
+        "T/P[not( contains('" + istr.str() + "', concat(':',text(),':')))]"
+      ")]/../..";
+  }
+
+
   template < typename T >
   void RuntimeDB<T>::initBinaryInteractions() {
     /* first thing we do is to sort the particle property entries by mass and
@@ -132,22 +209,7 @@ namespace chimp {
     std::sort(props.begin(), props.end(), property::Comparator());
 
     /* We need to get the set of all particle names to do extra filtering */
-    std::string particles_output_filter;
-    {
-      std::ostringstream istr;
-      typedef typename PropertiesVector::iterator PIter;
-      for ( PIter i = props.begin(), end = props.end(); i != end; ++i ) {
-        using property::name;
-        istr << ':' << i->name::value << ':';
-      }
-
-      particles_output_filter =
-        "Eq/Out["
-          "T/P[     contains('" + istr.str() + "', concat(':',text(),':'))]"
-        "][not("
-          "T/P[not( contains('" + istr.str() + "', concat(':',text(),':')))]"
-        ")]/../..";
-    }
+    const std::string particles_output_filter = getParticlesOutputFilter();
 
     /* make sure that the side-length of the matrix is set correctly. */
     interactions.resize(props.size());
@@ -174,6 +236,9 @@ namespace chimp {
         /* Finally load the Equation fully and push it into the Output stack. */
         set.rhs.push_back(Set::Equation::load(*k,*this));
       }
+
+      /* allow the set to cache whatever it needs now that it is complete. */
+      set.prepare(*this);
     }
 
     if (options::auto_create_missing_elastic)
@@ -181,6 +246,35 @@ namespace chimp {
   }
 
 
+  template < typename T >
+  void RuntimeDB<T>::initTernaryInteractions() {
+    ternary_interactions.clear();
+
+    LHSRelatedInteractionCtx lhs_ctxs =
+      findAllTernaryInteractionCtx( getParticlesOutputFilter() );
+    typedef LHSRelatedInteractionCtx::const_iterator LHSCtxIter;
+
+    for ( LHSCtxIter lhs_i  = lhs_ctxs.begin(),
+                     lhend  = lhs_ctxs.end();
+                     lhs_i != lhend; ++lhs_i ) {
+      xml::Context::set const & xs = lhs_i->second;
+      if ( xs.empty() )
+        /* all interactions of these inputs were filtered out. */
+        continue;
+
+      Set & set = ternary_interactions[ lhs_i->first ];
+      set.lhs = lhs_i->first;
+
+      for ( xml::Context::set::const_iterator k = xs.begin(),
+                                           kend = xs.end();
+                                             k != kend; ++k )
+        set.rhs.push_back(Set::Equation::load(*k,*this));
+
+      set.prepare(*this);
+    }
+  }
+
+
   template < typename T >
   inline typename RuntimeDB<T>::PropertiesVector::const_iterator
   RuntimeDB<T>::findParticle(const std::string & name) const {
@@ -343,6 +437,24 @@ namespace chimp {
   }
 
 
+  template < typename T >
+  inline const typename RuntimeDB<T>::Set &
+  RuntimeDB<T>::operator() ( const int & i,
+                             const int & j,
+                             const int & k ) const {
+    static const Set empty;
+
+    int s[3] = { i, j, k };
+    std::sort( s, s + 3 );
+
+    typename TernaryInteractionTable::const_iterator it =
+      ternary_interactions.find( interaction::Input(s[0], s[1], s[2]) );
+    if ( it == ternary_interactions.end() )
+      return empty;
+    return it->second;
+  }
+
+
   template < typename T >
   inline void RuntimeDB<T>::addXMLData( const std::string & filename ) {
     xml::Doc otherDoc(filename);
@@ -374,13 +486,9 @@ namespace chimp {
     if ( vmax <= 0.0 )
       vmax = default_ElasticCreator_vmax;
 
-    if ( vmax > 0.0 ) {
-      if ( dv <= 0.0 )
-        dv = default_ElasticCreator_dv;
-
-      if ( dv <= 0.0 )
-        dv = vmax / 100.0;
-    }
+    if ( vmax > 0.0 && dv <= 0.0 )
+      /* if this is still <= 0, the tables will be built adaptively. */
+      dv = default_ElasticCreator_dv;
 
 
     int nNewCS = 0;
@@ -440,10 +548,11 @@ namespace chimp {
              * findMaxSigmaV so easy.
              */
             eq.cs.reset( new AvgEasy( eqii.cs, eqjj.cs ) );
-          } else if ( vmax > 0.0 && dv > 0.0 ) {
+          } else if ( vmax > 0.0 ) {
             /* Adding two arbitrary cross sections together--more difficult. */
             typedef interaction::cross_section::AveragedDiameters<options> AvgCS;
-            eq.cs.reset( new AvgCS(eqii.cs, eqjj.cs, vmax, dv) );
+            eq.cs.reset( new AvgCS(eqii.cs, eqjj.cs, vmax, dv,
+                                   default_ElasticCreator_tolerance) );
           } else {
             /* Can't add arbitrary pairs together when vmax and dv are not set.
              * Emit a warning. */
@@ -463,6 +572,7 @@ namespace chimp {
 
             // We've set all the members of Equation by hand, so now insert it
             setij.rhs.push_back( eq );
+            setij.prepare( *this );
 
             ++nNewCS;
           }
@@ -123,6 +123,7 @@
 #  include <fstream>
 #  include <cfloat>
 #  include <set>
+#  include <map>
 #  include <string>
 #  include <vector>
 #  include <algorithm>
@@ -156,7 +157,7 @@ namespace chimp {
     typedef typename options::Properties Properties;
 
     /** Set of interactions equations that share the same inputs. */
-    typedef interaction::Set<options> Set;
+    typedef typename options::InteractionSet Set;
 
     /** Cross section Base type. */
     typedef interaction::cross_section::Base<options> CrossSection;
@@ -184,6 +185,15 @@ namespace chimp {
       xylose::SymmetryFix
     > InteractionTable;
 
+    /** Data type for the table of interactions with three inputs.  The sets
+     * are indexed by their sorted input multiset (interaction::Input, with
+     * A <= B <= C), and only the inputs that have interactions are stored.
+     * */
+    typedef std::map<
+      interaction::Input,
+      Set
+    > TernaryInteractionTable;
+
     /** Vector type used to store all loaded particle properties. */
     typedef std::vector<Properties> PropertiesVector;
 
@@ -226,12 +236,42 @@ namespace chimp {
     double default_ElasticCreator_vmax;
 
     /** Specifies the resolution withwhich to sum the diameters of the
-     * auto-combined non vhs-vhs cross section pairs.  IF <=0, dv will be chosen
-     * to give 100 data points.  
+     * auto-combined non vhs-vhs cross section pairs.  IF <=0, the table is
+     * built by adaptive refinement to within default_ElasticCreator_tolerance.
      * [Default: 0]
      */
     double default_ElasticCreator_dv;
 
+    /** Specifies the relative tolerance of the adaptively built tables of the
+     * auto-combined non vhs-vhs cross section pairs (used when dv <= 0).
+     * [Default: 1e-3]
+     */
+    double default_ElasticCreator_tolerance;
+
+    /** Specifies the maximum relative kinetic energy to which the cross
+     * sections are tabulated by interaction::PreComputedSet.  Interactions at
+     * higher energies are computed at runtime.  This has no effect when the
+     * default interaction::Set is used.
+     * [Default: 100 eV]
+     */
+    double default_PreComputedSet_Emax;
+
+    /** Specifies the number of bins withwhich interaction::PreComputedSet
+     * tabulates the cross sections.  This has no effect when the default
+     * interaction::Set is used.
+     * [Default: 1000]
+     */
+    unsigned int default_PreComputedSet_nbins;
+
+    /** Specifies the maximum relative kinetic energy over which
+     * interaction::Set searches for the exact maximum of the sum of
+     * sigma*v_rel of its equations (see interaction::Set::tabulateMaxSigmaV).
+     * Beyond this energy, Set::findMaxSigmaVProduct returns the sum of the
+     * maxima of each equation instead.
+     * [Default: 1000 eV]
+     */
+    double default_Set_maxSigmaV_Emax;
+
   private:
     /** Vector of particle properties.
      * Note that the order of the entries in the properties vector is NOT well
@@ -241,6 +281,9 @@ namespace chimp {
     /** Initialized at time of initBinaryInteractions() call. */
     InteractionTable interactions;
 
+    /** Initialized at time of initTernaryInteractions() call. */
+    TernaryInteractionTable ternary_interactions;
+
 
 
 
@@ -299,6 +342,11 @@ namespace chimp {
     /** Read-only access to the interactions matrix. */
     const InteractionTable & getInteractions() const { return interactions; }
 
+    /** Read-only access to the table of interactions with three inputs. */
+    const TernaryInteractionTable & getTernaryInteractions() const {
+      return ternary_interactions;
+    }
+
     /** return the set of single-species properties for the given species.
      * @see Note for getProps() concerning ill-determined order of properties
      * vector.
@@ -329,6 +377,13 @@ namespace chimp {
     /** return the set of cross-species properties for the two given species. */
     inline Set & operator()(const std::string & i, const std::string & j);
 
+    /** return the set of interactions of the three given species (in any
+     * order).  An empty set is returned if there are no such interactions.
+     * */
+    inline const Set & operator()(const int & i,
+                                  const int & j,
+                                  const int & k) const;
+
 
     /** Get the (const) iterator of the particle species with the specified name.
      * @return Iterator of particle species or getProps().end() if not found.
@@ -356,6 +411,14 @@ namespace chimp {
     /** Set up the table for interactions with binary inputs. */
     void initBinaryInteractions();
 
+    /** Set up the table for interactions with three inputs.  Each of the
+     * interactions in the xml data set is visited once and indexed by its
+     * sorted inputs, such that the possible triples of species are not
+     * enumerated.  This must be called AFTER initBinaryInteractions() (which
+     * sorts the particle properties).
+     */
+    void initTernaryInteractions();
+
     /** Create the set of all interaction equations that match the left hand
      * side given the current set of load particles.
      *
@@ -367,6 +430,18 @@ namespace chimp {
     LHSRelatedInteractionCtx
     findAllLHSRelatedInteractionCtx( const std::string & xpath_extra = "" );
 
+    /** Create the sets of all interaction equations with three inputs, given
+     * the current set of loaded particles.  This is the three-body version of
+     * findAllLHSRelatedInteractionCtx, except that only the inputs that have
+     * interactions are returned.
+     *
+     * @param xpath_extra
+     *    An optional xpath query to limit the equations that are returned
+     *    (see findAllLHSRelatedInteractionCtx).
+     */
+    LHSRelatedInteractionCtx
+    findAllTernaryInteractionCtx( const std::string & xpath_extra = "" );
+
     /** Add in missing elastic cross-species cross sections, assuming that the
      * single-species cross section exists and is already loaded.
      *
@@ -380,8 +455,10 @@ namespace chimp {
      *   Range overwhich to sum non vhs-vhs cross-section pairs.
      *   @see default_ElasticCreator_vmax
      * @param dv
-     *   Resolution withwhich to sum non vhs-vhs cross-section pairs.
+     *   Resolution withwhich to sum non vhs-vhs cross-section pairs.  If <= 0,
+     *   the tables are built adaptively.
      *   @see default_ElasticCreator_dv
+     *   @see default_ElasticCreator_tolerance
      *
      * @return Number of elastic cross sections created.
      *
@@ -414,6 +491,11 @@ namespace chimp {
                                            const double & vmax = 0.0,
                                            const double & dv = 0.0 );
 
+  private:
+    /** xpath predicate (see findAllLHSRelatedInteractionCtx) that limits the
+     * equations to those with only the loaded particles as products. */
+    std::string getParticlesOutputFilter() const;
+
   };/* RuntimeDB */
 
 
@@ -0,0 +1,155 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Declaration of interaction::AdaptiveMaxSigmaVProduct class.
+ * */
+
+#ifndef chimp_interaction_AdaptiveMaxSigmaVProduct_h
+#define chimp_interaction_AdaptiveMaxSigmaVProduct_h
+
+#include <algorithm>
+
+namespace chimp {
+  namespace interaction {
+
+    /** Generator and updater of
+     * \f$ \left( \sigma_{\rm T} v_{\rm rel} \right)_{\rm max} \f$ that
+     * adapts a persistent value per cell and per pair of species to the
+     * relative speeds actually encountered.
+     *
+     * The value is initialized (as with DefaultMaxSigmaVProduct) from the
+     * maximum relative velocity provided by the CrossSpeciesInfo class, which
+     * is often a large over-estimate.  Each time that the driver reports the
+     * maximum of (sigma*v_rel) over the relative speeds of the pairs tested,
+     * the value is:
+     *   - raised immediately to safety times the observed value, if it is
+     *     lower than that;
+     *   - otherwise, at the end of each window of updates, moved towards
+     *     safety times the largest value observed during the window by the
+     *     fraction decay of the difference.
+     *
+     * The CrossSpeciesInfo class must provide storage for the state through
+     * <code>AdaptiveMaxSigmaVProduct::State & maxSigmaVState(A,B)</code>, in
+     * addition to the maxRelativeVelocity(A,B) function required by
+     * DefaultMaxSigmaVProduct.  A default constructed State is uninitialized.
+     */
+    struct AdaptiveMaxSigmaVProduct {
+      /* TYPEDEFS */
+      /** Per-cell, per-pair state of the adaptive maximum. */
+      struct State {
+        /** Current value of (sigma*v_rel)_max (zero if uninitialized). */
+        double m_s_v;
+
+        /** Largest value reported during the current window. */
+        double window_max;
+
+        /** Number of updates during the current window. */
+        unsigned int n_updates;
+
+        /** Constructor creates an uninitialized state. */
+        State() : m_s_v( 0.0 ), window_max( 0.0 ), n_updates( 0u ) { }
+      };
+
+
+      /* MEMBER STORAGE */
+      /** Number of updates over which the observed maximum is collected
+       * before the value is lowered. */
+      unsigned int window;
+
+      /** Factor applied to the observed maximum. */
+      double safety;
+
+      /** Fraction of the difference to the (safety times) observed maximum
+       * that is removed at the end of each window. */
+      double decay;
+
+
+      /* MEMBER FUNCTIONS */
+      /** Constructor. */
+      AdaptiveMaxSigmaVProduct( const unsigned int & window = 10u,
+                                const double & safety = 1.1,
+                                const double & decay = 0.5 )
+        : window( std::max( window, 1u ) ),
+          safety( std::max( safety, 1.0 ) ),
+          decay( std::min( std::max( decay, 0.0 ), 1.0 ) ) { }
+
+      /** Obtain the current value of
+       * \f$ \left( \sigma_{\rm T} v_{\rm rel} \right)_{\rm max} \f$,
+       * initializing it if necessary.
+       */
+      template < typename ChimpDBInteractionSet,
+                 typename CrossSpeciesInfo >
+      double get( const ChimpDBInteractionSet & eqset,
+                  CrossSpeciesInfo & info,
+                  const int & A,
+                  const int & B ) const {
+        State & state = info.maxSigmaVState(A,B);
+
+        if ( state.m_s_v <= 0.0 ) {
+          state = State();
+          state.m_s_v =
+            eqset.findMaxSigmaVProduct( info.maxRelativeVelocity(A,B) );
+        }
+
+        return state.m_s_v;
+      }
+
+      /** Update the value of
+       * \f$ \left( \sigma_{\rm T} v_{\rm rel} \right)_{\rm max} \f$,
+       * given the maximum (m_s_v) found over the relative speeds of the pairs
+       * tested by the driver.
+       */
+      template < typename ChimpDB,
+                 typename CrossSpeciesInfo >
+      void update( const ChimpDB & db,
+                   CrossSpeciesInfo & info,
+                   const int & A,
+                   const int & B,
+                   const double & m_s_v ) const {
+        State & state = info.maxSigmaVState(A,B);
+        const double target = safety * m_s_v;
+
+        /* upgrade immediately. */
+        if ( target > state.m_s_v )
+          state.m_s_v = target;
+
+        state.window_max = std::max( state.window_max, m_s_v );
+        if ( ++state.n_updates < window )
+          return;
+
+        /* downgrade at the end of the window, but never below the largest
+         * value observed during the window. */
+        const double floor = safety * state.window_max;
+        if ( floor < state.m_s_v )
+          state.m_s_v -= decay * ( state.m_s_v - floor );
+
+        state.window_max = 0.0;
+        state.n_updates = 0u;
+      }
+    };
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_AdaptiveMaxSigmaVProduct_h
@@ -24,8 +24,12 @@
 #ifndef chimp_interaction_Driver_h
 #define chimp_interaction_Driver_h
 
-#include <chimp/interaction/selectRandomPair.h>
+#include <chimp/interaction/Input.h>
+#include <chimp/interaction/Triple.h>
+#include <chimp/interaction/scheme/NTC.h>
+#include <chimp/interaction/selector/Random.h>
 #include <chimp/interaction/detail/DriverRetval.h>
+#include <chimp/property/mass.h>
 #include <chimp/accessors.h>
 
 #include <xylose/Vector.h>
@@ -34,6 +38,8 @@
 #include <xylose/compat/math.hpp>
 
 #include <iterator>
+#include <algorithm>
+#include <vector>
 #include <set>
 
 namespace chimp {
@@ -62,8 +68,9 @@ namespace chimp {
       }
 
       /** Updates the maximum value of 
-       * \f$ \left( \sigma_{\rm T} v_{\rm rel} \right)_{\rm max} \f$.
-       * This implemenation does nothing.
+       * \f$ \left( \sigma_{\rm T} v_{\rm rel} \right)_{\rm max} \f$,
+       * given the maximum (m_s_v) found over the relative speeds of the pairs
+       * tested by the driver.  This implemenation does nothing.
        */
       template < typename ChimpDB,
                  typename CrossSpeciesInfo >
@@ -74,8 +81,29 @@ namespace chimp {
                    const double & m_s_v ) const { }
     };
 
-    /** The default collision monitor does nothing. */
-    struct NullMonitor {
+    /** Base class of collision monitors with a no-op version of each of the
+     * hooks that the drivers call.  A Monitor given to Driver must provide
+     * all of the following (which a monitor derived from MonitorBase only
+     * needs to define if it uses them):
+     *   - interactions(db, pair, path, result_list):  called for each pair
+     *     tested, with path.first < 0 if the pair did not interact.
+     *   - interactions(db, triple, path, result_list):  the same for each
+     *     triple tested for a three-body interaction.
+     *   - pairtests(n):  called with the number of tests computed for each
+     *     pair of species of each cell.
+     *   - beginPairType(A, B) and endPairType(A, B):  called before and
+     *     after the pairs of species A and B of a cell are tested and
+     *     collided (used, e.g., for timing).
+     *   - merge(other):  combine the statistics of another monitor of the
+     *     same type into this one.  This is only used by ParallelDriver, to
+     *     merge the monitors of each chunk of cells (which also requires the
+     *     monitor to be default constructible).
+     *
+     * Since a member function of a derived class hides all of the overloads
+     * of the same name, a derived monitor that defines only one of the
+     * interactions overloads must add "using MonitorBase::interactions;".
+     */
+    struct MonitorBase {
       template < typename ChimpDB,
                  typename PIter,
                  typename BackInsertionSequence >
@@ -84,25 +112,153 @@ namespace chimp {
                          const std::pair<int,double> & path,
                          const BackInsertionSequence & result_list ) const { }
 
+      template < typename ChimpDB,
+                 typename PIter,
+                 typename BackInsertionSequence >
+      void interactions( const ChimpDB & db,
+                         const Triple<PIter> & triple,
+                         const std::pair<int,double> & path,
+                         const BackInsertionSequence & result_list ) const { }
+
       void pairtests( const double & number_of_pairtests ) const { }
+
+      void beginPairType( const unsigned int & A,
+                          const unsigned int & B ) const { }
+      void endPairType( const unsigned int & A,
+                        const unsigned int & B ) const { }
+
+      template < typename Monitor >
+      void merge( const Monitor & other ) const { }
     };
 
+    /** The default collision monitor does nothing. */
+    struct NullMonitor : MonitorBase { };
+
 
     /** Driver class for performing all interactions necessary for all the types
      * that are present.  If you are really interested in peak performance, you
      * will likely want to use this class as a template.  Your own version may
      * need to be tuned and molded to suit the rest of the mechanics of your
      * simulation software in order to get the best performance.
+     *
+     * See MonitorBase for the functions that Monitor must provide.
      */
     template < typename Monitor = NullMonitor,
-               typename MaxSigmaVProduct = DefaultMaxSigmaVProduct >
+               typename MaxSigmaVProduct = DefaultMaxSigmaVProduct,
+               typename Scheme = scheme::NTC,
+               typename PairSelector = selector::Random >
     struct Driver {
       /* TYPEDEFS */
-    private:
+    public:
       /** Information to start the collisions per pair type. */
       struct CollisionTestData {
         double number_tests;
         double m_s_v;
+        /** Maximum weight of the particles of either species. */
+        double max_weight;
+        /** Maximum of the square of the relative speed of the pairs tested
+         * (as recorded by the Scheme), or zero if none were recorded. */
+        double max_v_rel2;
+      };
+
+      /** Persistent scratch storage of the driver.  A Workspace instance may
+       * be reused for any number of cells and timesteps such that the
+       * per-cell tables are only (re)allocated when the number of species
+       * changes.  A Workspace must not be shared by concurrent calls.
+       */
+      struct Workspace {
+        /* MEMBER STORAGE */
+        /** Collision test information per pair of species. */
+        xylose::upper_triangle<CollisionTestData> ctData;
+
+        /** Collision test information per set of interactions with three
+         * inputs (in the order of ChimpDB::getTernaryInteractions()). */
+        std::vector<CollisionTestData> triple_ctData;
+
+        /** Maximum speed of the particles of each species relative to the
+         * mean velocity of the cell (only computed for three-body
+         * interactions). */
+        std::vector<double> max_speed;
+
+        /** Number of species for which ctData is currently sized. */
+        unsigned int n_species;
+
+        /** Maximum particle weight of each species. */
+        std::vector<double> max_weight;
+
+        /** Time step of the last cell given to computeTests. */
+        double dt;
+
+        /** Estimated cost of the last cell given to computeTests, in units of
+         * the number of cross section evaluations.  ParallelDriver records
+         * this for each cell to balance the next call. */
+        double cost;
+
+        /** Indices of the particles of a batch of pairs (within the ranges of
+         * the two species) for schemes that process pairs in batches. */
+        std::vector<unsigned int> pair_a, pair_b;
+
+        /** Relative speeds of a batch of pairs. */
+        std::vector<double> v_rel;
+
+        /** Output paths of a batch of pairs. */
+        std::vector< std::pair<int,double> > paths;
+
+        /** Scratch space for the batch evaluation of cross sections. */
+        std::vector<double> scratch;
+
+        /** Indices of the particles (within the ranges of the two species) of
+         * the pairs of a batch whose collisions are deferred, with their
+         * output paths. */
+        std::vector<unsigned int> pending_a, pending_b;
+        std::vector< std::pair<int,double> > pending_paths;
+
+        /** Whether products were created for each of the deferred pairs. */
+        std::vector<char> created;
+
+        /** Flags of the particles of each species (by index into the range
+         * of the species) that were modified while processing a batch.  The
+         * flags are all cleared again at the end of each batch. */
+        std::vector< std::vector<char> > touched;
+
+        /** Flags of the particles of each species (by index into the range
+         * of the species) that are removed by in-place interactions.  These
+         * are only valid if n_removed is not zero for the species. */
+        std::vector< std::vector<char> > removed;
+
+        /** Number of particles of each species marked in removed. */
+        std::vector<unsigned int> n_removed;
+
+
+        /* MEMBER FUNCTIONS */
+        /** Constructor creates an empty workspace. */
+        Workspace() : n_species(0u), dt(0.0), cost(0.0) { }
+
+        /** Ensure that the tables are sized for n species. */
+        void resize( const unsigned int & n ) {
+          if ( n == n_species )
+            return;
+
+          ctData = xylose::upper_triangle<CollisionTestData>(n);
+          max_weight.resize(n);
+          removed.resize(n);
+          touched.resize(n);
+          n_removed.assign(n, 0u);
+          n_species = n;
+        }
+
+        /** Mark the particle i of species A (with n particles) as removed. */
+        void markRemoved( const unsigned int & A,
+                          const unsigned int & i,
+                          const unsigned int & n ) {
+          if ( n_removed[A] == 0u )
+            removed[A].assign( n, 0 );
+
+          if ( !removed[A][i] ) {
+            removed[A][i] = 1;
+            ++n_removed[A];
+          }
+        }
       };
 
 
@@ -110,6 +266,16 @@ namespace chimp {
     public:
       Monitor & monitor;
 
+      /** Generator and updater of the maximum of (sigma*v_rel). */
+      MaxSigmaVProduct maxSigmaVProduct;
+
+      /** The scheme used to select and test the pairs of each pair of
+       * species. */
+      Scheme test_scheme;
+
+      /** The selector of collision partners used by the scheme. */
+      PairSelector pair_selector;
+
 
       /* STATIC STORAGE */
     public:
@@ -118,9 +284,14 @@ namespace chimp {
 
       /* MEMBER FUNCTIONS */
     public:
-      /** Constructor initializes the collisions monitor.  */
-      Driver( Monitor & monitor = Driver::global_monitor )
-        : monitor( monitor ) { }
+      /** Constructor initializes the collisions monitor, the
+       * MaxSigmaVProduct policy, the scheme, and the pair selector.  */
+      Driver( Monitor & monitor = Driver::global_monitor,
+              const MaxSigmaVProduct & maxSigmaVProduct = MaxSigmaVProduct(),
+              const Scheme & test_scheme = Scheme(),
+              const PairSelector & pair_selector = PairSelector() )
+        : monitor( monitor ), maxSigmaVProduct( maxSigmaVProduct ),
+          test_scheme( test_scheme ), pair_selector( pair_selector ) { }
 
       /** Collision driver interface that MUST ONLY be used with
        * ChimpDB::inplace_interactions == false.
@@ -154,54 +325,124 @@ namespace chimp {
                         BackInsertionSequence & result_list,
                         ErasureQueue & eq,
                         RNG & rng ) {
+        Workspace ws;
+        this->operator() ( dt, cell, db, result_list, eq, rng, ws );
+      }
 
-        typedef typename CellInfo::SpeciesRange SpeciesRange;
-        typedef typename SpeciesRange::iterator PIter;
-        MaxSigmaVProduct maxSigmaVProduct;
+      /** Collision driver interface that uses (and reuses) the scratch storage
+       * of the given Workspace instead of allocating it for this cell.
+       * In the case that ChimpDB::inplace_interactions == false, the type and
+       * value of ErasureQueue is ignored.
+       */
+      template < typename CellInfo,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename ErasureQueue,
+                 typename RNG >
+      void operator() ( const double & dt,
+                        CellInfo & cell,
+                        const ChimpDB & db,
+                        BackInsertionSequence & result_list,
+                        ErasureQueue & eq,
+                        RNG & rng,
+                        Workspace & ws ) {
+        computeTests( dt, cell, db, rng, ws );
+        performTests( cell, db, result_list, eq, rng, ws );
+      }/* operator() */
 
+      /** Collision driver interface for a range of cells that MUST ONLY be
+       * used with ChimpDB::inplace_interactions == false.  The cells are
+       * processed in order, reusing the given Workspace.
+       *
+       * @param first
+       *    Iterator to the first cell (dereferences to a CellInfo instance).
+       * @param last
+       *    Iterator to one past the last cell.
+       */
+      template < typename CellIterator,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      void processCells( const double & dt,
+                         CellIterator first,
+                         const CellIterator & last,
+                         const ChimpDB & db,
+                         BackInsertionSequence & result_list,
+                         RNG & rng,
+                         Workspace & ws ) {
+        bool dummy = false;
+        processCells( dt, first, last, db, result_list, dummy, rng, ws );
+      }
+
+      /** Collision driver interface for a range of cells that can be used with
+       * any value of ChimpDB::inplace_interactions.  The cells are processed
+       * in order, reusing the given Workspace.
+       */
+      template < typename CellIterator,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename ErasureQueue,
+                 typename RNG >
+      void processCells( const double & dt,
+                         CellIterator first,
+                         const CellIterator & last,
+                         const ChimpDB & db,
+                         BackInsertionSequence & result_list,
+                         ErasureQueue & eq,
+                         RNG & rng,
+                         Workspace & ws ) {
+        for ( ; first != last; ++first )
+          this->operator() ( dt, *first, db, result_list, eq, rng, ws );
+      }
 
+      /** Calculate the number of collisions to test for each pair of species
+       * of the cell and store them in ws.ctData, as well as those of the
+       * interactions with three inputs (see computeTripleTests).  The
+       * estimated cost of the cell (see estimateCost) is stored in ws.cost.
+       * This is the first pass of operator().
+       */
+      template < typename CellInfo,
+                 typename ChimpDB,
+                 typename RNG >
+      void computeTests( const double & dt,
+                         CellInfo & cell,
+                         const ChimpDB & db,
+                         RNG & rng,
+                         Workspace & ws ) {
         const unsigned int n_species =
           std::min( cell.getNumberOfSpecies(), db.getProps().size() );
 
-        xylose::upper_triangle<CollisionTestData> ctData(n_species);
+        ws.resize( n_species );
+        ws.dt = dt;
+        ws.cost = 1.0;
+        xylose::upper_triangle<CollisionTestData> & ctData = ws.ctData;
+
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
+          ws.max_weight[A] = maxWeight( cell.getSpecies(A) );
+          ws.n_removed[A] = 0u;
+        }
 
         /* before we modify any ranges, calculate the estimate for the number of
          * collisions to test. */
         for ( unsigned int A = 0u; A < n_species; ++A ) {
-          SpeciesRange & aRange = cell.getSpecies(A);
           for ( unsigned int B = A; B < n_species; ++B ) {
-            SpeciesRange & bRange = cell.getSpecies(B);
-
             CollisionTestData & ctd = ctData(A,B);
             const typename ChimpDB::Set & eqset = db(A,B);
 
+            ctd.number_tests = 0.0;
+            ctd.m_s_v = 0.0;
+            ctd.max_v_rel2 = 0.0;
+            ctd.max_weight = std::max( ws.max_weight[A], ws.max_weight[B] );
+
             if (eqset.rhs.size() == 0)
               /* no interactions for these inputs. */
               continue;
 
             ctd.m_s_v = maxSigmaVProduct.get( eqset, cell, A,B );
 
-            /* Start by determining the number of collisions to use.
-             * N_test = Fa Fb Na Nb dt MAX(s v) / ( 2 V min(Fa,Fb) )
-             */
-            {/* FIXME:  support variable weights per particles.
-              * Implement Schmidt and Rutlands variable weight NTC. */
-              using chimp::accessors::particle::weight;
-              register double wA = weight(*aRange.begin()),
-                              wB = weight(*bRange.begin());
-
-              ctd.number_tests =
-                 wA * wB * aRange.size() * bRange.size() * dt * ctd.m_s_v
-                / ( cell.volume() * std::min( wA, wB ) )
-              ;
-
-              if ( A == B )
-                /* For identical species, we have to divide by two because of
-                 * symmetry in the summation of number of collisions.  See
-                 * Schmidt and Rutland, J. Comp. Phys. 164, 62-80, 2000.
-                 */
-                ctd.number_tests *= 0.5;
-            }
+            ctd.number_tests = expectedTests( dt, cell, A, B, ctd.m_s_v,
+                                              ctd.max_weight );
+            ws.cost += ctd.number_tests * eqset.rhs.size();
 
             {/* Promote the remaining selection probablity to either 0 or 1 */
               register double number_of__fraction =
@@ -215,14 +456,91 @@ namespace chimp {
           }/* for */
         }/* for */
 
+        computeTripleTests( dt, cell, db, rng, ws );
+      }/* computeTests */
 
-        /* Now that we are done calculating estimates for number of collisions
-         * to test, we are ready to select pairs, test then, and allow them to
-         * collide... */
+      /** Calculate the number of three-body collisions to test for each set
+       * of interactions with three inputs (see
+       * RuntimeDB::getTernaryInteractions) and store them in
+       * ws.triple_ctData.  The maximum of (sigma*v_rel) of each set is found
+       * from an upper bound of the relative kinetic energy of the triples
+       * of the cell (see tripleMaxSigmaV).  This is part of computeTests.
+       */
+      template < typename CellInfo,
+                 typename ChimpDB,
+                 typename RNG >
+      void computeTripleTests( const double & dt,
+                               CellInfo & cell,
+                               const ChimpDB & db,
+                               RNG & rng,
+                               Workspace & ws ) {
+        typedef typename ChimpDB::TernaryInteractionTable Table;
+        const Table & table = db.getTernaryInteractions();
+
+        ws.triple_ctData.resize( table.size() );
+        if ( table.empty() )
+          return;
+
+        maxSpeeds( cell, ws.n_species, ws.max_speed );
+
+        unsigned int t = 0u;
+        for ( typename Table::const_iterator i = table.begin(),
+                                           end = table.end();
+                                             i != end; ++i, ++t ) {
+          CollisionTestData & ctd = ws.triple_ctData[t];
+          const Input & in = i->first;
+          const typename ChimpDB::Set & eqset = i->second;
+
+          ctd.number_tests = 0.0;
+          ctd.m_s_v = 0.0;
+          ctd.max_v_rel2 = 0.0;
+          ctd.max_weight = 0.0;
+
+          if ( static_cast<unsigned int>(in.C.species) >= ws.n_species ||
+               eqset.rhs.empty() )
+            /* species not in this cell or no interactions. */
+            continue;
+
+          ctd.max_weight = std::max( ws.max_weight[in.A.species],
+                           std::max( ws.max_weight[in.B.species],
+                                     ws.max_weight[in.C.species] ) );
+          ctd.m_s_v = tripleMaxSigmaV( eqset, db, ws.max_speed );
+          ctd.number_tests = expectedTripleTests( dt, cell, in, ctd.m_s_v,
+                                                  ctd.max_weight );
+          ws.cost += ctd.number_tests * eqset.rhs.size();
+
+          {/* Promote the remaining selection probablity to either 0 or 1 */
+            register double number_of__fraction =
+              ctd.number_tests - std::floor(ctd.number_tests);
+
+            if ( rng.rand() < number_of__fraction )
+              ctd.number_tests += 1.0;
+          }
+        }
+      }
 
-        for ( unsigned int A = 0u; A < n_species; ++A ) {
-          SpeciesRange & aRange = cell.getSpecies(A);
+      /** Estimate the cost of processing the given cell, in units of the
+       * number of cross section evaluations.  This performs the same
+       * calculation of the number of tests as computeTests, but without
+       * promoting the fractional number of tests (and thus without using a
+       * random number generator).  ParallelDriver uses this estimate to
+       * balance the work of the threads only if it has not recorded the cost
+       * exported by computeTests (Workspace::cost) for the cells.
+       */
+      template < typename CellInfo,
+                 typename ChimpDB >
+      double estimateCost( const double & dt,
+                           CellInfo & cell,
+                           const ChimpDB & db ) const {
+        const unsigned int n_species =
+          std::min( cell.getNumberOfSpecies(), db.getProps().size() );
 
+        std::vector<double> max_weight( n_species );
+        for ( unsigned int A = 0u; A < n_species; ++A )
+          max_weight[A] = maxWeight( cell.getSpecies(A) );
+
+        double cost = 1.0;
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
           for ( unsigned int B = A; B < n_species; ++B ) {
             const typename ChimpDB::Set & eqset = db(A,B);
 
@@ -230,50 +548,458 @@ namespace chimp {
               /* no interactions for these inputs. */
               continue;
 
-            SpeciesRange & bRange = cell.getSpecies(B);
-            CollisionTestData & ctd = ctData(A,B);
+            cost += expectedTests( dt, cell, A, B,
+                                   maxSigmaVProduct.get( eqset, cell, A,B ),
+                                   std::max( max_weight[A], max_weight[B] ) )
+                  * eqset.rhs.size();
+          }
+        }
+
+        typedef typename ChimpDB::TernaryInteractionTable Table;
+        const Table & table = db.getTernaryInteractions();
+        if ( table.empty() )
+          return cost;
+
+        std::vector<double> max_speed;
+        maxSpeeds( cell, n_species, max_speed );
+
+        for ( typename Table::const_iterator i = table.begin(),
+                                           end = table.end();
+                                             i != end; ++i ) {
+          const Input & in = i->first;
+          const typename ChimpDB::Set & eqset = i->second;
+
+          if ( static_cast<unsigned int>(in.C.species) >= n_species ||
+               eqset.rhs.empty() )
+            continue;
+
+          cost += expectedTripleTests(
+                    dt, cell, in, tripleMaxSigmaV( eqset, db, max_speed ),
+                    std::max( max_weight[in.A.species],
+                    std::max( max_weight[in.B.species],
+                              max_weight[in.C.species] ) ) )
+                * eqset.rhs.size();
+        }
+
+        return cost;
+      }
 
-            while ( ctd.number_tests > 1.0 ) {
-              typedef std::pair<PIter, PIter> CollisionPair;
-
-              if ((A == B && aRange.size() < 2) ||
-                  (aRange.size() == 0u || bRange.size() == 0u)) {
-                /* not enough particles? */
-                using xylose::logger::log_warning;
-                log_warning( "Not enough particles to "
-                             "select collision pair %d:%d", A, B );
-                break;
-              }
-
-              using chimp::interaction::selectRandomPair;
-              CollisionPair pair = selectRandomPair( aRange, bRange, rng );
-
-              // Picks the correct output equation and uses it...
-              const size_t result_list_sz_i = result_list.size();
-              std::pair<int,double>
-                path = eqset.interact( ctd.m_s_v, pair, result_list, rng );
-
-              monitor.interactions( db, pair, path, result_list );
-
-              /* we work with A completely and then B so that if A == B things
-               * work still. */
-              detail::DriverRetval< ChimpDB::options::inplace_interactions >()(
-                path, pair,
-                result_list, result_list_sz_i, eq,
-                A, B, aRange, bRange
-              );
+      /** Determine the (fractional) number of collisions to test for species
+       * A and B, where the particles may have different weights.
+       * N_test = MAX(F) Na Nb dt MAX(s v) / ( 2 V )
+       *
+       * Each pair tested is accepted with probability
+       * (s v) / MAX(s v) * max(Fa,Fb) / MAX(F), where MAX(F) is the maximum
+       * weight of the particles of either species (see
+       * scheme::NTC::acceptWeights).  The particle of the smaller weight of
+       * an accepted pair always interacts, while only the fraction
+       * min(Fa,Fb)/max(Fa,Fb) of the other particle interacts (see
+       * model::detail::splitWeights, or model::detail::unsplitHeavy for the
+       * elastic models if options::split_weights is false).  For particles of equal weight F, this
+       * reduces to the usual N_test = F Na Nb dt MAX(s v) / ( 2 V ).
+       * See Schmidt and Rutland, J. Comp. Phys. 164, 62-80, 2000.
+       *
+       * @param max_weight
+       *    Maximum weight of the particles of species A and B.
+       */
+      template < typename CellInfo >
+      static double expectedTests( const double & dt,
+                                   CellInfo & cell,
+                                   const unsigned int & A,
+                                   const unsigned int & B,
+                                   const double & m_s_v,
+                                   const double & max_weight ) {
+        typedef typename CellInfo::SpeciesRange SpeciesRange;
+        SpeciesRange & aRange = cell.getSpecies(A);
+        SpeciesRange & bRange = cell.getSpecies(B);
+
+        if ( aRange.size() == 0u || bRange.size() == 0u )
+          return 0.0;
+
+        double number_tests =
+           max_weight * aRange.size() * bRange.size() * dt * m_s_v
+          / cell.volume()
+        ;
+
+        if ( A == B )
+          /* For identical species, we have to divide by two because of
+           * symmetry in the summation of number of collisions.  See
+           * Schmidt and Rutland, J. Comp. Phys. 164, 62-80, 2000.
+           */
+          number_tests *= 0.5;
+
+        return number_tests;
+      }
+
+      /** Determine the (fractional) number of collisions to test for species
+       * A and B, finding the maximum weight of the particles of both
+       * species.
+       */
+      template < typename CellInfo >
+      static double expectedTests( const double & dt,
+                                   CellInfo & cell,
+                                   const unsigned int & A,
+                                   const unsigned int & B,
+                                   const double & m_s_v ) {
+        return expectedTests( dt, cell, A, B, m_s_v,
+                              std::max( maxWeight( cell.getSpecies(A) ),
+                                        maxWeight( cell.getSpecies(B) ) ) );
+      }
+
+      /** The maximum weight of the particles in the given range (0 for an
+       * empty range). */
+      template < typename SpeciesRange >
+      static double maxWeight( SpeciesRange & range ) {
+        using chimp::accessors::particle::weight;
+
+        double w = 0.0;
+        for ( typename SpeciesRange::iterator i = range.begin(),
+                                            end = range.end();
+                                            i != end; ++i )
+          w = std::max( w, static_cast<double>( weight(*i) ) );
+
+        return w;
+      }
 
-              /* one down, ... more to go. */
-              ctd.number_tests -= 1.0;
-            }/* while doing colllision tests */
+      /** Determine the (fractional) number of three-body collisions to test
+       * for the species of the given Input (A <= B <= C).
+       * N_test = MAX(F)^2 N_triples dt MAX(s v) / V^2
+       *
+       * where s v is the three-body rate coefficient (see Equation::cs), and
+       * N_triples is the number of distinct triples, such as Na Nb Nc for
+       * three different species or Na (Na-1) (Na-2) / 6 for three identical
+       * species.  The number of tests is thus proportional to the square of
+       * the density (rather than to the density, as for pairs).  Each triple
+       * tested is accepted with probability
+       * (s v) / MAX(s v) * Fmid Fmax / MAX(F)^2 (see acceptTripleWeights),
+       * where Fmid and Fmax are the two larger weights of the triple, since
+       * only the smallest weight of the triple interacts.
+       *
+       * @param max_weight
+       *    Maximum weight of the particles of the three species.
+       */
+      template < typename CellInfo >
+      static double expectedTripleTests( const double & dt,
+                                         CellInfo & cell,
+                                         const Input & in,
+                                         const double & m_s_v,
+                                         const double & max_weight ) {
+        typedef typename CellInfo::SpeciesRange SpeciesRange;
+        SpeciesRange & aRange = cell.getSpecies(in.A.species);
+        SpeciesRange & bRange = cell.getSpecies(in.B.species);
+        SpeciesRange & cRange = cell.getSpecies(in.C.species);
+
+        if ( aRange.size() == 0u || bRange.size() == 0u || cRange.size() == 0u )
+          return 0.0;
+
+        /* the number of distinct triples. */
+        const double nA = aRange.size(), nB = bRange.size(),
+                     nC = cRange.size();
+        double n_triples = nA * nB * nC;
+        if ( in.A.species == in.C.species )
+          n_triples = nA * ( nA - 1.0 ) * ( nA - 2.0 ) / 6.0;
+        else if ( in.A.species == in.B.species )
+          n_triples = nA * ( nA - 1.0 ) * 0.5 * nC;
+        else if ( in.B.species == in.C.species )
+          n_triples = nA * nB * ( nB - 1.0 ) * 0.5;
+
+        const double V = cell.volume();
+        return std::max( 0.0, max_weight * max_weight * n_triples * dt * m_s_v
+                              / ( V * V ) );
+      }
+
+      /** Upper bound of (sigma*v_rel) of the given set of interactions with
+       * three inputs over all the triples of the cell, given the maximum
+       * speed r of each species relative to a common velocity (see
+       * maxSpeeds).  The kinetic energy of a triple in its center of mass
+       * frame is not more than 0.5 * (mA rA^2 + mB rB^2 + mC rC^2), and thus
+       * the effective relative speed (see tripleSpeed) of the triples is
+       * bounded.  This is the three-body majorant used instead of
+       * MaxSigmaVProduct.
+       */
+      template < typename Set,
+                 typename ChimpDB >
+      static double tripleMaxSigmaV( const Set & eqset,
+                                     const ChimpDB & db,
+                                     const std::vector<double> & max_speed ) {
+        using xylose::SQR;
+        using property::mass;
+
+        const Input & in = eqset.lhs;
+        const double mv2 =
+            db[in.A.species].mass::value * SQR( max_speed[in.A.species] )
+          + db[in.B.species].mass::value * SQR( max_speed[in.B.species] )
+          + db[in.C.species].mass::value * SQR( max_speed[in.C.species] );
+
+        return eqset.findMaxSigmaVProduct(
+          std::sqrt( mv2 / eqset.rhs.front().reducedMass.value )
+        );
+      }
+
+      /** The maximum speed of the particles of each species relative to the
+       * mean velocity of the particles of the cell. */
+      template < typename CellInfo >
+      static void maxSpeeds( CellInfo & cell,
+                             const unsigned int & n_species,
+                             std::vector<double> & max_speed ) {
+        typedef typename CellInfo::SpeciesRange SpeciesRange;
+        typedef typename SpeciesRange::iterator PIter;
+        using chimp::accessors::particle::velocity;
+
+        xylose::Vector<double,3> u = 0.0;
+        unsigned int n = 0u;
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
+          SpeciesRange & range = cell.getSpecies(A);
+          for ( PIter i = range.begin(), end = range.end(); i != end; ++i ) {
+            u += velocity(*i);
+            ++n;
+          }
+        }
+
+        if ( n > 0u )
+          u /= double(n);
+
+        max_speed.assign( n_species, 0.0 );
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
+          SpeciesRange & range = cell.getSpecies(A);
+          for ( PIter i = range.begin(), end = range.end(); i != end; ++i )
+            max_speed[A] = std::max( max_speed[A], (velocity(*i) - u).abs() );
+        }
+      }
+
+      /** Accept the given triple with probability Fmid Fmax / max_weight^2,
+       * where Fmid and Fmax are the two larger weights of the triple.  No
+       * random number is used if both equal max_weight, such as when all
+       * particles have the same weight. */
+      template < typename PIter, typename RNG >
+      static bool acceptTripleWeights( const Triple<PIter> & triple,
+                                       const double & max_weight,
+                                       RNG & rng ) {
+        using chimp::accessors::particle::weight;
+        const double w1 = weight(*triple.first);
+        const double w2 = weight(*triple.second);
+        const double w3 = weight(*triple.third);
+
+        /* product of the two larger weights. */
+        const double w = std::max( w1 * w2, std::max( w1 * w3, w2 * w3 ) );
+        const double max_w2 = max_weight * max_weight;
+        return w >= max_w2 || rng.rand() * max_w2 < w;
+      }
+
+      /** Select pairs, test them and allow them to collide, according to the
+       * number of tests stored in ws.ctData by computeTests.  The pairs of
+       * each pair of species are handled by the Scheme.  Finally, the
+       * maximum of (sigma*v_rel) over the relative speeds of the pairs tested
+       * is reported to MaxSigmaVProduct::update.  The triples of the
+       * interactions with three inputs are tested after all pairs (see
+       * performTripleTests).  For in-place interactions, the particles
+       * removed during the pass are compacted out of the species ranges at
+       * the end (see detail::DriverRetval).  This is the second pass of
+       * operator().
+       */
+      template < typename CellInfo,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename ErasureQueue,
+                 typename RNG >
+      void performTests( CellInfo & cell,
+                         const ChimpDB & db,
+                         BackInsertionSequence & result_list,
+                         ErasureQueue & eq,
+                         RNG & rng,
+                         Workspace & ws ) {
+        const unsigned int n_species = ws.n_species;
+
+        /* Now that we are done calculating estimates for number of collisions
+         * to test, we are ready to select pairs, test then, and allow them to
+         * collide... */
+
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
+          for ( unsigned int B = A; B < n_species; ++B ) {
+            if (db(A,B).rhs.size() == 0)
+              /* no interactions for these inputs. */
+              continue;
+
+            monitor.beginPairType( A, B );
+            pair_selector.prepare( cell, A, B );
+            test_scheme( *this, A, B, cell, db, result_list, eq, rng, ws );
+            monitor.endPairType( A, B );
+
+            const CollisionTestData & ctd = ws.ctData(A,B);
+            if ( ctd.max_v_rel2 > 0.0 )
+              maxSigmaVProduct.update(
+                db, cell, A, B,
+                db(A,B).findMaxSigmaVProduct( std::sqrt( ctd.max_v_rel2 ) )
+              );
           }/* for */
         }/* for */
-      }/* operator() */
+
+        performTripleTests( cell, db, result_list, rng, ws );
+
+        detail::DriverRetval< ChimpDB::options::inplace_interactions >
+          ::compact( ws, cell, eq );
+      }/* performTests */
+
+      /** Select triples, test them and allow them to collide, according to
+       * the number of tests stored in ws.triple_ctData by
+       * computeTripleTests.  The triples are selected at random (with
+       * replacement, as by scheme::NTC) from the particles that have not
+       * been removed by in-place interactions during this pass over the
+       * cell.  As for the pairs, the number of tests of each set and the
+       * result of each triple tested are reported to the Monitor.  This is
+       * part of performTests.
+       */
+      template < typename CellInfo,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      void performTripleTests( CellInfo & cell,
+                               const ChimpDB & db,
+                               BackInsertionSequence & result_list,
+                               RNG & rng,
+                               Workspace & ws ) {
+        typedef typename ChimpDB::TernaryInteractionTable Table;
+        typedef typename CellInfo::SpeciesRange SpeciesRange;
+        typedef typename SpeciesRange::iterator PIter;
+        typedef detail::DriverRetval<
+          ChimpDB::options::inplace_interactions > Retval;
+        using property::mass;
+
+        const Table & table = db.getTernaryInteractions();
+
+        unsigned int t = 0u;
+        for ( typename Table::const_iterator i = table.begin(),
+                                           end = table.end();
+                                             i != end; ++i, ++t ) {
+          CollisionTestData & ctd = ws.triple_ctData[t];
+          monitor.pairtests( ctd.number_tests );
+          if ( !( ctd.number_tests > 1.0 ) )
+            continue;
+
+          const Input & in = i->first;
+          const typename ChimpDB::Set & eqset = i->second;
+          const unsigned int A = in.A.species,
+                             B = in.B.species,
+                             C = in.C.species;
+          SpeciesRange & aRange = cell.getSpecies(A);
+          SpeciesRange & bRange = cell.getSpecies(B);
+          SpeciesRange & cRange = cell.getSpecies(C);
+
+          const double mA = db[A].mass::value,
+                       mB = db[B].mass::value,
+                       mC = db[C].mass::value;
+          const double mu = eqset.rhs.front().reducedMass.value;
+
+          for ( ; ctd.number_tests > 1.0; ctd.number_tests -= 1.0 ) {
+            if ( !enoughParticles( in, aRange, bRange, cRange ) )
+              break;
+
+            Triple<PIter> triple;
+            if ( !selectTriple( db, A, B, C, aRange, bRange, cRange, rng, ws,
+                                triple ) ||
+                 !acceptTripleWeights( triple, ctd.max_weight, rng ) ) {
+              monitor.interactions( db, triple, std::make_pair(-1,0.0),
+                                    result_list );
+              continue;
+            }
+
+            const double v_rel =
+              tripleSpeed( *triple.first, *triple.second, *triple.third,
+                           mA, mB, mC, mu );
+            const std::pair<int,double> path =
+              eqset.calculateOutPath( ctd.m_s_v, v_rel, rng );
+            if ( path.first < 0 ) {
+              monitor.interactions( db, triple, path, result_list );
+              continue;
+            }
+
+            const std::size_t result_list_sz_i = result_list.size();
+            eqset.performInteraction( path, triple, result_list, rng );
+            monitor.interactions( db, triple, path, result_list );
+
+            if ( result_list.size() > result_list_sz_i ) {
+              /* the inputs are replaced by the products. */
+              Retval::markRemoved( ws, A, triple.first  - aRange.begin(),
+                                   aRange.size() );
+              Retval::markRemoved( ws, B, triple.second - bRange.begin(),
+                                   bRange.size() );
+              Retval::markRemoved( ws, C, triple.third  - cRange.begin(),
+                                   cRange.size() );
+            }
+          }
+        }
+      }
+
+      /** Select a triple of particles of species A, B, and C, drawing again
+       * if any particle was already removed by an in-place interaction
+       * during this pass over the cell (see scheme::NTC::selectPair).
+       *
+       * @return Whether a triple of particles that are not removed was
+       * selected.
+       */
+      template < typename ChimpDB,
+                 typename SpeciesRange,
+                 typename RNG,
+                 typename PIter >
+      static bool selectTriple( const ChimpDB & db,
+                                const unsigned int & A,
+                                const unsigned int & B,
+                                const unsigned int & C,
+                                SpeciesRange & aRange,
+                                SpeciesRange & bRange,
+                                SpeciesRange & cRange,
+                                RNG & rng,
+                                const Workspace & ws,
+                                Triple<PIter> & triple ) {
+        typedef detail::DriverRetval<
+          ChimpDB::options::inplace_interactions > Retval;
+        static const unsigned int max_removed_draws = 16u;
+
+        for ( unsigned int n = 0u; n < max_removed_draws; ++n ) {
+          triple = selectRandomTriple( aRange, bRange, cRange, rng );
+
+          if ( !Retval::removed( ws, A, triple.first  - aRange.begin() ) &&
+               !Retval::removed( ws, B, triple.second - bRange.begin() ) &&
+               !Retval::removed( ws, C, triple.third  - cRange.begin() ) )
+            return true;
+        }
+
+        return false;
+      }
+
+      /** Whether there are enough particles to select a triple for the given
+       * Input.  A warning is logged if not. */
+      template < typename SpeciesRange >
+      static bool enoughParticles( const Input & in,
+                                   const SpeciesRange & aRange,
+                                   const SpeciesRange & bRange,
+                                   const SpeciesRange & cRange ) {
+        const unsigned int nA = aRange.size(),
+                           nB = bRange.size(),
+                           nC = cRange.size();
+        const bool AB = in.A.species == in.B.species;
+        const bool BC = in.B.species == in.C.species;
+
+        if ( nA == 0u || nB == 0u || nC == 0u ||
+             ( AB && BC && nA < 3u ) ||
+             ( AB && !BC && nA < 2u ) ||
+             ( BC && !AB && nB < 2u ) ) {
+          /* not enough particles? */
+          using xylose::logger::log_warning;
+          log_warning( "Not enough particles to select collision triple "
+                       "%d:%d:%d", in.A.species, in.B.species, in.C.species );
+          return false;
+        }
+
+        return true;
+      }
     };
 
 
-    template < typename Monitor, typename MaxSigmaVProduct>
-    Monitor Driver<Monitor, MaxSigmaVProduct>::global_monitor;
+    template < typename Monitor, typename MaxSigmaVProduct, typename Scheme,
+               typename PairSelector >
+    Monitor
+    Driver<Monitor, MaxSigmaVProduct, Scheme, PairSelector>::global_monitor;
 
   }/* namespace chimp::interaction */
 }/* namespace chimp */
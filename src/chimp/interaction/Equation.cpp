@@ -73,20 +73,21 @@ namespace chimp {
 
       Equation retval;
 
-      /* FIXME:  allow nore than two inputs and store the input terms in a list,
-       * just as is done for the products. */
-      if (n_in != 2) {
-        throw xml::error("Only interactions with binary inputs currently supported");
+      /* The inputs are stored in the fixed terms A, B, C of Input rather than
+       * a list (see the note on Input). */
+      if (n_in != 2 && n_in != 3) {
+        throw xml::error(
+          "Only interactions with two or three inputs are supported" );
       }
 
       {
-        SEIter i = in.begin();
-        int n = i->second;
-
-        retval.A = Term(db.findParticleIndx( i->first->name::value ));
-        if ( !(--n) )
-          ++i;
-        retval.B = Term(db.findParticleIndx( i->first->name::value ));
+        /* one Term per input particle, in the order of the sorted terms. */
+        Term * t[3] = { &retval.A, &retval.B, &retval.C };
+        int k = 0;
+        for ( SEIter i = in.begin(), end = in.end(); i != end; ++i ) {
+          for ( int n = 0; n < i->second; ++n )
+            *t[k++] = Term(db.findParticleIndx( i->first->name::value ));
+        }
       }
 
       /* cache the reduced mass */
@@ -166,13 +167,18 @@ namespace chimp {
     inline bool Equation<options>::isElastic() const {
       std::set<Term> iterms, oterms;
 
-      if ( A.species == B.species )
-        iterms.insert( Term(A.species, 2) );
-      else {
-        iterms.insert(A);
-        iterms.insert(B);
+      {
+        const Term * t[3] = { &A, &B, &C };
+        const int n = isTernary() ? 3 : 2;
+        for ( int i = 0; i < n; ) {
+          int j = i + 1;
+          while ( j < n && t[j]->species == t[i]->species )
+            ++j;
+          iterms.insert( Term(t[i]->species, j - i) );
+          i = j;
+        }
       }
-      
+
       for ( TermList::const_iterator i = products.begin(),
                                   tend = products.end();
                                     i != tend; ++i )
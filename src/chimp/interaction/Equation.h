@@ -65,10 +65,15 @@ namespace chimp {
       /** The list of products resulting from this equation. */
       TermList products;
 
-      /** Reduced mass of the reactants of this equation. */
+      /** Reduced mass of the reactants of this equation.  For three-body
+       * equations, this is the reduced mass of the first two reactants (A and
+       * B), and the cross section is evaluated at the effective relative
+       * speed of the three reactants (see tripleSpeed). */
       ReducedMass reducedMass;
 
-      /** The cross_section::Base instance that this interaction provides.  */
+      /** The cross_section::Base instance that this interaction provides.
+       * For three-body equations, the cross section has units of m^5 such
+       * that sigma*v_rel is the three-body rate coefficient (m^6/s).  */
       shared_ptr< cross_section::Base<options> > cs;
 
       /** The interaction model used by this interaction. */
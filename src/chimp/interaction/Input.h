@@ -39,12 +39,16 @@
 namespace chimp {
   namespace interaction {
 
-    /* FIXME:  This class needs to be deleted and replaced by a TermList as is
-     * used for the Equation::products.  We'll get there in time... */
-
-    /** Input species information.
-     * \todo Allow inputs with more than two species.  This is going to be
-     * necessary such that three-body recombination equations will be possible. 
+    /* NOTE:  Unlike Equation::products, the inputs are not stored in a
+     * TermList.  An Input is the lhs of every Set and the key of the ternary
+     * interaction table, where it is compared on every lookup, so it is kept
+     * a small value type without heap storage.  No more than three inputs
+     * are supported, so a fixed third Term suffices. */
+
+    /** Input species information.  An Input has either two or three terms,
+     * one per input particle, in the order of increasing species index:
+     * A <= B <= C.  The term C is only valid for three-body (ternary) inputs
+     * (see isTernary).
      */
     struct Input {
       /* MEMBER STORAGE */
@@ -54,6 +58,10 @@ namespace chimp {
       /** The second Term of the Input portion of an Equation. */
       Term B;
 
+      /** The third Term of the Input portion of an Equation.  The species of
+       * this term is -1 for binary inputs. */
+      Term C;
+
 
 
       /* MEMBER FUNCTIONS */
@@ -61,8 +69,12 @@ namespace chimp {
        * The caller can optionally supply the terms and reduced mass explicitly.
        * */
       Input( const Term & A = Term(),
-             const Term & B = Term() )
-        : A(A), B(B) { }
+             const Term & B = Term(),
+             const Term & C = Term(-1, 0) )
+        : A(A), B(B), C(C) { }
+
+      /** Whether this Input has three terms. */
+      bool isTernary() const { return C.species >= 0; }
 
       /** The stream printer for the Equation Input class.
        * @param out
@@ -74,19 +86,25 @@ namespace chimp {
       std::ostream & print( std::ostream & out, const RnDB & db ) const {
         Term::printset ps;
 
-        if ( A.species == B.species )
-          ps.add( Term(A.species, 2), db );
-        else {
-          ps.add(A, db);
-          ps.add(B, db);
+        const Term * t[3] = { &A, &B, &C };
+        const unsigned int n = isTernary() ? 3u : 2u;
+        for ( unsigned int i = 0u; i < n; ) {
+          /* the terms are sorted, so equal species are adjacent. */
+          unsigned int j = i + 1u;
+          while ( j < n && t[j]->species == t[i]->species )
+            ++j;
+          ps.add( Term(t[i]->species, j - i), db );
+          i = j;
         }
         return ps.print(out, db);
       }
     };
 
-    /** Less than operation for interaction::Input orders by A and then by B. */
+    /** Less than operation for interaction::Input orders by A, then by B, and
+     * then by C. */
     inline bool operator< ( const Input & lhs, const Input & rhs ) {
-      return lhs.A < rhs.A || (lhs.A == rhs.A && lhs.B < rhs.B);
+      return lhs.A < rhs.A || (lhs.A == rhs.A &&
+               ( lhs.B < rhs.B || (lhs.B == rhs.B && lhs.C < rhs.C) ));
     }
 
   }/* namespace chimp::interaction */
@@ -0,0 +1,325 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Thread-parallel collision driver that processes chunks of cells
+ * concurrently.
+ * */
+
+#ifndef chimp_interaction_ParallelDriver_h
+#define chimp_interaction_ParallelDriver_h
+
+#include <chimp/interaction/Driver.h>
+
+#include <deque>
+#include <cstddef>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+namespace chimp {
+  namespace interaction {
+
+    /** Driver class that performs the interactions of a range of cells in
+     * parallel (via OpenMP, if enabled at compile time).  The cells are
+     * divided into chunks of at most chunk_size consecutive cells.  If
+     * load balancing is enabled, the chunks are formed such that each has
+     * approximately the same estimated cost, where a very expensive cell
+     * forms a chunk by itself.  The cost of each cell is the one exported by
+     * the first pass of the serial driver (Driver::Workspace::cost) during
+     * the previous call, which is recorded in cell_cost.  Only if no costs
+     * were recorded for the same number of cells (such as for the first
+     * call) are the costs computed by a separate estimation pass (see
+     * Driver::estimateCost).  The chunks are then
+     * started in the order of decreasing cost (heaviest first) and are
+     * dynamically handed to whichever thread becomes idle.  Each chunk is
+     * processed by a serial interaction::Driver with its own random number
+     * generator, product buffer, erasure queue, and monitor.  The random
+     * number generator of each chunk is seeded from the given master
+     * generator (in chunk order) before any chunk is processed, and the
+     * product buffers, erasure queues, and monitors are merged in chunk order
+     * afterwards.  The results are therefore independent of the number of
+     * threads and of the order in which the chunks are processed.
+     *
+     * Requirements beyond those of interaction::Driver:
+     *   - CellIterator must be a random access iterator.
+     *   - RNG must be default constructible, provide seed(unsigned int), and
+     *     provide randInt() to generate the seeds.
+     *   - BackInsertionSequence (and ErasureQueue) must be default
+     *     constructible, and default-constructed product sinks must be able
+     *     to grow (which excludes ProductSlab).
+     *   - BackInsertionSequence must provide begin() and end(), as well as
+     *     size() and reserve(n) of the product sink interface (see
+     *     ProductSink.h), which are used to merge the products of the
+     *     chunks into result_list.
+     *   - Monitor must be default constructible and provide
+     *     merge(const Monitor &) (see MonitorBase).
+     *   - The interaction models and cross sections of ChimpDB must be safe
+     *     to call concurrently (which is the case for the library-provided
+     *     types).
+     */
+    template < typename Monitor = NullMonitor,
+               typename MaxSigmaVProduct = DefaultMaxSigmaVProduct,
+               typename Scheme = scheme::NTC,
+               typename PairSelector = selector::Random >
+    struct ParallelDriver {
+      /* TYPEDEFS */
+    public:
+      /** The serial driver used for each chunk of cells. */
+      typedef interaction::Driver<Monitor, MaxSigmaVProduct, Scheme,
+                                  PairSelector> SerialDriver;
+
+
+      /* MEMBER STORAGE */
+    public:
+      /** Monitor into which the monitors of each chunk are merged. */
+      Monitor & monitor;
+
+      /** The MaxSigmaVProduct policy (copied to the driver of each chunk). */
+      MaxSigmaVProduct maxSigmaVProduct;
+
+      /** The scheme (copied to the driver of each chunk). */
+      Scheme test_scheme;
+
+      /** The pair selector (copied to the driver of each chunk). */
+      PairSelector pair_selector;
+
+      /** Maximum number of consecutive cells in each chunk. */
+      unsigned int chunk_size;
+
+      /** Whether to form and order the chunks according to the estimated
+       * cost of each cell. */
+      bool balance;
+
+      /** Number of chunks of equal cost to aim for when balancing.  This
+       * should be several times the number of threads:  more chunks give the
+       * dynamic scheduling more freedom at the expense of more overhead per
+       * chunk.  This does not depend on the number of threads such that the
+       * results do not either. */
+      unsigned int balanced_chunks;
+
+      /** Cost of each cell as exported by the first pass of the serial driver
+       * (see Driver::Workspace::cost) during the last call.  This is used to
+       * form the chunks of the next call if the number of cells is the same.
+       * clearCosts() should be called if the cells given to the next call are
+       * not the same cells. */
+      std::vector<double> cell_cost;
+
+
+      /* MEMBER FUNCTIONS */
+    public:
+      /** Constructor initializes the collisions monitor and the chunking. */
+      ParallelDriver( Monitor & monitor = SerialDriver::global_monitor,
+                      const unsigned int & chunk_size = 64u,
+                      const bool & balance = true,
+                      const unsigned int & balanced_chunks = 256u )
+        : monitor( monitor ), maxSigmaVProduct(), test_scheme(),
+          pair_selector(),
+          chunk_size( std::max(chunk_size, 1u) ),
+          balance( balance ),
+          balanced_chunks( std::max(balanced_chunks, 1u) ) { }
+
+      /** Parallel collision driver interface that MUST ONLY be used with
+       * ChimpDB::inplace_interactions == false.
+       */
+      template < typename CellIterator,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      void operator() ( const double & dt,
+                        const CellIterator & first,
+                        const CellIterator & last,
+                        const ChimpDB & db,
+                        BackInsertionSequence & result_list,
+                        RNG & rng ) {
+        bool dummy = false;
+        this->operator() ( dt, first, last, db, result_list, dummy, rng );
+      }
+
+      /** Parallel collision driver interface that can be used with any value
+       * of ChimpDB::inplace_interactions.  In the case that
+       * ChimpDB::inplace_interactions == false, the type and value of
+       * ErasureQueue is ignored.
+       */
+      template < typename CellIterator,
+                 typename ChimpDB,
+                 typename BackInsertionSequence,
+                 typename ErasureQueue,
+                 typename RNG >
+      void operator() ( const double & dt,
+                        const CellIterator & first,
+                        const CellIterator & last,
+                        const ChimpDB & db,
+                        BackInsertionSequence & result_list,
+                        ErasureQueue & eq,
+                        RNG & rng ) {
+        const int n_cells = std::distance( first, last );
+        if ( n_cells <= 0 )
+          return;
+
+        /* the first cell of each chunk (plus the end). */
+        std::vector<int> bounds;
+        /* the chunks in the order in which they are started. */
+        std::vector<int> order;
+        makeChunks( dt, first, n_cells, db, bounds, order );
+        const int n_chunks = bounds.size() - 1u;
+        cell_cost.resize( n_cells );
+
+        /* seed each of the chunks from the master generator. */
+        std::vector<unsigned int> seeds( n_chunks );
+        for ( int c = 0; c < n_chunks; ++c )
+          seeds[c] = rng.randInt();
+
+        std::vector<BackInsertionSequence> products( n_chunks );
+        std::deque<ErasureQueue> queues( n_chunks );
+        std::vector<Monitor> monitors( n_chunks );
+
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+          typename SerialDriver::Workspace ws;
+          RNG chunk_rng;
+
+#ifdef _OPENMP
+          #pragma omp for schedule(dynamic,1)
+#endif
+          for ( int k = 0; k < n_chunks; ++k ) {
+            const int c = order[k];
+            chunk_rng.seed( seeds[c] );
+            SerialDriver driver( monitors[c], maxSigmaVProduct, test_scheme,
+                                 pair_selector );
+            for ( int i = bounds[c]; i < bounds[c+1]; ++i ) {
+              driver( dt, *(first + i), db, products[c], queues[c], chunk_rng,
+                      ws );
+              cell_cost[i] = ws.cost;
+            }
+          }
+        }
+
+        /* merge the results in chunk order (reserve is required of every
+         * product sink, see ProductSink.h). */
+        std::size_t n_products = result_list.size();
+        for ( int c = 0; c < n_chunks; ++c )
+          n_products += products[c].size();
+        result_list.reserve( n_products );
+
+        for ( int c = 0; c < n_chunks; ++c ) {
+          std::copy( products[c].begin(), products[c].end(),
+                     std::back_inserter( result_list ) );
+          mergeQueue( eq, queues[c] );
+          monitor.merge( monitors[c] );
+        }
+      }
+
+      /** Forget the recorded costs of the cells such that the next call
+       * estimates them again. */
+      void clearCosts() {
+        cell_cost.clear();
+      }
+
+      /** Divide the cells into chunks.  If balancing, the recorded cost of
+       * each cell is used, or estimated if no cost is recorded for the same
+       * number of cells.
+       * @param bounds
+       *    [output] Index of the first cell of each chunk, followed by
+       *    n_cells.
+       * @param order
+       *    [output] Order in which the chunks should be started.
+       */
+      template < typename CellIterator,
+                 typename ChimpDB >
+      void makeChunks( const double & dt,
+                       const CellIterator & first,
+                       const int & n_cells,
+                       const ChimpDB & db,
+                       std::vector<int> & bounds,
+                       std::vector<int> & order ) {
+        bounds.clear();
+        order.clear();
+
+        if ( !balance ) {
+          for ( int i = 0; i < n_cells; i += chunk_size )
+            bounds.push_back( i );
+          bounds.push_back( n_cells );
+
+          for ( unsigned int c = 0u; c + 1u < bounds.size(); ++c )
+            order.push_back( c );
+          return;
+        }
+
+        std::vector<double> & cost = cell_cost;
+        if ( int(cost.size()) != n_cells ) {
+          /* no recorded costs:  estimate the cost of each cell. */
+          cost.resize( n_cells );
+          const SerialDriver
+            driver( monitor, maxSigmaVProduct, test_scheme );
+#ifdef _OPENMP
+          #pragma omp parallel for schedule(static)
+#endif
+          for ( int i = 0; i < n_cells; ++i )
+            cost[i] = driver.estimateCost( dt, *(first + i), db );
+        }
+
+        double total = 0.0;
+        for ( int i = 0; i < n_cells; ++i )
+          total += cost[i];
+
+        /* form chunks of consecutive cells with approximately equal cost. */
+        const double target = total / balanced_chunks;
+        std::vector< std::pair<double,int> > chunk_cost;
+        double sum = 0.0;
+        bounds.push_back( 0 );
+        for ( int i = 0; i < n_cells; ++i ) {
+          sum += cost[i];
+          if ( sum >= target || ( i + 1 - bounds.back() ) >= int(chunk_size) ||
+               i + 1 == n_cells ) {
+            /* negative cost such that sorting gives decreasing cost. */
+            chunk_cost.push_back( std::make_pair( -sum, int(bounds.size()) - 1 ) );
+            bounds.push_back( i + 1 );
+            sum = 0.0;
+          }
+        }
+
+        /* heaviest first.  Ties are started in the order of the cells. */
+        std::sort( chunk_cost.begin(), chunk_cost.end() );
+        order.resize( chunk_cost.size() );
+        for ( unsigned int k = 0u; k < chunk_cost.size(); ++k )
+          order[k] = chunk_cost[k].second;
+      }
+
+    private:
+      /** Merge the erasure queue of a chunk. */
+      template < typename ErasureQueue >
+      static void mergeQueue( ErasureQueue & eq, const ErasureQueue & q ) {
+        eq.insert( q.begin(), q.end() );
+      }
+
+      /** The erasure queue is ignored for out-of-place interactions. */
+      static void mergeQueue( bool & eq, const bool & q ) { }
+    };
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_ParallelDriver_h
@@ -0,0 +1,363 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Definition of the equation set that pre-computes cross sections and output
+ * path probabilities.
+ * */
+
+#ifndef chimp_interaction_PreComputedSet_h
+#define chimp_interaction_PreComputedSet_h
+
+#include <chimp/interaction/Set.h>
+#include <chimp/interaction/detail/alias_table.h>
+
+#include <xylose/logger.h>
+#include <xylose/compat/math.hpp>
+
+#include <vector>
+#include <algorithm>
+
+namespace chimp {
+  namespace interaction {
+
+    /** This set implementation pre-calculates the cross-sections and output
+     * path probabilities at a uniform grid of relative speeds and stores the
+     * associated lookup-table for later use.
+     *
+     * The table stores the products \f$ v \sigma_i(v) \f$ for each of the
+     * equations at each grid node.  For a relative speed that falls between two
+     * nodes, these products are linearly interpolated.  The output path is
+     * selected in O(1) time (independent of the number of equations) by first
+     * choosing one of the two neighboring nodes according to its interpolation
+     * weight and then sampling the Walker alias table of that node.  This
+     * samples the output paths exactly according to the interpolated cross
+     * sections.
+     *
+     * For relative speeds beyond the tabulated range, this set falls back to
+     * the runtime calculation of Set::calculateOutPath.
+     *
+     * To use this set for the RuntimeDB interaction table, use
+     * make_options<>::type::setInteractionSet<interaction::PreComputedSet>.
+     * The range and resolution of the table are then taken from
+     * RuntimeDB::default_PreComputedSet_Emax and
+     * RuntimeDB::default_PreComputedSet_nbins.
+     * */
+    template < typename options >
+    struct PreComputedSet : Set<options> {
+      /* TYPEDEFS */
+      typedef interaction::Set<options> super;
+      typedef typename super::Equation Equation;
+      typedef typename super::eq_list eq_list;
+      typedef typename super::OutPath OutPath;
+
+
+
+      /* MEMBER STORAGE */
+      /** Spacing of the velocity grid. */
+      double dv;
+
+      /** Inverse of the spacing of the velocity grid. */
+      double dv_inv;
+
+      /** Upper limit of the velocity grid. */
+      double v_max;
+
+      /** Number of bins of the velocity grid. */
+      unsigned int n_bins;
+
+      /** Number of equations tabulated (the size of rhs at the time of
+       * precompute).  If rhs changes size after precompute, the tables are
+       * ignored until precompute is called again. */
+      unsigned int n_eq;
+
+      /** Total of \f$ v \sigma_i(v) \f$ at each node. */
+      std::vector<double> sigma_v_total;
+
+      /** \f$ v \sigma_i(v) \f$ at each node.  The values for each node are
+       * stored contiguously (index = node * n_eq + i). */
+      std::vector<double> sigma_v;
+
+      /** Walker alias table acceptance probabilities for each node. */
+      std::vector<double> alias_prob;
+
+      /** Walker alias table alias indices for each node. */
+      std::vector<int> alias_index;
+
+      /** Running maximum of sigma_v_total from the first node up to the ith
+       * node. */
+      std::vector<double> max_sigma_v;
+
+
+
+      /* MEMBER FUNCTIONS */
+      /** Constructor.  A blank set of equations are created if constructor
+       * arguments are omitted.  The tables are not computed until precompute
+       * (or prepare) is called. */
+      PreComputedSet( const Input & lhs = Input(),
+                      const eq_list & rhs = eq_list() )
+        : super(lhs, rhs), dv(0.0), dv_inv(0.0), v_max(0.0),
+          n_bins(0u), n_eq(0u) { }
+
+      /** Compute the tables using the range and resolution specified by the
+       * RuntimeDB instance (RuntimeDB::default_PreComputedSet_Emax and
+       * RuntimeDB::default_PreComputedSet_nbins).  The relative kinetic energy
+       * is converted to relative speed using the reduced mass of the inputs of
+       * this set. */
+      template < typename RnDB >
+      void prepare( const RnDB & db ) {
+        super::prepare( db );
+
+        if ( this->rhs.empty() ) {
+          precompute( 0.0, 0u );
+          return;
+        }
+
+        precompute( std::sqrt( 2.0 * db.default_PreComputedSet_Emax
+                               / this->rhs.front().reducedMass.value ),
+                    db.default_PreComputedSet_nbins );
+      }
+
+      /** Compute the tables of cross sections and path probabilities.
+       * @param vmax
+       *    Upper limit of the velocity grid.
+       * @param nbins
+       *    Number of bins of the grid.  The number of grid nodes is nbins+1.
+       * */
+      void precompute( const double & vmax, const unsigned int & nbins ) {
+        n_eq = this->rhs.size();
+        sigma_v_total.clear();
+        sigma_v.clear();
+        alias_prob.clear();
+        alias_index.clear();
+        max_sigma_v.clear();
+
+        if ( n_eq == 0u || nbins == 0u || vmax <= 0.0 ) {
+          dv = dv_inv = v_max = 0.0;
+          n_bins = 0u;
+          return;
+        }
+
+        v_max = vmax;
+        n_bins = nbins;
+        dv = vmax / nbins;
+        dv_inv = nbins / vmax;
+
+        const unsigned int n_nodes = nbins + 1u;
+        sigma_v_total.resize( n_nodes );
+        sigma_v.resize( n_nodes * n_eq );
+        alias_prob.resize( n_nodes * n_eq );
+        alias_index.resize( n_nodes * n_eq );
+        max_sigma_v.resize( n_nodes );
+
+        double max_sv = 0.0;
+        for ( unsigned int k = 0u; k < n_nodes; ++k ) {
+          /* The first node is evaluated just above v=0 to avoid the
+           * singularity of models such as VHS at v=0. */
+          const double v = ( k == 0u ? 1e-6 * dv : k * dv );
+          double * row = &sigma_v[k * n_eq];
+
+          double total = 0.0;
+          for ( unsigned int i = 0u; i < n_eq; ++i ) {
+            row[i] = v * (*this->rhs[i].cs)(v);
+            total += row[i];
+          }
+
+          sigma_v_total[k] = total;
+          max_sv = std::max( max_sv, total );
+          max_sigma_v[k] = max_sv;
+
+          detail::buildAliasTable( row, n_eq,
+                                   &alias_prob[k * n_eq],
+                                   &alias_index[k * n_eq] );
+        }
+      }
+
+      /** Whether the tables are valid for the current set of equations. */
+      bool isPrecomputed() const {
+        return n_eq > 0u && n_eq == this->rhs.size();
+      }
+
+      /** Find the local maximum of cross-section*velocity (within a given
+       * range of velocity space).  Within the tabulated range, this is the
+       * exact maximum of the interpolated cross sections as used by
+       * calculateOutPath.  Beyond the tabulated range, this falls back to
+       * Set::findMaxSigmaVProduct.
+       * */
+      inline double findMaxSigmaVProduct(const double & v_rel_max) const {
+        const double x = v_rel_max * dv_inv;
+        if ( !isPrecomputed() || x >= n_bins )
+          return super::findMaxSigmaVProduct( v_rel_max );
+
+        const unsigned int k = static_cast<unsigned int>(x);
+        const double w = x - k;
+        const double sv = sigma_v_total[k]
+                        + w * ( sigma_v_total[k+1] - sigma_v_total[k] );
+        return std::max( max_sigma_v[k], sv );
+      }
+
+      /** Chooses an interaction path to traverse dependent on the incident
+       * relative speed and the current value of (sigma*relspeed)_max. 
+       *
+       * @return The index of the right-hand-side of the interaction
+       * equation is returned, unless no interaction can be performed.  In
+       * this latter case, a value of -1 will be returned.
+       * */
+      template < typename RNG >
+      std::pair<int,double>
+      calculateOutPath( const double & max_sigma_relspeed,
+                        const double & v_relative,
+                        RNG & rng ) const {
+        const double x = v_relative * dv_inv;
+        if ( !isPrecomputed() || x >= n_bins )
+          return super::calculateOutPath( max_sigma_relspeed, v_relative, rng );
+
+        const unsigned int k = static_cast<unsigned int>(x);
+        const double w = x - k;
+
+        const double sv0 = sigma_v_total[k];
+        const double sv1 = sigma_v_total[k+1];
+        const double sv_tot = sv0 + w * ( sv1 - sv0 );
+
+        /* now evaluate whether any of these interactions should even
+         * happen. */
+        if ( sv_tot <= 0.0 ||
+             (rng.rand() * max_sigma_relspeed) > sv_tot )
+          return std::make_pair(-1,0.0); /* no interaction!!! */
+
+        return samplePath( k, w, sv_tot, v_relative, rng );
+      }
+
+      /** Test the given pair of particles for an interaction and, if
+       * successful, perform the interaction.
+       *
+       * @return The output path as returned by calculateOutPath.
+       * */
+      template < typename PIter,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      std::pair<int,double>
+      interact( const double & max_sigma_relspeed,
+                const std::pair<PIter, PIter> & pair,
+                BackInsertionSequence & result_list,
+                RNG & rng ) const {
+        return super::doInteract( *this, max_sigma_relspeed, pair,
+                                  result_list, rng );
+      }
+
+      /** Test a batch of pairs for interactions, given their relative speeds.
+       * The bins of the table and the interpolated totals are first found
+       * for all pairs, the acceptance tests are then done for all pairs, and
+       * finally the output paths of the accepted pairs are sampled from the
+       * alias tables.  Pairs beyond the tabulated range are tested with
+       * Set::calculateOutPath.
+       *
+       * @see Set::testPairs.
+       * */
+      template < typename RNG >
+      void testPairs( const double & max_sigma_relspeed,
+                      const double * v_relative,
+                      const unsigned int & n,
+                      OutPath * paths,
+                      double * scratch,
+                      RNG & rng ) const {
+        if ( !isPrecomputed() ) {
+          super::testPairs( max_sigma_relspeed, v_relative, n, paths,
+                            scratch, rng );
+          return;
+        }
+
+        double * x = scratch;
+        double * sv_tot = scratch + n;
+        double * accepted = scratch + 2u * n;
+
+        /* bin lookup */
+        for ( unsigned int k = 0u; k < n; ++k ) {
+          x[k] = v_relative[k] * dv_inv;
+          /* (pairs beyond the table are clamped here and handled below) */
+          const unsigned int b =
+            static_cast<unsigned int>( std::min( x[k], n_bins - 1.0 ) );
+          sv_tot[k] = sigma_v_total[b]
+                    + ( x[k] - b ) * ( sigma_v_total[b+1] - sigma_v_total[b] );
+        }
+
+        /* acceptance tests */
+        for ( unsigned int k = 0u; k < n; ++k ) {
+          if ( x[k] >= n_bins ) {
+            accepted[k] = 0.0;
+            continue;
+          }
+
+          accepted[k] = ( sv_tot[k] > 0.0 &&
+                          !( (rng.rand() * max_sigma_relspeed) > sv_tot[k] ) )
+                      ? 1.0 : 0.0;
+        }
+
+        /* path selection */
+        for ( unsigned int k = 0u; k < n; ++k ) {
+          if ( x[k] >= n_bins )
+            paths[k] = super::calculateOutPath( max_sigma_relspeed,
+                                                v_relative[k], rng );
+          else if ( accepted[k] == 0.0 )
+            paths[k] = std::make_pair(-1,0.0); /* no interaction!!! */
+          else {
+            const unsigned int b = static_cast<unsigned int>( x[k] );
+            paths[k] = samplePath( b, x[k] - b, sv_tot[k], v_relative[k],
+                                   rng );
+          }
+        }
+      }
+
+    private:
+      /** Sample the output path of an accepted test in bin k of the table at
+       * the interpolation weight w (of node k+1), where sv_tot is the
+       * interpolated total. */
+      template < typename RNG >
+      std::pair<int,double> samplePath( const unsigned int & k,
+                                        const double & w,
+                                        const double & sv_tot,
+                                        const double & v_relative,
+                                        RNG & rng ) const {
+        /* Pick the node from which to sample according to its contribution to
+         * the interpolated value. */
+        const double sv0 = sigma_v_total[k];
+        const unsigned int node =
+          ( rng.randExc() * sv_tot < (1.0 - w) * sv0 ) ? k : (k+1u);
+
+        /* Sample the alias table of the node. */
+        double u = rng.randExc() * n_eq;
+        int j = static_cast<int>(u);
+        u -= j;
+        if ( u >= alias_prob[node * n_eq + j] )
+          j = alias_index[node * n_eq + j];
+
+        const double sv0_j = sigma_v[k * n_eq + j];
+        const double sv_j = sv0_j + w * ( sigma_v[(k+1u) * n_eq + j] - sv0_j );
+        return std::make_pair( j, sv_j / v_relative );
+      }
+    };
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_PreComputedSet_h
@@ -0,0 +1,153 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Declaration of the product sinks into which the interaction models write
+ * the products of interactions.
+ * */
+
+#ifndef chimp_interaction_ProductSink_h
+#define chimp_interaction_ProductSink_h
+
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+
+namespace chimp {
+  namespace interaction {
+
+    /** The default product sink metafunction:  the products are appended to
+     * a std::vector<Particle>.
+     *
+     * A product sink (options::ProductSink, see make_options) is the object
+     * into which the interaction models write the products of the
+     * interactions (and is the BackInsertionSequence given to the drivers).
+     * The models only require the following subset of the std::vector
+     * interface:
+     *    - typedef value_type (the Particle type),
+     *    - size(),
+     *    - reserve(n):  references to the elements remain valid for the next
+     *      n - size() calls to push_back,
+     *    - push_back(const value_type &),
+     *    - back() and operator[](i) (returning references).
+     *
+     * The models create each product directly in the sink and modify it
+     * there.  Other sinks (such as ProductSlab or a sink of proxy particles
+     * that stores the products in separate arrays) can be selected with
+     * make_options::type::setProductSink.
+     */
+    template < typename Particle >
+    struct VectorSink {
+      typedef std::vector< Particle > type;
+    };
+
+
+    /** A product sink that writes into caller-owned storage, such as an
+     * arena preallocated from the expected number of collisions or a slab
+     * of the particle array of a cell.  The storage is never reallocated:
+     * exceeding the capacity throws std::length_error (and a
+     * default-constructed slab has no capacity).
+     */
+    template < typename Particle >
+    class ProductSlab {
+      /* TYPEDEFS */
+    public:
+      typedef Particle value_type;
+      typedef Particle & reference;
+      typedef const Particle & const_reference;
+      typedef Particle * iterator;
+      typedef const Particle * const_iterator;
+      typedef std::size_t size_type;
+
+
+      /* MEMBER STORAGE */
+    private:
+      /** The beginning of the storage. */
+      Particle * first;
+
+      /** The end of the products written so far. */
+      Particle * last;
+
+      /** The end of the storage. */
+      Particle * limit;
+
+
+      /* MEMBER FUNCTIONS */
+    public:
+      /** Constructor of a slab without any storage. */
+      ProductSlab() : first( 0 ), last( 0 ), limit( 0 ) { }
+
+      /** Constructor of a slab over the storage [first, first + capacity).
+       */
+      ProductSlab( Particle * first, const size_type & capacity )
+        : first( first ), last( first ), limit( first + capacity ) { }
+
+      size_type size() const { return last - first; }
+      size_type capacity() const { return limit - first; }
+      bool empty() const { return last == first; }
+
+      /** Check that the slab can hold n products. */
+      void reserve( const size_type & n ) const {
+        if ( n > capacity() )
+          throw std::length_error( "product slab capacity exceeded" );
+      }
+
+      /** Write a product at the end of the slab. */
+      void push_back( const Particle & p ) {
+        if ( last == limit )
+          throw std::length_error( "product slab capacity exceeded" );
+        *last = p;
+        ++last;
+      }
+
+      /** Forget all products (the storage is kept). */
+      void clear() { last = first; }
+
+            iterator begin()       { return first; }
+      const_iterator begin() const { return first; }
+            iterator end()         { return last; }
+      const_iterator end()   const { return last; }
+
+            reference back()       { return *(last - 1); }
+      const_reference back() const { return *(last - 1); }
+
+            reference operator[] ( const size_type & i )       {
+        return first[i];
+      }
+      const_reference operator[] ( const size_type & i ) const {
+        return first[i];
+      }
+    };
+
+
+    /** Metafunction to select ProductSlab as the product sink (see
+     * make_options::type::setProductSink). */
+    template < typename Particle >
+    struct SlabSink {
+      typedef ProductSlab< Particle > type;
+    };
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_ProductSink_h
@@ -29,12 +29,16 @@
 #define chimp_interaction_Set_h
 
 #include <chimp/interaction/Equation.h>
+#include <chimp/interaction/Triple.h>
+#include <chimp/interaction/detail/CompiledCrossSections.h>
 
 #include <xylose/logger.h>
 #include <xylose/compat/math.hpp>
 
 #include <vector>
+#include <limits>
 #include <ostream>
+#include <algorithm>
 
 namespace chimp {
   namespace interaction {
@@ -54,6 +58,15 @@ namespace chimp {
        * */
       typedef std::pair<int, double> OutPath;
 
+      /** Number of equations up to which calculateOutPath buffers the cross
+       * sections on the stack.  Larger sets evaluate the cross sections twice
+       * for accepted tests instead. */
+      enum { OUTPATH_BUFFER_SIZE = 32 };
+
+      /** Number of rows of scratch space (of the size of the batch) that
+       * testPairs requires in addition to one row per equation. */
+      enum { TESTPAIRS_SCRATCH_ROWS = 4 };
+
 
 
       /* MEMBER STORAGE */
@@ -63,13 +76,58 @@ namespace chimp {
       /** A set of right hand sides of the several equations. */
       eq_list rhs;
 
+      /** Devirtualized references to the cross sections of rhs.  These are
+       * created by prepare() and are only used while rhs still has the
+       * compiled cross sections (see CompiledCrossSections::isCompiled).
+       * prepare() must be called again if any of the cross sections of rhs
+       * are replaced. */
+      detail::CompiledCrossSections<options> compiled;
+
+      /** Lower ends of the pieces of (0, v_max] on which the maximum of the
+       * sum of sigma*velocity of all equations is bounded (see
+       * tabulateMaxSigmaV).  The last value is v_max. */
+      std::vector<double> majorant_v;
+
+      /** Upper bound of the sum of sigma*velocity over (0, majorant_v[k]]. */
+      std::vector<double> majorant;
+
+      /** Upper bound of the sum of sigma*velocity within the piece starting
+       * at majorant_v[k]. */
+      std::vector<double> majorant_bound;
+
+      /** Sum of the decrease of the decreasing terms of sigma*velocity within
+       * the piece starting at majorant_v[k].  Within the piece, the sum of
+       * sigma*velocity up to v is thus also bounded by
+       *    majorant_dec[k] + v * sigma(v). */
+      std::vector<double> majorant_dec;
+
+      /** Maximum of the sum of sigma*velocity within each of the uniform
+       * buckets of relative speed (0, majorant_v.back()].  This is used to
+       * reject pair tests without evaluating the cross sections. */
+      std::vector<double> bucket_majorant;
+
+      /** Inverse width of the buckets of bucket_majorant. */
+      double bucket_dv_inv;
+
+      /** Number of equations at the time of tabulateMaxSigmaV.  The tabulated
+       * maxima are ignored if the size of rhs changes. */
+      unsigned int majorant_n;
+
+      /** Whether all of the cross sections had exact extrema (see
+       * cross_section::Base::hasExactExtrema) at the time of
+       * tabulateMaxSigmaV.  Otherwise, the tabulated maxima may miss a peak
+       * and are only used together with the maxima given by each of the
+       * cross sections. */
+      bool majorant_exact;
+
 
 
       /* MEMBER FUNCTIONS */
       /** Constructor.  A blank set of equations are created if constructor
        * arguments are omitted. */
       Set(const Input & lhs = Input(), const eq_list & rhs = eq_list())
-        : lhs(lhs), rhs(rhs) {}
+        : lhs(lhs), rhs(rhs), bucket_dv_inv(0.0), majorant_n(0u),
+          majorant_exact(false) {}
 
       /** Print the common left hand side followed by each of the equations. */
       template <class RnDB>
@@ -86,20 +144,176 @@ namespace chimp {
       }
 
       /** Find the local maximum of cross-section*velocity (within a given
-       * range of velocity space).  This version of the Set class returns the
-       * sum of the maxima of each cross section contained in the set.  For null
-       * collision methods, this will resort to more collisions than necessary.
-       * For a more performance sensitive implementation, use the precomputed
-       * Set implementation.
+       * range of velocity space).  Within the range searched by
+       * tabulateMaxSigmaV, this returns an upper bound (tight to the relative
+       * tolerance given there) of the maximum of the sum of sigma*velocity
+       * over all equations, which is found with one binary search and one
+       * evaluation of the cross sections at v_rel_max.  Beyond
+       * this range, or if any of the cross sections does not have exact
+       * extrema (see cross_section::Base::hasExactExtrema), this returns (at
+       * least) the sum of the maxima of each cross section contained in the
+       * set.  For null collision methods, this latter will resort to more
+       * collisions than necessary.
        * */
       inline double findMaxSigmaVProduct(const double & v_rel_max) const {
-        double sum = 0.0;
-        for ( typename eq_list::const_iterator i = rhs.begin(),
-                                             end = rhs.end();
-                                              i != end; ++i ) {
-          sum += i->cs->findMaxSigmaV(v_rel_max).first;
+        if ( majorant_n == rhs.size() && !majorant_v.empty() &&
+             v_rel_max >= majorant_v.front() &&
+             v_rel_max <= majorant_v.back() ) {
+          const unsigned int k =
+            std::upper_bound( majorant_v.begin(), majorant_v.end(), v_rel_max )
+            - majorant_v.begin();
+          const double sv = v_rel_max * sumCrossSections( v_rel_max );
+
+          /* sup over (0, majorant_v[k-1]] and over the rest of the piece up
+           * to v_rel_max. */
+          const double bound =
+            std::max( majorant[k-1u],
+                      std::min( majorant_bound[k-1u],
+                                sv + majorant_dec[k-1u] ) );
+          if ( majorant_exact )
+            return bound;
+          return std::max( bound, sumMaxSigmaV( v_rel_max ) );
         }
-        return sum;
+
+        return sumMaxSigmaV( v_rel_max );
+      }
+
+      /** Tabulate an upper bound of the running maximum of the sum of
+       * sigma*velocity of all equations over (0, v_max] for
+       * findMaxSigmaVProduct and localMaxSigmaV.
+       *
+       * The range is first split such that each of the products v*sigma_i is
+       * monotone on each piece:  at the breakpoints of each cross section
+       * (see cross_section::Base::getBreakpoints) and at the extrema of each
+       * v*sigma_i.  The extrema of each single product are found by bisection
+       * of the sign changes of its derivative (cross_section::Base::dSigmaV),
+       * which are bracketed by sampling each smooth segment of that cross
+       * section at n_samples points.
+       *
+       * On a piece [a,b] where each term is monotone, the sum is bounded by
+       *    sum_i max( v*sigma_i(a), v*sigma_i(b) ).
+       * A piece is bisected until this bound exceeds the larger of the two
+       * sums at a and b by no more than rel_tol.  Therefore, maxima of the
+       * sum that fall between the maxima of the single terms are bounded,
+       * regardless of how close together they are.  Below v_min = 1e-9 *
+       * v_max, the sum is bounded by the maxima given by each cross section
+       * (see cross_section::Base::findMaxSigmaV).
+       *
+       * The sampling can only find the extrema of cross sections for which
+       * cross_section::Base::hasExactExtrema is true.  If this is not true
+       * for all of the cross sections, findMaxSigmaVProduct also includes
+       * the maxima given by each cross section and localMaxSigmaV does not
+       * bound the tests (i.e. the early rejection is disabled).
+       * */
+      void tabulateMaxSigmaV( const double & v_max,
+                              const unsigned int & n_samples = 16u,
+                              const unsigned int & n_buckets = 256u,
+                              const double & rel_tol = 1e-3 ) {
+        majorant_n = 0u;
+        majorant_exact = false;
+        majorant_v.clear();
+        majorant.clear();
+        majorant_bound.clear();
+        majorant_dec.clear();
+        bucket_majorant.clear();
+        bucket_dv_inv = 0.0;
+
+        if ( rhs.empty() || !( v_max > 0.0 ) )
+          return;
+
+        const unsigned int n_eq = rhs.size();
+        const double eps = 4.0 * std::numeric_limits<double>::epsilon();
+        const double v_min = 1e-9 * v_max;
+
+        /* points that split (v_min, v_max] into pieces where each term is
+         * monotone.  The bucket edges are included such that each piece lies
+         * within a single bucket. */
+        std::vector<double> s;
+        s.push_back( v_min );
+        s.push_back( v_max );
+        for ( unsigned int b = 1u; b < n_buckets; ++b )
+          s.push_back( v_max * b / n_buckets );
+
+        for ( unsigned int i = 0u; i < n_eq; ++i ) {
+          std::vector<double> bp;
+          bp.push_back( v_min );
+          bp.push_back( v_max );
+          rhs[i].cs->getBreakpoints( v_max, bp );
+
+          std::sort( bp.begin(), bp.end() );
+          bp.erase( std::unique( bp.begin(), bp.end() ), bp.end() );
+          bp.erase( bp.begin(),
+                    std::lower_bound( bp.begin(), bp.end(), v_min ) );
+          bp.erase( std::upper_bound( bp.begin(), bp.end(), v_max ),
+                    bp.end() );
+
+          for ( unsigned int k = 0u; k + 1u < bp.size(); ++k ) {
+            /* the cross sections may step at a breakpoint, so the step is
+             * isolated within [bp*(1-eps), bp*(1+eps)]. */
+            const double a = bp[k] * ( 1.0 + eps );
+            const double b = bp[k+1u] * ( 1.0 - eps );
+            s.push_back( bp[k] );
+            s.push_back( a );
+            s.push_back( b );
+            if ( !( b > a ) )
+              continue;
+
+            findExtrema( *rhs[i].cs, a, b, n_samples, eps, s );
+          }
+        }
+
+        std::sort( s.begin(), s.end() );
+        s.erase( std::unique( s.begin(), s.end() ), s.end() );
+        s.erase( s.begin(), std::lower_bound( s.begin(), s.end(), v_min ) );
+        s.erase( std::upper_bound( s.begin(), s.end(), v_max ), s.end() );
+
+        bucket_majorant.assign( n_buckets, 0.0 );
+        bucket_dv_inv = n_buckets / v_max;
+
+        std::vector<double> fa( n_eq ), fb( n_eq );
+        termsSigmaV( s[0], fa );
+        double running_max = 0.0;
+        for ( unsigned int i = 0u; i < n_eq; ++i )
+          running_max += fa[i];
+        /* (0, v_min] */
+        running_max = std::max( running_max, sumMaxSigmaV( s[0] ) );
+        bucket_majorant[0] = running_max;
+
+        for ( unsigned int k = 0u; k + 1u < s.size(); ++k ) {
+          termsSigmaV( s[k+1u], fb );
+          boundPiece( s[k], fa, s[k+1u], fb, rel_tol, eps, running_max );
+          fa.swap( fb );
+        }
+
+        majorant_v.push_back( s.back() );
+        majorant.push_back( running_max );
+        majorant_bound.push_back( running_max );
+        majorant_dec.push_back( 0.0 );
+
+        /* allow for round-off in the evaluation of the cross sections. */
+        for ( unsigned int b = 0u; b < n_buckets; ++b )
+          bucket_majorant[b] *= ( 1.0 + 1e-6 );
+
+        majorant_exact = true;
+        for ( unsigned int i = 0u; i < n_eq; ++i )
+          majorant_exact = majorant_exact && rhs[i].cs->hasExactExtrema();
+
+        /* a peak between the samples would be rejected. */
+        if ( !majorant_exact )
+          bucket_majorant.clear();
+
+        majorant_n = rhs.size();
+      }
+
+      /** Upper bound of sigma*velocity summed over all equations for relative
+       * speeds near v_relative, based on the maxima found by
+       * tabulateMaxSigmaV.  If no bound is known (or the cross sections do not
+       * all have exact extrema), infinity is returned. */
+      inline double localMaxSigmaV( const double & v_relative ) const {
+        const double x = v_relative * bucket_dv_inv;
+        if ( majorant_n != rhs.size() || !( x < bucket_majorant.size() ) )
+          return std::numeric_limits<double>::infinity();
+        return bucket_majorant[ static_cast<unsigned int>(x) ];
       }
 
       /** Chooses an interaction path to traverse dependent on the incident
@@ -117,54 +331,68 @@ namespace chimp {
       calculateOutPath( const double & max_sigma_relspeed,
                         const double & v_relative,
                         RNG & rng ) const {
-        /* first find the normalization factor for the sum of
-         * cross-section values at this velocity. */
-        double cs_tot = 0;
-        double cs_max = 0;
-        std::vector<double> cs;
-        cs.reserve(rhs.size());
-        for ( typename eq_list::const_iterator i = rhs.begin(),
-                                             end = rhs.end();
-              i != end; ++i ) {
-          double csi = i->cs->operator()(v_relative);
-          cs_tot += csi;
-          cs.push_back(csi);
+        /* The same random number is used for the acceptance test and (if
+         * valid) the selection of the output path. */
+        const double u = rng.rand() * max_sigma_relspeed;
 
-          if (csi > cs_max)
-            cs_max = csi;
-        }
-
-        /* now evaluate whether any of these interactions should even
-         * happen. */
-        if ( (rng.rand() * max_sigma_relspeed) > (cs_tot*v_relative) )
+        /* reject without evaluating the cross sections if possible. */
+        if ( u >= localMaxSigmaV( v_relative ) )
           return std::make_pair(-1,0.0); /* no interaction!!! */
 
-        #if UPGRADE_MAX_SIGMA_V
-        /* upgrade max_sigma_relspeed? */
-        {
-          register double cs_max_relspeed = cs_max * v_relative;
-          if (cs_max_relspeed > max_sigma_relspeed)
-            max_sigma_relspeed = cs_max_relspeed;
+        const unsigned int n = rhs.size();
+        if ( n > OUTPATH_BUFFER_SIZE ) {
+          /* For very large sets, the cross sections are evaluated again to
+           * select the output path instead of being buffered. */
+          const double cs_tot = sumCrossSections( v_relative );
+          if ( u >= cs_tot * v_relative )
+            return std::make_pair(-1,0.0); /* no interaction!!! */
+
+          const double r = pathRandom( max_sigma_relspeed, v_relative, u,
+                                       cs_tot, rng );
+          double sum = 0.0;
+          for ( unsigned int j = 0u; j < n; ++j ) {
+            const double cs_j = (*rhs[j].cs)( v_relative );
+            sum += cs_j;
+            if ( sum > r )
+              return std::make_pair(int(j),cs_j);
+          }
+
+          return std::make_pair(-1,0.0);
         }
-        #endif
 
-        /* now, we finally pick our output state.  */
-        double r = rng.randExc() * cs_tot;
-        cs_tot = 0;
-        int j = 0;
-        for ( std::vector<double>::iterator i = cs.begin(),
-                                          end = cs.end();
-              i < end; ++i, ++j) {
-          cs_tot += (*i);
-          if (cs_tot > r)
-            return std::make_pair(j,(*i));
+        double cs[OUTPATH_BUFFER_SIZE];
+        if ( compiled.isCompiled( rhs ) ) {
+          compiled.evaluate( v_relative, cs );
+        } else {
+          for ( unsigned int i = 0u; i < n; ++i )
+            cs[i] = rhs[i].cs->operator()(v_relative);
         }
 
-        /* we actually better never get here. */
-        xylose::logger::log_severe("interaction::Set::calculateOutPath reached invalid return");
-        return std::make_pair(-1,0.0);
+        return selectOutPath( max_sigma_relspeed, v_relative, u, cs, n, rng );
+      }
+
+      /** Prepare any cached information of this set after all of the
+       * equations have been added to the rhs list.  This version of the Set
+       * class compiles the cross sections for devirtualized evaluation and
+       * searches for the maximum of sigma*velocity up to the relative kinetic
+       * energy RuntimeDB::default_Set_maxSigmaV_Emax.
+       *
+       * @see PreComputedSet::prepare.
+       * */
+      template < typename RnDB >
+      void prepare( const RnDB & db ) {
+        compiled.compile( rhs );
+
+        if ( !rhs.empty() )
+          tabulateMaxSigmaV( std::sqrt( 2.0 * db.default_Set_maxSigmaV_Emax
+                                        / rhs.front().reducedMass.value ) );
       }
 
+      /** Test the given pair of particles for an interaction and, if
+       * successful, perform the interaction.
+       *
+       * @return The output path as returned by calculateOutPath.
+       * */
       template < typename PIter,
                  typename BackInsertionSequence,
                  typename RNG >
@@ -173,53 +401,433 @@ namespace chimp {
                 const std::pair<PIter, PIter> & pair,
                 BackInsertionSequence & result_list,
                 RNG & rng ) const {
+        return doInteract( *this, max_sigma_relspeed, pair, result_list, rng );
+      }
+
+      /** Test a batch of pairs for interactions, given their relative
+       * speeds.  The random numbers of the acceptance tests are drawn first
+       * and the tests that are rejected by the bound of localMaxSigmaV are
+       * removed from the batch without evaluating any cross sections.  The
+       * cross sections of the remaining pairs are then evaluated with one
+       * call to cross_section::Base::evaluate per equation (see
+       * evaluateBatch), the acceptance tests are done for all of these
+       * pairs, and finally the output paths of the accepted pairs are
+       * chosen.  The random numbers are therefore drawn in a different order
+       * than by calling calculateOutPath for each pair, but with the same
+       * distribution.
+       *
+       * @param v_relative
+       *    Array of n relative speeds.
+       * @param paths
+       *    [output] Array of n output paths as returned by calculateOutPath.
+       * @param scratch
+       *    Scratch space of at least (rhs.size() + TESTPAIRS_SCRATCH_ROWS) * n
+       *    values.
+       * */
+      template < typename RNG >
+      void testPairs( const double & max_sigma_relspeed,
+                      const double * v_relative,
+                      const unsigned int & n,
+                      OutPath * paths,
+                      double * scratch,
+                      RNG & rng ) const {
+        doTestPairs( *this, max_sigma_relspeed, v_relative, n, paths,
+                     scratch, rng );
+      }
+
+      /** Evaluate the cross sections of all equations for m relative speeds.
+       * This is the evaluation step of testPairs.
+       *
+       * @param cs
+       *    [output] Array of rhs.size() * m cross sections, where cs[i*m + k]
+       *    is that of equation i at v_relative[k].
+       * */
+      void evaluateBatch( const double * v_relative,
+                          const unsigned int & m,
+                          double * cs ) const {
+        for ( unsigned int i = 0u; i < rhs.size(); ++i )
+          rhs[i].cs->evaluate( v_relative, cs + i * m, m );
+      }
+
+      /** Perform the interaction of the given output path (as returned by
+       * calculateOutPath) for the given pair of particles.  The particles
+       * are passed to the interaction model in the order of increasing
+       * species index. */
+      template < typename PIter,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      void performInteraction( const OutPath & path,
+                               const std::pair<PIter, PIter> & pair,
+                               BackInsertionSequence & result_list,
+                               RNG & rng ) const {
         typename options::Particle & pA = *pair.first;
         typename options::Particle & pB = *pair.second;
 
-        using chimp::accessors::particle::velocity;
         using chimp::accessors::particle::species;
 
-        /* Relative velocity of the the two particles. */
-        double v_rel = ( velocity(pA) - velocity(pB) ).abs();
+        /* help make sure that the order of the particles is correct--sorted
+         * by increasing mass. */
+        if ( species(pA) > species(pB) )
+          rhs[path.first].interaction->interact( pB, pA, result_list, rng );
+        else
+          rhs[path.first].interaction->interact( pA, pB, result_list, rng );
+      }
 
-        std::pair<int,double> path =
-          calculateOutPath( max_sigma_relspeed, v_rel, rng );
+      /** Perform the three-body interaction of the given output path (as
+       * returned by calculateOutPath for the speed given by tripleSpeed) for
+       * the given triple of particles.  The particles are passed to the
+       * interaction model in the order of increasing species index. */
+      template < typename PIter,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      void performInteraction( const OutPath & path,
+                               const Triple<PIter> & triple,
+                               BackInsertionSequence & result_list,
+                               RNG & rng ) const {
+        typedef typename options::Particle Particle;
+        Particle * p[3] = { &*triple.first, &*triple.second, &*triple.third };
 
-        if ( path.first >= 0 ) {
-          /* help make sure that the order of the particles is correct--sorted
-           * by increasing mass. */
-          if ( species(pA) > species(pB) )
-            rhs[path.first].interaction->interact( pB, pA, result_list, rng );
+        using chimp::accessors::particle::species;
+
+        /* sort the three particles by species. */
+        if ( species(*p[0]) > species(*p[1]) ) std::swap( p[0], p[1] );
+        if ( species(*p[1]) > species(*p[2]) ) std::swap( p[1], p[2] );
+        if ( species(*p[0]) > species(*p[1]) ) std::swap( p[0], p[1] );
+
+        rhs[path.first].interaction->interact( *p[0], *p[1], *p[2],
+                                               result_list, rng );
+      }
+
+      /** Perform the interactions of the given output paths (as returned by
+       * calculateOutPath or testPairs) for n pairs of particles at once.  The
+       * pairs of each equation are passed together to the batched interface
+       * of its interaction model (in the order of increasing species index
+       * within each pair).  The products are thus grouped by equation
+       * instead of following the order of the pairs.  Pairs with
+       * paths[k].first < 0 are skipped.  The pairs must not share particles.
+       *
+       * @param pairs
+       *    pairs[k] gives the k-th pair as a std::pair of particle iterators,
+       *    such as an array of std::pair<PIter,PIter>.
+       * @param created
+       *    Set to whether products were created for each pair.
+       */
+      template < typename PairArray,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      void performInteractions( const OutPath * paths,
+                                const PairArray & pairs,
+                                const unsigned int & n,
+                                BackInsertionSequence & result_list,
+                                char * created,
+                                RNG & rng ) const {
+        typedef typename model::Base<options>::ParticleArgPtr PPtr;
+        static const unsigned int chunk = 64u;
+
+        using chimp::accessors::particle::species;
+
+        PPtr p1[chunk], p2[chunk];
+        unsigned int idx[chunk];
+        std::size_t ends[chunk];
+
+        for ( unsigned int k = 0u; k < n; ++k )
+          created[k] = false;
+
+        for ( unsigned int i = 0u; i < rhs.size(); ++i ) {
+          for ( unsigned int k = 0u; k < n; ) {
+            unsigned int m = 0u;
+            for ( ; k < n && m < chunk; ++k ) {
+              if ( paths[k].first != int(i) )
+                continue;
+
+              typename options::Particle & pA = *pairs[k].first;
+              typename options::Particle & pB = *pairs[k].second;
+              const bool swap = species(pA) > species(pB);
+              p1[m] = swap ? &pB : &pA;
+              p2[m] = swap ? &pA : &pB;
+              idx[m] = k;
+              ++m;
+            }
+
+            if ( m == 0u )
+              continue;
+
+            const std::size_t sz_i = result_list.size();
+            rhs[i].interaction->interact( p1, p2, m, result_list, ends, rng );
+            for ( unsigned int j = 0u; j < m; ++j )
+              created[idx[j]] = ends[j] > ( j > 0u ? ends[j-1u] : sz_i );
+          }
+        }
+      }
+
+    protected:
+      /** Sum of the cross sections of all equations. */
+      double sumCrossSections( const double & v_relative ) const {
+        double sum = 0.0;
+        for ( unsigned int i = 0u; i < rhs.size(); ++i )
+          sum += (*rhs[i].cs)( v_relative );
+        return sum;
+      }
+
+      /** Sum of the maxima of sigma*velocity over (0, v_rel_max] given by
+       * each of the equations. */
+      double sumMaxSigmaV( const double & v_rel_max ) const {
+        double sum = 0.0;
+        for ( typename eq_list::const_iterator i = rhs.begin(),
+                                             end = rhs.end();
+                                              i != end; ++i ) {
+          sum += i->cs->findMaxSigmaV(v_rel_max).first;
+        }
+        return sum;
+      }
+
+      /** Evaluate sigma*velocity of each of the equations. */
+      void termsSigmaV( const double & v_relative,
+                        std::vector<double> & sv ) const {
+        for ( unsigned int i = 0u; i < rhs.size(); ++i )
+          sv[i] = v_relative * (*rhs[i].cs)( v_relative );
+      }
+
+      /** Append brackets [lo, hi] (with hi - lo <= eps*hi) of the extrema of
+       * v*sigma of a single cross section within the smooth segment [a, b].
+       * The sign changes of the derivative are bracketed by sampling the
+       * segment at n_samples points. */
+      static void findExtrema( const cross_section::Base<options> & cs,
+                               const double & a,
+                               const double & b,
+                               const unsigned int & n_samples,
+                               const double & eps,
+                               std::vector<double> & out ) {
+        double t0 = a;
+        bool up0 = cs.dSigmaV( t0 ) > 0.0;
+        for ( unsigned int j = 1u; j <= n_samples; ++j ) {
+          const double t1 =
+            ( j == n_samples ? b : a + ( b - a ) * j / n_samples );
+          const bool up1 = cs.dSigmaV( t1 ) > 0.0;
+
+          if ( up0 != up1 ) {
+            double lo = t0, hi = t1;
+            while ( ( hi - lo ) > eps * hi ) {
+              const double mid = 0.5 * ( lo + hi );
+              if ( ( cs.dSigmaV( mid ) > 0.0 ) == up0 )
+                lo = mid;
+              else
+                hi = mid;
+            }
+            out.push_back( lo );
+            out.push_back( hi );
+          }
+
+          t0 = t1;
+          up0 = up1;
+        }
+      }
+
+      /** Bound the sum of sigma*velocity on the piece [a, b], on which each
+       * of the terms is monotone, given the values fa and fb of the terms at
+       * the ends.  The piece is bisected until the bound is within rel_tol
+       * of the values at its ends, and the bounds of the resulting pieces are
+       * appended to majorant_v, majorant, majorant_bound, majorant_dec, and
+       * bucket_majorant.
+       *
+       * @param running_max
+       *    [in/out] Upper bound of the sum of sigma*velocity over (0, a].
+       *    This is updated to the bound over (0, b].
+       * */
+      void boundPiece( const double & a,
+                       const std::vector<double> & fa,
+                       const double & b,
+                       const std::vector<double> & fb,
+                       const double & rel_tol,
+                       const double & eps,
+                       double & running_max ) {
+        double Fa = 0.0, Fb = 0.0, inc = 0.0, dec = 0.0;
+        for ( unsigned int i = 0u; i < fa.size(); ++i ) {
+          Fa += fa[i];
+          Fb += fb[i];
+          if ( fb[i] > fa[i] )
+            inc += fb[i] - fa[i];
           else
-            rhs[path.first].interaction->interact( pA, pB, result_list, rng );
+            dec += fa[i] - fb[i];
         }
 
-        return path;
+        /* bound - max(Fa,Fb) == min(inc,dec) */
+        if ( std::min( inc, dec ) > rel_tol * std::max( Fa, Fb ) &&
+             ( b - a ) > eps * b ) {
+          const double mid = 0.5 * ( a + b );
+          std::vector<double> fm( fa.size() );
+          termsSigmaV( mid, fm );
+          boundPiece( a, fa, mid, fm, rel_tol, eps, running_max );
+          boundPiece( mid, fm, b, fb, rel_tol, eps, running_max );
+          return;
+        }
+
+        const double bound = Fa + inc;
+        majorant_v.push_back( a );
+        majorant.push_back( running_max );
+        majorant_bound.push_back( bound );
+        majorant_dec.push_back( dec );
+        running_max = std::max( running_max, bound );
+
+        const unsigned int k =
+          static_cast<unsigned int>( 0.5 * ( a + b ) * bucket_dv_inv );
+        if ( k < bucket_majorant.size() )
+          bucket_majorant[k] = std::max( bucket_majorant[k], bound );
       }
-    };
 
-#if 0
-    /** This set implementation pre-calculates the cross-section and
-     * probabilities at various pre-determined energies and stores the
-     * associated lookup-table for later use. */
-    struct PreComputedSet : Set {
+      /** Test for an interaction and choose the output path given the
+       * cross-section values of each of the equations at the incident
+       * relative speed.  This is the part of calculateOutPath that is common
+       * to all Set implementations which evaluate the cross sections
+       * directly.
+       *
+       * @param u
+       *    Uniform random number in [0, max_sigma_relspeed] used for the
+       *    acceptance test.
+       * @param cs
+       *    Array of n cross-section values, in the order of rhs.
+       * */
+      template < typename RNG >
+      static std::pair<int,double>
+      selectOutPath( const double & max_sigma_relspeed,
+                     const double & v_relative,
+                     const double & u,
+                     const double * cs,
+                     const unsigned int & n,
+                     RNG & rng ) {
+        double cs_tot = 0;
+        for ( unsigned int i = 0u; i < n; ++i )
+          cs_tot += cs[i];
+
+        /* now evaluate whether any of these interactions should even
+         * happen. */
+        if ( u >= cs_tot * v_relative )
+          return std::make_pair(-1,0.0); /* no interaction!!! */
 
-      struct elt {
-        double cross_section_total;
-        std::vector<double> cross_sections;
-        xylose::Distribution distrib;
-      };
+        /* now, we finally pick our output state.  */
+        const double r = pathRandom( max_sigma_relspeed, v_relative, u,
+                                     cs_tot, rng );
+        double sum = 0.0;
+        for ( unsigned int j = 0u; j < n; ++j ) {
+          sum += cs[j];
+          if ( sum > r )
+            return std::make_pair(int(j),cs[j]);
+        }
 
+        /* we actually better never get here. */
+        xylose::logger::log_severe("interaction::Set::selectOutPath reached invalid return");
+        return std::make_pair(-1,0.0);
+      }
 
-      std::pair<int,double>
-      calculateOutPath( const double & max_sigma_relspeed,
-                        const double & v_relative ) const {
-        if (rhs.empty())
-          return std::make_pair(-1,0.0);
-        return 1;
+      /** Random number in [0, cs_tot) for the selection of the output path
+       * of an accepted test.  Given acceptance, u/v_relative is already
+       * uniform over [0, cs_tot) and is reused, unless max_sigma_relspeed
+       * underestimates cs_tot*v_relative. */
+      template < typename RNG >
+      static double pathRandom( const double & max_sigma_relspeed,
+                                const double & v_relative,
+                                const double & u,
+                                const double & cs_tot,
+                                RNG & rng ) {
+        const double r = u / v_relative;
+        if ( max_sigma_relspeed < cs_tot * v_relative || !( r < cs_tot ) )
+          return rng.randExc() * cs_tot;
+        return r;
+      }
+
+      /** Implementation of testPairs(...) that uses the evaluateBatch
+       * function of the given (possibly derived) set type. */
+      template < typename SetT,
+                 typename RNG >
+      static void doTestPairs( const SetT & set,
+                               const double & max_sigma_relspeed,
+                               const double * v_relative,
+                               const unsigned int & n,
+                               OutPath * paths,
+                               double * scratch,
+                               RNG & rng ) {
+        const unsigned int n_eq = set.rhs.size();
+        double * u = scratch;
+        double * v = scratch + n;
+        double * index = scratch + 2u * n;
+        double * cs_tot = scratch + 3u * n;
+        double * cs = scratch + 4u * n;
+
+        /* draw all acceptance tests and keep only those that are not
+         * rejected by the tabulated bound. */
+        unsigned int m = 0u;
+        for ( unsigned int k = 0u; k < n; ++k ) {
+          paths[k] = std::make_pair(-1,0.0);
+          const double u_k = rng.rand() * max_sigma_relspeed;
+          if ( u_k >= set.localMaxSigmaV( v_relative[k] ) )
+            continue; /* no interaction!!! */
+
+          u[m] = u_k;
+          v[m] = v_relative[k];
+          index[m] = k;
+          ++m;
+        }
+
+        if ( m == 0u )
+          return;
+
+        set.evaluateBatch( v, m, cs );
+
+        for ( unsigned int k = 0u; k < m; ++k )
+          cs_tot[k] = 0.0;
+        for ( unsigned int i = 0u; i < n_eq; ++i ) {
+          const double * cs_i = cs + i * m;
+          for ( unsigned int k = 0u; k < m; ++k )
+            cs_tot[k] += cs_i[k];
+        }
+
+        for ( unsigned int k = 0u; k < m; ++k ) {
+          if ( u[k] >= cs_tot[k] * v[k] )
+            continue; /* no interaction!!! */
+
+          const double r = pathRandom( max_sigma_relspeed, v[k], u[k],
+                                       cs_tot[k], rng );
+          double sum = 0.0;
+          for ( unsigned int j = 0u; j < n_eq; ++j ) {
+            sum += cs[j * m + k];
+            if ( sum > r ) {
+              paths[ static_cast<unsigned int>( index[k] ) ] =
+                std::make_pair( int(j), cs[j * m + k] );
+              break;
+            }
+          }
+        }
+      }
+
+      /** Implementation of interact(...) that uses the calculateOutPath
+       * function of the given (possibly derived) set type. */
+      template < typename SetT,
+                 typename PIter,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      static std::pair<int,double>
+      doInteract( const SetT & set,
+                  const double & max_sigma_relspeed,
+                  const std::pair<PIter, PIter> & pair,
+                  BackInsertionSequence & result_list,
+                  RNG & rng ) {
+        typename options::Particle & pA = *pair.first;
+        typename options::Particle & pB = *pair.second;
+
+        using chimp::accessors::particle::velocity;
+
+        /* Relative velocity of the the two particles. */
+        double v_rel = ( velocity(pA) - velocity(pB) ).abs();
+
+        std::pair<int,double> path =
+          set.calculateOutPath( max_sigma_relspeed, v_rel, rng );
+
+        if ( path.first >= 0 )
+          set.performInteraction( path, pair, result_list, rng );
+
+        return path;
       }
     };
-#endif
 
     template < typename options >
     inline bool hasElastic( const Set<options> & set ) {
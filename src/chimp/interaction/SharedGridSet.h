@@ -0,0 +1,324 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Definition of the equation set that evaluates all tabulated cross sections
+ * on a common velocity grid.
+ * */
+
+#ifndef chimp_interaction_SharedGridSet_h
+#define chimp_interaction_SharedGridSet_h
+
+#include <chimp/interaction/Set.h>
+#include <chimp/interaction/cross_section/DATA.h>
+#include <chimp/interaction/cross_section/AveragedDiameters.h>
+#include <chimp/interaction/detail/CompiledCrossSections.h>
+
+#include <vector>
+#include <limits>
+#include <typeinfo>
+#include <algorithm>
+
+namespace chimp {
+  namespace interaction {
+
+    /** This set implementation merges the tables of all of its DATA cross
+     * sections onto the union of their velocity knots.  Since each DATA cross
+     * section is linear between its own knots, it is also linear between the
+     * knots of the union, so that the merged table reproduces the original
+     * interpolation exactly.  For each pair test, the bin of the common grid
+     * is found with a single binary search and each DATA cross section is then
+     * obtained by one multiply-add from a contiguous row of (value, slope)
+     * coefficients.  Cross sections of other types are evaluated directly
+     * (see detail::CompiledCrossSections).
+     *
+     * The common grid spans from the lowest knot of any of the DATA cross
+     * sections up to the highest knot beyond which none of the tables needs to
+     * be extrapolated.  Outside of this range, this set falls back to the
+     * runtime calculation of Set::calculateOutPath.  The merged table is
+     * always built from the original data of each table (DATA::evalTable),
+     * even if the DATA instance uses a resampled grid.
+     *
+     * To use this set for the RuntimeDB interaction table, use
+     * make_options<>::type::setInteractionSet<interaction::SharedGridSet>.
+     * */
+    template < typename options >
+    struct SharedGridSet : Set<options> {
+      /* TYPEDEFS */
+      typedef interaction::Set<options> super;
+      typedef typename super::Equation Equation;
+      typedef typename super::eq_list eq_list;
+      typedef typename super::OutPath OutPath;
+
+      typedef cross_section::DATA<options> DATA;
+      typedef cross_section::AveragedDiameters<options> AveragedDiameters;
+
+
+
+      /* MEMBER STORAGE */
+      /** Number of equations at the time of share (the size of rhs).  If rhs
+       * changes size after share, the common grid is ignored until share is
+       * called again. */
+      unsigned int n_eq;
+
+      /** Indices (into rhs) of the equations that use the common grid. */
+      std::vector<unsigned int> grid_index;
+
+      /** Common velocity grid (the union of the knots of all tables). */
+      std::vector<double> grid;
+
+      /** Coefficients of each bin of the common grid.  The row for bin k
+       * (between grid[k] and grid[k+1]) stores the value of each of the
+       * grid_index.size() cross sections at grid[k], followed by the slope of
+       * each within the bin. */
+      std::vector<double> coeffs;
+
+      /** Devirtualized copies of the cross sections that do not use the common
+       * grid. */
+      detail::CompiledCrossSections<options> others;
+
+
+
+      /* MEMBER FUNCTIONS */
+      /** Constructor.  A blank set of equations are created if constructor
+       * arguments are omitted.  The common grid is not computed until share
+       * (or prepare) is called. */
+      SharedGridSet( const Input & lhs = Input(),
+                     const eq_list & rhs = eq_list() )
+        : super(lhs, rhs), n_eq(0u) { }
+
+      /** Prepare the compiled cross sections and the common grid. */
+      template < typename RnDB >
+      void prepare( const RnDB & db ) {
+        super::prepare( db );
+        share();
+      }
+
+      /** Merge the tables of all DATA cross sections of rhs onto a common
+       * velocity grid. */
+      void share() {
+        n_eq = 0u;
+        grid_index.clear();
+        grid.clear();
+        coeffs.clear();
+        others.clear();
+
+        std::vector<bool> mask( this->rhs.size(), true );
+        std::vector<const DATA *> tables;
+        double v_hi = std::numeric_limits<double>::infinity();
+
+        for ( unsigned int i = 0u; i < this->rhs.size(); ++i ) {
+          const cross_section::Base<options> & cs = *this->rhs[i].cs;
+          const std::type_info & t = typeid(cs);
+          if ( t != typeid(DATA) && t != typeid(AveragedDiameters) )
+            continue;
+
+          const DATA & data = static_cast<const DATA &>(cs);
+          const cross_section::DoubleDataSet & table = data.getTable();
+          if ( table.size() < 2u )
+            continue;
+
+          typedef cross_section::DoubleDataSet::const_iterator CIter;
+          for ( CIter k = table.begin(); k != table.end(); ++k )
+            grid.push_back( k->first );
+
+          /* DATA is zero at and below its first knot.  If the data does not
+           * start at zero, add a knot just above the first one to preserve the
+           * step. */
+          if ( table.begin()->second != 0.0 )
+            grid.push_back( table.begin()->first
+                            * ( 1.0 + std::numeric_limits<double>::epsilon() )
+                          + std::numeric_limits<double>::min() );
+
+          /* DATA beyond its last knot is either zero or extrapolated.  The
+           * extrapolation is not linear, so the common grid must end here. */
+          if ( table.rbegin()->second != 0.0 )
+            v_hi = std::min( v_hi, table.rbegin()->first );
+
+          tables.push_back( &data );
+          grid_index.push_back( i );
+          mask[i] = false;
+        }
+
+        std::sort( grid.begin(), grid.end() );
+        grid.erase( std::unique( grid.begin(), grid.end() ), grid.end() );
+        grid.erase( std::upper_bound( grid.begin(), grid.end(), v_hi ),
+                    grid.end() );
+
+        if ( grid.size() < 2u ) {
+          grid_index.clear();
+          grid.clear();
+          return;
+        }
+
+        const unsigned int nd = grid_index.size();
+        const unsigned int n_bins = grid.size() - 1u;
+        coeffs.resize( 2u * nd * n_bins );
+
+        std::vector<double> sigma0( nd ), sigma1( nd );
+        for ( unsigned int j = 0u; j < nd; ++j )
+          sigma0[j] = tables[j]->evalTable( grid[0] );
+
+        for ( unsigned int k = 0u; k < n_bins; ++k ) {
+          const double L_inv = 1.0 / ( grid[k+1] - grid[k] );
+          double * row = &coeffs[ 2u * nd * k ];
+          for ( unsigned int j = 0u; j < nd; ++j ) {
+            sigma1[j] = tables[j]->evalTable( grid[k+1] );
+            row[j]      = sigma0[j];
+            row[nd + j] = ( sigma1[j] - sigma0[j] ) * L_inv;
+          }
+          sigma0.swap( sigma1 );
+        }
+
+        others.compile( this->rhs, mask );
+        n_eq = this->rhs.size();
+      }
+
+      /** Whether the common grid is valid for the current set of equations. */
+      bool isShared() const {
+        return n_eq > 0u && n_eq == this->rhs.size();
+      }
+
+      /** Chooses an interaction path to traverse dependent on the incident
+       * relative speed and the current value of (sigma*relspeed)_max. 
+       *
+       * @return The index of the right-hand-side of the interaction
+       * equation is returned, unless no interaction can be performed.  In
+       * this latter case, a value of -1 will be returned.
+       * */
+      template < typename RNG >
+      std::pair<int,double>
+      calculateOutPath( const double & max_sigma_relspeed,
+                        const double & v_relative,
+                        RNG & rng ) const {
+        const unsigned int n = this->rhs.size();
+        if ( !isShared() || n > super::OUTPATH_BUFFER_SIZE ||
+             !( v_relative > grid.front() && v_relative <= grid.back() ) )
+          return super::calculateOutPath( max_sigma_relspeed, v_relative, rng );
+
+        const double u = rng.rand() * max_sigma_relspeed;
+
+        double cs[super::OUTPATH_BUFFER_SIZE];
+        others.evaluate( v_relative, cs );
+
+        /* find the bin (grid[k], grid[k+1]] containing v_relative */
+        const unsigned int k =
+          std::lower_bound( grid.begin(), grid.end(), v_relative )
+          - grid.begin() - 1u;
+        const double dv = v_relative - grid[k];
+
+        const unsigned int nd = grid_index.size();
+        const double * row = &coeffs[ 2u * nd * k ];
+        for ( unsigned int j = 0u; j < nd; ++j )
+          cs[ grid_index[j] ] = row[j] + dv * row[nd + j];
+
+        return super::selectOutPath( max_sigma_relspeed, v_relative, u,
+                                     cs, n, rng );
+      }
+
+      /** Test the given pair of particles for an interaction and, if
+       * successful, perform the interaction.
+       *
+       * @return The output path as returned by calculateOutPath.
+       * */
+      template < typename PIter,
+                 typename BackInsertionSequence,
+                 typename RNG >
+      std::pair<int,double>
+      interact( const double & max_sigma_relspeed,
+                const std::pair<PIter, PIter> & pair,
+                BackInsertionSequence & result_list,
+                RNG & rng ) const {
+        return super::doInteract( *this, max_sigma_relspeed, pair,
+                                  result_list, rng );
+      }
+
+      /** Test a batch of pairs for interactions, given their relative speeds.
+       * This version uses Set::testPairs with the batch evaluation of
+       * evaluateBatch (and therefore the common grid).
+       *
+       * @see Set::testPairs.
+       * */
+      template < typename RNG >
+      void testPairs( const double & max_sigma_relspeed,
+                      const double * v_relative,
+                      const unsigned int & n,
+                      OutPath * paths,
+                      double * scratch,
+                      RNG & rng ) const {
+        super::doTestPairs( *this, max_sigma_relspeed, v_relative, n, paths,
+                            scratch, rng );
+      }
+
+      /** Evaluate the cross sections of all equations for m relative speeds.
+       * The bins of the common grid are first found for all speeds and the
+       * rows of coefficients are then applied to each.  Speeds outside of the
+       * common grid use the cross sections directly.  The cross sections that
+       * do not use the common grid are evaluated with one call to
+       * cross_section::Base::evaluate each.
+       *
+       * @see Set::evaluateBatch.
+       * */
+      void evaluateBatch( const double * v_relative,
+                          const unsigned int & m,
+                          double * cs ) const {
+        if ( !isShared() ) {
+          super::evaluateBatch( v_relative, m, cs );
+          return;
+        }
+
+        /* the cross sections that are not on the common grid. */
+        const unsigned int nd = grid_index.size();
+        for ( unsigned int i = 0u, j = 0u; i < this->rhs.size(); ++i ) {
+          if ( j < nd && grid_index[j] == i ) {
+            ++j;
+            continue;
+          }
+
+          this->rhs[i].cs->evaluate( v_relative, cs + i * m, m );
+        }
+
+        for ( unsigned int k = 0u; k < m; ++k ) {
+          const double v = v_relative[k];
+          if ( !( v > grid.front() && v <= grid.back() ) ) {
+            for ( unsigned int j = 0u; j < nd; ++j )
+              cs[ grid_index[j] * m + k ] = (*this->rhs[ grid_index[j] ].cs)(v);
+            continue;
+          }
+
+          /* find the bin (grid[b], grid[b+1]] containing v */
+          const unsigned int b =
+            std::lower_bound( grid.begin(), grid.end(), v ) - grid.begin() - 1u;
+          const double dv = v - grid[b];
+
+          const double * row = &coeffs[ 2u * nd * b ];
+          for ( unsigned int j = 0u; j < nd; ++j )
+            cs[ grid_index[j] * m + k ] = row[j] + dv * row[nd + j];
+        }
+      }
+    };
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_SharedGridSet_h
@@ -0,0 +1,488 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Declaration of interaction::StatisticsMonitor class.
+ * */
+
+#ifndef chimp_interaction_StatisticsMonitor_h
+#define chimp_interaction_StatisticsMonitor_h
+
+#include <chimp/accessors.h>
+#include <chimp/interaction/Input.h>
+#include <chimp/interaction/Triple.h>
+#include <chimp/property/name.h>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <utility>
+#include <ctime>
+
+namespace chimp {
+  namespace interaction {
+
+    namespace detail {
+      /** Read a fine-grained time counter.  This is the processor cycle
+       * counter on x86 processors (with GCC compatible compilers) and
+       * std::clock() elsewhere. */
+      inline double readCycleCounter() {
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+        unsigned int lo, hi;
+        __asm__ __volatile__ ( "rdtsc" : "=a" (lo), "=d" (hi) );
+        return 4294967296.0 * hi + lo;
+#else
+        return static_cast<double>( std::clock() );
+#endif
+      }
+
+      /** Write the given string as a JSON string. */
+      inline std::ostream & writeJSONString( std::ostream & out,
+                                             const std::string & s ) {
+        out << '"';
+        for ( std::string::const_iterator i = s.begin(); i != s.end(); ++i ) {
+          if ( *i == '"' || *i == '\\' )
+            out << '\\';
+          out << *i;
+        }
+        return out << '"';
+      }
+
+      /** Write the given string as a quoted CSV field. */
+      inline std::ostream & writeCSVString( std::ostream & out,
+                                            const std::string & s ) {
+        out << '"';
+        for ( std::string::const_iterator i = s.begin(); i != s.end(); ++i ) {
+          if ( *i == '"' )
+            out << '"';
+          out << *i;
+        }
+        return out << '"';
+      }
+    }/* namespace chimp::interaction::detail */
+
+
+    /** Collision monitor that collects statistics per pair of species and
+     * per equation:  the number of pairs tested, the number of pairs
+     * accepted, the number of times each equation (i.e. each entry of the
+     * rhs of the interaction Set) was selected, and, if timing == true, the
+     * time (in processor cycles where available) spent on each pair of
+     * species.  The same statistics (except for the time) are collected per
+     * triple of species for the interactions with three inputs.
+     *
+     * The counters are not synchronized:  each driver (and each chunk of
+     * ParallelDriver) must use its own monitor.  ParallelDriver merges the
+     * monitors of the chunks into its monitor with merge().  The statistics
+     * can be written as CSV or JSON and then reset() for the next timestep.
+     */
+    template < bool timing = false >
+    struct StatisticsMonitor {
+      /* TYPEDEFS */
+      /** Statistics of one pair (or triple) of species. */
+      struct PairStatistics {
+        /** Number of pairs tested. */
+        unsigned long tests;
+
+        /** Number of pairs that interacted. */
+        unsigned long accepted;
+
+        /** Number of times each equation was selected. */
+        std::vector<unsigned long> paths;
+
+        /** Time spent testing and colliding pairs of this type. */
+        double cycles;
+
+        /** Constructor zeros the statistics. */
+        PairStatistics() : tests(0ul), accepted(0ul), paths(), cycles(0.0) { }
+
+        /** Add the statistics of another instance. */
+        void merge( const PairStatistics & other ) {
+          tests    += other.tests;
+          accepted += other.accepted;
+          cycles   += other.cycles;
+
+          if ( paths.size() < other.paths.size() )
+            paths.resize( other.paths.size(), 0ul );
+          for ( unsigned int i = 0u; i < other.paths.size(); ++i )
+            paths[i] += other.paths[i];
+        }
+      };
+
+      /** Statistics per triple of species, keyed by the sorted species. */
+      typedef std::map<Input, PairStatistics> TripleTable;
+
+
+      /* MEMBER STORAGE */
+      /** Sum of the number of tests computed by the driver. */
+      double planned_tests;
+
+    private:
+      /** Number of species for which stats is sized. */
+      unsigned int n_species;
+
+      /** Statistics per pair of species (A <= B), stored as
+       * stats[A * n_species + B]. */
+      std::vector<PairStatistics> stats;
+
+      /** Statistics per triple of species. */
+      TripleTable triple_stats;
+
+      /** Counter value at the last call to beginPairType. */
+      double started;
+
+
+      /* MEMBER FUNCTIONS */
+    public:
+      /** Constructor. */
+      StatisticsMonitor()
+        : planned_tests( 0.0 ), n_species( 0u ), stats(), triple_stats(),
+          started( 0.0 ) { }
+
+      /** Record the result of a pair test. */
+      template < typename ChimpDB,
+                 typename PIter,
+                 typename BackInsertionSequence >
+      void interactions( const ChimpDB & db,
+                         const std::pair<PIter, PIter> & pair,
+                         const std::pair<int,double> & path,
+                         const BackInsertionSequence & result_list ) {
+        using chimp::accessors::particle::species;
+
+        record( at( species(*pair.first), species(*pair.second) ), path );
+      }
+
+      /** Record the result of a triple test. */
+      template < typename ChimpDB,
+                 typename PIter,
+                 typename BackInsertionSequence >
+      void interactions( const ChimpDB & db,
+                         const Triple<PIter> & triple,
+                         const std::pair<int,double> & path,
+                         const BackInsertionSequence & result_list ) {
+        using chimp::accessors::particle::species;
+
+        record( triple_stats[ sortedInput( species(*triple.first),
+                                           species(*triple.second),
+                                           species(*triple.third) ) ],
+                path );
+      }
+
+      /** Record the number of tests computed for a pair (or triple) of
+       * species. */
+      void pairtests( const double & number_of_pairtests ) {
+        planned_tests += number_of_pairtests;
+      }
+
+      /** Called by the driver before the pairs of species A and B of a cell
+       * are tested. */
+      void beginPairType( const unsigned int & A, const unsigned int & B ) {
+        if ( timing )
+          started = detail::readCycleCounter();
+      }
+
+      /** Called by the driver after the pairs of species A and B of a cell
+       * are tested. */
+      void endPairType( const unsigned int & A, const unsigned int & B ) {
+        if ( timing )
+          at(A,B).cycles += detail::readCycleCounter() - started;
+      }
+
+      /** Add the statistics of another monitor to this one. */
+      void merge( const StatisticsMonitor & other ) {
+        planned_tests += other.planned_tests;
+        for ( unsigned int A = 0u; A < other.n_species; ++A )
+          for ( unsigned int B = A; B < other.n_species; ++B )
+            at(A,B).merge( other.stats[A * other.n_species + B] );
+
+        for ( typename TripleTable::const_iterator
+                i  = other.triple_stats.begin();
+                i != other.triple_stats.end(); ++i )
+          triple_stats[i->first].merge( i->second );
+      }
+
+      /** Zero all statistics. */
+      void reset() {
+        planned_tests = 0.0;
+        stats.assign( stats.size(), PairStatistics() );
+        triple_stats.clear();
+      }
+
+      /** The statistics of species A and B (in either order). */
+      PairStatistics get( const unsigned int & A,
+                          const unsigned int & B ) const {
+        const unsigned int a = std::min(A,B), b = std::max(A,B);
+        if ( b >= n_species )
+          return PairStatistics();
+        return stats[a * n_species + b];
+      }
+
+      /** The statistics of species A, B, and C (in any order). */
+      PairStatistics get( const unsigned int & A,
+                          const unsigned int & B,
+                          const unsigned int & C ) const {
+        typename TripleTable::const_iterator i =
+          triple_stats.find( sortedInput( A, B, C ) );
+        if ( i == triple_stats.end() )
+          return PairStatistics();
+        return i->second;
+      }
+
+      /** Write the statistics as CSV rows, one per pair (or triple) of
+       * species with equation "all", followed by one per equation selected
+       * at least once (where the accepted column is the number of times the
+       * equation was selected).  The C column is empty for pairs.  All
+       * string fields are quoted.
+       *
+       * @param label
+       *    Value of the first column, such as the timestep.
+       */
+      template < typename RnDB >
+      std::ostream & writeCSV( std::ostream & out,
+                               const RnDB & db,
+                               const std::string & label ) const {
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
+          for ( unsigned int B = A; B < n_species; ++B ) {
+            const PairStatistics & s = stats[A * n_species + B];
+            if ( s.tests == 0ul )
+              continue;
+
+            std::ostringstream columns;
+            detail::writeCSVString( columns, label ) << ',';
+            detail::writeCSVString( columns, speciesName(db,A) ) << ',';
+            detail::writeCSVString( columns, speciesName(db,B) ) << ",\"\",";
+
+            writeCSVRows( out, db, columns.str(), s, pairSet(db,A,B) );
+          }
+        }
+
+        for ( typename TripleTable::const_iterator i  = triple_stats.begin();
+                                                   i != triple_stats.end();
+                                                   ++i ) {
+          const Input & in = i->first;
+          if ( i->second.tests == 0ul )
+            continue;
+
+          std::ostringstream columns;
+          detail::writeCSVString( columns, label ) << ',';
+          detail::writeCSVString( columns, speciesName(db,in.A.species) )
+            << ',';
+          detail::writeCSVString( columns, speciesName(db,in.B.species) )
+            << ',';
+          detail::writeCSVString( columns, speciesName(db,in.C.species) )
+            << ',';
+
+          writeCSVRows( out, db, columns.str(), i->second, tripleSet(db,in) );
+        }
+
+        return out;
+      }
+
+      /** Write the header line of writeCSV. */
+      static std::ostream & writeCSVHeader( std::ostream & out ) {
+        return out << "label,A,B,C,equation,tests,accepted,cycles\n";
+      }
+
+      /** Write the statistics as a JSON object. */
+      template < typename RnDB >
+      std::ostream & writeJSON( std::ostream & out,
+                                const RnDB & db,
+                                const std::string & label ) const {
+        using detail::writeJSONString;
+
+        out << "{\"label\": ";
+        writeJSONString( out, label );
+        out << ", \"planned_tests\": " << planned_tests << ", \"pairs\": [";
+
+        bool first_pair = true;
+        for ( unsigned int A = 0u; A < n_species; ++A ) {
+          for ( unsigned int B = A; B < n_species; ++B ) {
+            const PairStatistics & s = stats[A * n_species + B];
+            if ( s.tests == 0ul )
+              continue;
+
+            out << ( first_pair ? "\n  {" : ",\n  {" ) << "\"A\": ";
+            writeJSONString( out, speciesName(db,A) ) << ", \"B\": ";
+            writeJSONString( out, speciesName(db,B) );
+            writeJSONStatistics( out, db, s, pairSet(db,A,B) );
+            first_pair = false;
+          }
+        }
+
+        out << "\n], \"triples\": [";
+
+        bool first_triple = true;
+        for ( typename TripleTable::const_iterator i  = triple_stats.begin();
+                                                   i != triple_stats.end();
+                                                   ++i ) {
+          const Input & in = i->first;
+          if ( i->second.tests == 0ul )
+            continue;
+
+          out << ( first_triple ? "\n  {" : ",\n  {" ) << "\"A\": ";
+          writeJSONString( out, speciesName(db,in.A.species) ) << ", \"B\": ";
+          writeJSONString( out, speciesName(db,in.B.species) ) << ", \"C\": ";
+          writeJSONString( out, speciesName(db,in.C.species) );
+          writeJSONStatistics( out, db, i->second, tripleSet(db,in) );
+          first_triple = false;
+        }
+
+        return out << "\n]}\n";
+      }
+
+    private:
+      /** Count a test with the given result in s. */
+      static void record( PairStatistics & s,
+                          const std::pair<int,double> & path ) {
+        ++s.tests;
+
+        if ( path.first < 0 )
+          return;
+
+        ++s.accepted;
+        if ( s.paths.size() <= static_cast<unsigned int>( path.first ) )
+          s.paths.resize( path.first + 1u, 0ul );
+        ++s.paths[path.first];
+      }
+
+      /** The Input of species A, B, and C sorted by species. */
+      static Input sortedInput( const int & A, const int & B, const int & C ) {
+        int s[3] = { A, B, C };
+        std::sort( s, s + 3 );
+        return Input( s[0], s[1], s[2] );
+      }
+
+      /** The (mutable) statistics of species A and B (in either order). */
+      PairStatistics & at( const unsigned int & A, const unsigned int & B ) {
+        const unsigned int a = std::min(A,B), b = std::max(A,B);
+
+        if ( b >= n_species ) {
+          /* grow the table, keeping the current statistics. */
+          const unsigned int n = b + 1u;
+          std::vector<PairStatistics> grown( n * n );
+          for ( unsigned int i = 0u; i < n_species; ++i )
+            for ( unsigned int j = i; j < n_species; ++j )
+              grown[i * n + j] = stats[i * n_species + j];
+          stats.swap( grown );
+          n_species = n;
+        }
+
+        return stats[a * n_species + b];
+      }
+
+      /** Name of species A. */
+      template < typename RnDB >
+      static std::string speciesName( const RnDB & db,
+                                      const unsigned int & A ) {
+        if ( A >= db.getProps().size() )
+          return "?";
+        using property::name;
+        return db[A].name::value;
+      }
+
+      /** The interaction Set of species A and B, or 0 if unknown. */
+      template < typename RnDB >
+      static const typename RnDB::Set * pairSet( const RnDB & db,
+                                                 const unsigned int & A,
+                                                 const unsigned int & B ) {
+        if ( A >= db.getProps().size() || B >= db.getProps().size() )
+          return 0;
+        return &db(A,B);
+      }
+
+      /** The interaction Set of the given three inputs, or 0 if unknown. */
+      template < typename RnDB >
+      static const typename RnDB::Set * tripleSet( const RnDB & db,
+                                                   const Input & in ) {
+        typedef typename RnDB::TernaryInteractionTable Table;
+        const Table & table = db.getTernaryInteractions();
+        typename Table::const_iterator i = table.find( in );
+        if ( i == table.end() )
+          return 0;
+        return &i->second;
+      }
+
+      /** Printed form of equation i of the given Set (or "#i" if unknown). */
+      template < typename RnDB >
+      static std::string equation( const RnDB & db,
+                                   const typename RnDB::Set * set,
+                                   const unsigned int & i ) {
+        std::ostringstream out;
+        if ( set && i < set->rhs.size() )
+          set->rhs[i].print( out, db );
+        else
+          out << '#' << i;
+        return out.str();
+      }
+
+      /** Write the CSV rows of the statistics s, each starting with the
+       * given (label and species) columns (see writeCSV). */
+      template < typename RnDB >
+      static void writeCSVRows( std::ostream & out,
+                                const RnDB & db,
+                                const std::string & columns,
+                                const PairStatistics & s,
+                                const typename RnDB::Set * set ) {
+        detail::writeCSVString( out << columns, "all" )
+          << ',' << s.tests << ',' << s.accepted << ',' << s.cycles << '\n';
+
+        for ( unsigned int i = 0u; i < s.paths.size(); ++i ) {
+          if ( s.paths[i] == 0ul )
+            continue;
+          detail::writeCSVString( out << columns, equation(db,set,i) )
+            << ',' << s.tests << ',' << s.paths[i] << ",\n";
+        }
+      }
+
+      /** Write the counters and equations of the statistics s as the rest
+       * of a JSON object (see writeJSON). */
+      template < typename RnDB >
+      static void writeJSONStatistics( std::ostream & out,
+                                       const RnDB & db,
+                                       const PairStatistics & s,
+                                       const typename RnDB::Set * set ) {
+        out << ", \"tests\": " << s.tests
+            << ", \"accepted\": " << s.accepted
+            << ", \"cycles\": " << s.cycles
+            << ", \"equations\": [";
+
+        bool first_eq = true;
+        for ( unsigned int i = 0u; i < s.paths.size(); ++i ) {
+          if ( s.paths[i] == 0ul )
+            continue;
+          out << ( first_eq ? "{" : ", {" ) << "\"equation\": ";
+          detail::writeJSONString( out, equation(db,set,i) )
+            << ", \"selected\": " << s.paths[i] << '}';
+          first_eq = false;
+        }
+
+        out << "]}";
+      }
+    };
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_StatisticsMonitor_h
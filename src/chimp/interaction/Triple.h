@@ -0,0 +1,140 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Definition of the Triple of particles of three-body interactions, its
+ * random selection, and its effective relative speed.
+ * */
+
+#ifndef chimp_interaction_Triple_h
+#define chimp_interaction_Triple_h
+
+#include <chimp/accessors.h>
+
+#include <xylose/power.h>
+#include <xylose/compat/math.hpp>
+
+namespace chimp {
+  namespace interaction {
+
+    /** Three particles (by iterator) that are tested for a three-body
+     * interaction, similar to the std::pair of two-body interactions. */
+    template < typename PIter >
+    struct Triple {
+      /* MEMBER STORAGE */
+      PIter first;
+      PIter second;
+      PIter third;
+
+
+      /* MEMBER FUNCTIONS */
+      /** Default constructor. */
+      Triple() : first(), second(), third() { }
+
+      /** Constructor. */
+      Triple( const PIter & first, const PIter & second, const PIter & third )
+        : first( first ), second( second ), third( third ) { }
+    };
+
+    /** Select three distinct particles at random, one from each of the
+     * given ranges.  The ranges may be identical (for inputs of the same
+     * species) but must then contain enough particles.
+     */
+    template <
+      typename RandomAccessParticleContainer,
+      typename RNG
+    >
+    inline
+    Triple< typename RandomAccessParticleContainer::iterator >
+    selectRandomTriple( RandomAccessParticleContainer & Aparticles,
+                        RandomAccessParticleContainer & Bparticles,
+                        RandomAccessParticleContainer & Cparticles,
+                        RNG & rng ) {
+      typedef typename RandomAccessParticleContainer::iterator PIter;
+      const unsigned int Asz = Aparticles.size();
+      const unsigned int Bsz = Bparticles.size();
+      const unsigned int Csz = Cparticles.size();
+
+      /* First pick pA */
+      PIter pA = Aparticles.begin()
+               + static_cast<int>( Asz * rng.randExc() );
+
+      /* now we pick pB */
+      PIter pB = pA;
+      PIter Bbegin = Bparticles.begin();
+      while ( pB == pA )
+        pB = Bbegin + static_cast<int>( Bsz * rng.randExc() );
+
+      /* and finally pC */
+      PIter pC = pA;
+      PIter Cbegin = Cparticles.begin();
+      while ( pC == pA || pC == pB )
+        pC = Cbegin + static_cast<int>( Csz * rng.randExc() );
+
+      return Triple<PIter>( pA, pB, pC );
+    }
+
+    /** Kinetic energy of three particles in their center of mass frame,
+     * given the masses of the particles.  This is
+     * \f$ \sum_{i<j} m_i m_j g_{ij}^2 / ( 2 M ) \f$, where \f$ g_{ij} \f$
+     * are the relative speeds of the pairs and \f$ M \f$ is the total mass.
+     */
+    template < typename Particle >
+    inline double tripleEnergy( const Particle & pA,
+                                const Particle & pB,
+                                const Particle & pC,
+                                const double & mA,
+                                const double & mB,
+                                const double & mC ) {
+      using xylose::SQR;
+      using chimp::accessors::particle::velocity;
+
+      return ( mA * mB * SQR( (velocity(pA) - velocity(pB)).abs() ) +
+               mA * mC * SQR( (velocity(pA) - velocity(pC)).abs() ) +
+               mB * mC * SQR( (velocity(pB) - velocity(pC)).abs() ) )
+           / ( 2.0 * ( mA + mB + mC ) );
+    }
+
+    /** The effective relative speed of three particles at which the cross
+     * sections of three-body equations are evaluated.  This is the speed v
+     * such that 0.5 * mu * v^2 is the kinetic energy of the particles in
+     * their center of mass frame (see tripleEnergy), where mu is the reduced
+     * mass of the first two particles (see Equation::reducedMass).  If the
+     * third particle moves with the center of mass of the first two, v is
+     * therefore the relative speed of the first two particles.
+     */
+    template < typename Particle >
+    inline double tripleSpeed( const Particle & pA,
+                               const Particle & pB,
+                               const Particle & pC,
+                               const double & mA,
+                               const double & mB,
+                               const double & mC,
+                               const double & mu ) {
+      return std::sqrt( 2.0 * tripleEnergy( pA, pB, pC, mA, mB, mC ) / mu );
+    }
+
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_Triple_h
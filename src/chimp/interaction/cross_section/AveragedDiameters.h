@@ -39,6 +39,8 @@
 
 #include <stdexcept>
 #include <ostream>
+#include <vector>
+#include <cmath>
 
 namespace chimp {
   namespace xml = xylose::xml;
@@ -47,7 +49,11 @@ namespace chimp {
   namespace interaction {
     namespace cross_section {
 
-      /** Averaged cross section provider.
+      /** Averaged cross section provider.  The averaged-diameter cross section
+       *    0.25 * ( sqrt(sigma0(v)) + sqrt(sigma1(v)) )^2
+       * is tabulated into the DATA table either on a uniform grid or by
+       * adaptive refinement (see buildAdaptive).
+       *
        * @tparam options
        *    The RuntimeDB template options (see make_options::type for the
        *    default options class).  
@@ -69,23 +75,82 @@ namespace chimp {
 
 
         /* MEMBER FUNCTIONS */
-        /** Constructor to initialize the cross section data by copying from a
-         * set of data previously loaded. */
+        /** Constructor to initialize the cross section data by evaluating the
+         * sub-cross-sections.
+         *
+         * @param cs0
+         *    The first sub-cross-section.
+         * @param cs1
+         *    The second sub-cross-section.
+         * @param vmax
+         *    Upper limit of the tabulated range.
+         * @param dv
+         *    Resolution of a uniform table.  If dv <= 0, the table is built
+         *    adaptively instead (see buildAdaptive).
+         * @param tolerance
+         *    Relative tolerance of the adaptive table (only used if dv <= 0).
+         * */
         AveragedDiameters( const CSPtr & cs0, const CSPtr & cs1,
-                           const double & vmax, const double & dv )
+                           const double & vmax, const double & dv,
+                           const double & tolerance = 1e-3 )
           : cross_section::DATA<options>(), cs0(cs0), cs1(cs1) {
 
-          cross_section::Base<options> & sigma0 = *cs0,
-                                       & sigma1 = *cs1;
+          if ( dv <= 0.0 ) {
+            buildAdaptive( vmax, tolerance );
+            return;
+          }
+
+          DoubleDataSet new_table;
+
+          for ( double v = vmax + 0.5*dv; v > 0.0; v -= dv )
+            new_table.insert( std::make_pair( v, exact(v) ) );
+
+          this->setTable( new_table );
+        }
+
+        /** Evaluate the averaged-diameter cross section directly from the
+         * sub-cross-sections. */
+        double exact( const double & v ) const {
           using xylose::SQR;
+          return 0.25 * SQR( sqrt((*cs0)(v)) + sqrt((*cs1)(v)) );
+        }
 
+        /** Build the table by adaptive refinement.  The table is seeded with
+         * log-spaced points in [vmax * v_min_fraction, vmax] so that the
+         * structure at low velocities is captured.  Each interval is then
+         * bisected until linear interpolation at its midpoint agrees with the
+         * exact averaged-diameter formula within the relative tolerance.
+         *
+         * @param vmax
+         *    Upper limit of the tabulated range.
+         * @param tolerance
+         *    Relative tolerance of the interpolation.
+         * @param v_min_fraction
+         *    Lower limit of the seeds, relative to vmax.
+         * @param n_seeds
+         *    Number of log-spaced seeds.
+         * */
+        void buildAdaptive( const double & vmax,
+                            const double & tolerance,
+                            const double & v_min_fraction = 1e-6,
+                            const unsigned int & n_seeds = 32u ) {
           DoubleDataSet new_table;
 
-          for ( double v = vmax + 0.5*dv; v > 0.0; v -= dv ) {
-            double sigma = 0.25 * SQR( sqrt(sigma0(v)) + sqrt(sigma1(v)) );
-            new_table.insert( std::make_pair( v, sigma ) );
+          const double v_min = vmax * v_min_fraction;
+          const double ratio
+            = std::pow( 1.0 / v_min_fraction, 1.0 / (n_seeds - 1u) );
+
+          std::vector<double> v( n_seeds ), sigma( n_seeds );
+          for ( unsigned int k = 0u; k < n_seeds; ++k ) {
+            v[k] = ( k + 1u == n_seeds ? vmax : v_min * std::pow(ratio, double(k)) );
+            sigma[k] = exact( v[k] );
+            new_table.insert( std::make_pair( v[k], sigma[k] ) );
           }
 
+          for ( unsigned int k = 0u; k + 1u < n_seeds; ++k )
+            refine( v[k], sigma[k], v[k+1], sigma[k+1], tolerance, 0u,
+                    new_table );
+
           this->setTable( new_table );
         }
 
@@ -111,6 +176,28 @@ namespace chimp {
           return out;
         }
 
+      private:
+        /** Recursively bisect [a,b] until the midpoint interpolation error is
+         * within tolerance. */
+        void refine( const double & a, const double & sa,
+                     const double & b, const double & sb,
+                     const double & tolerance,
+                     const unsigned int & depth,
+                     DoubleDataSet & table ) const {
+          /* limit the depth for discontinuous (or nearly so) data. */
+          if ( depth >= 40u )
+            return;
+
+          const double m = 0.5 * ( a + b );
+          const double sm = exact( m );
+          if ( std::abs( 0.5 * ( sa + sb ) - sm ) <= tolerance * std::abs(sm) )
+            return;
+
+          table.insert( std::make_pair( m, sm ) );
+          refine( a, sa, m, sm, tolerance, depth + 1u, table );
+          refine( m, sm, b, sb, tolerance, depth + 1u, table );
+        }
+
       };
 
       template < typename options >
@@ -61,6 +61,25 @@ namespace chimp {
          * */
         virtual double operator() (const double & v_relative) const  = 0;
 
+        /** Compute the cross section for a batch of relative speeds.  This
+         * default implementation simply calls operator()(double) for each
+         * value.  Derived classes should override this to avoid the virtual
+         * call per value and to use the batch kernels where possible.
+         *
+         * @param v_relative
+         *     Array of n relative speeds.
+         * @param sigma
+         *     [output] Array of n cross sections.
+         * @param n
+         *     Number of values.
+         * */
+        virtual void evaluate( const double * v_relative,
+                               double * sigma,
+                               const unsigned int & n ) const {
+          for ( unsigned int i = 0u; i < n; ++i )
+            sigma[i] = this->operator()( v_relative[i] );
+        }
+
         /** Find the local maximum of cross-section*velocity (within a given
          * range of velocity space.  The actual implementation of this function is
          * done by the specific cross section model. 
@@ -81,6 +100,42 @@ namespace chimp {
         virtual std::pair<double,double>
         findMaxSigmaV(const double & v_rel_max) const = 0;
 
+        /** Compute the derivative of the product v_relative * sigma with
+         * respect to v_relative.  This default implementation uses a central
+         * difference.  Derived classes should override this with the analytic
+         * derivative where possible.
+         *
+         * @param v_relative
+         *     The relative velocity (> 0) of the two particles in question.
+         * */
+        virtual double dSigmaV(const double & v_relative) const {
+          const double h = 1e-6 * v_relative;
+          const double vp = v_relative + h;
+          const double vm = v_relative - h;
+          return ( vp * this->operator()(vp) - vm * this->operator()(vm) )
+               / ( 2.0 * h );
+        }
+
+        /** Append the relative speeds within (0, v_rel_max] at which the cross
+         * section or its derivative may be discontinuous (such as thresholds
+         * and the knots of tabulated data).  Between these points, the
+         * product v*sigma is assumed to be smooth, such that its maxima may be
+         * found from the roots of dSigmaV.  This default implementation adds
+         * no points.
+         * */
+        virtual void getBreakpoints( const double & v_rel_max,
+                                     std::vector<double> & v ) const { }
+
+        /** Whether every extremum of v*sigma can be found from dSigmaV and
+         * getBreakpoints (see Set::tabulateMaxSigmaV).  This requires that
+         * dSigmaV is analytic (or at least accurate) and that v*sigma varies
+         * slowly enough between the breakpoints that sampling each segment
+         * brackets all of its extrema.  Sets which contain any cross section
+         * for which this is not true fall back to findMaxSigmaV.  This
+         * default implementation returns false.
+         * */
+        virtual bool hasExactExtrema() const { return false; }
+
         /** Load a new instance of cross_section::Base. */
         virtual Base * new_load( const xml::Context & x,
                                  const interaction::Equation<options> & eq,
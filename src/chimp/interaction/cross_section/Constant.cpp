@@ -39,9 +39,12 @@ namespace chimp {
         using runtime::physical::Quantity;
         using runtime::physical::unit::m;
 
-        double loadConstantValue( const xml::Context & x ) {
+        double loadConstantValue( const xml::Context & x,
+                                  const bool & ternary ) {
           static const Quantity m2  = m*m;
-          return x.query<Quantity>("value").assertMatch(m2).getCoeff<double>();
+          static const Quantity m5  = m2*m2*m;
+          return x.query<Quantity>("value")
+                  .assertMatch( ternary ? m5 : m2 ).getCoeff<double>();
         }
 
       } /* namespace chimp::interaction::cross_section::detail */
@@ -35,6 +35,7 @@
 
 #include <ostream>
 #include <string>
+#include <algorithm>
 
 namespace chimp {
   namespace xml = xylose::xml;
@@ -43,7 +44,10 @@ namespace chimp {
     namespace cross_section {
 
       namespace detail {
-        double loadConstantValue( const xml::Context & x );
+        /** Load the constant cross section value in units of m^2, or m^5 for
+         * three-body (ternary) equations. */
+        double loadConstantValue( const xml::Context & x,
+                                  const bool & ternary = false );
       }
 
       /** Constant cross section provider.
@@ -72,9 +76,13 @@ namespace chimp {
         Constant()
           : cross_section::Base<options>(), value(0.0) { }
 
-        /** Constructor to load from specific xml context. */
-        Constant( const xml::Context & x )
-          : value( detail::loadConstantValue(x) ) { }
+        /** Constructor to load from specific xml context.
+         * @param ternary
+         *    Whether the value is for a three-body equation (see
+         *    Equation::cs).
+         */
+        Constant( const xml::Context & x, const bool & ternary = false )
+          : value( detail::loadConstantValue(x, ternary) ) { }
 
         /** Constructor to initialize the cross section specifically. */
         Constant( const double & value )
@@ -92,6 +100,13 @@ namespace chimp {
           return value;
         }
 
+        /** Compute the cross section for a batch of relative speeds. */
+        virtual void evaluate( const double * v_relative,
+                               double * sigma,
+                               const unsigned int & n ) const {
+          std::fill( sigma, sigma + n, value );
+        }
+
         /** Determine by inspection the maximum value of the product v_rel *
          * cross_section given a specific maximum v_rel to include in the search.
          *
@@ -105,10 +120,18 @@ namespace chimp {
           return std::make_pair( value * v_rel_max, v_rel_max);
         }
 
+        /** Compute D[v*sigma, v] = sigma. */
+        virtual double dSigmaV(const double & v_relative) const {
+          return value;
+        }
+
+        /** v*sigma is linear in v. */
+        virtual bool hasExactExtrema() const { return true; }
+
         virtual Constant * new_load( const xml::Context & x,
                                  const interaction::Equation<options> & eq,
                                  const RuntimeDB<options> & db ) const {
-          return new Constant( x );
+          return new Constant( x, eq.isTernary() );
         }
 
         /** Obtain the label of the model. */
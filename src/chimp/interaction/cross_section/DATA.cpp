@@ -44,9 +44,10 @@ namespace chimp {
       typedef xylose::data_set<Quantity,Quantity> pqdata_set;
 
       DoubleDataSet loadCrossSectionData( const xml::Context & x,
-                                          const ReducedMass & mu ) {
+                                          const ReducedMass & mu,
+                                          const bool & ternary ) {
         const Quantity m_s = m/s;
-        const Quantity m2  = m*m;
+        const Quantity cs_u = ternary ? m*m*m*m*m : m*m;
         DoubleDataSet table;
         pqdata_set pqd = x.parse<pqdata_set>();
         /* convert x-val to velocity units. */
@@ -59,7 +60,7 @@ namespace chimp {
 
           register double v_coeff, m2_coeff;
           v.assertMatch(m_s).getCoeff(v_coeff);
-          i->second.assertMatch(m2).getCoeff(m2_coeff);
+          i->second.assertMatch(cs_u).getCoeff(m2_coeff);
 
           table.insert( std::make_pair( v_coeff, m2_coeff ) );
         }
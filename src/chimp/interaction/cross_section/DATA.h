@@ -43,8 +43,11 @@
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include <cstdlib>
+#include <cmath>
 
 namespace chimp {
   namespace xml = xylose::xml;
@@ -63,17 +66,55 @@ namespace chimp {
        *     cross-section data set.
        * @param mu
        *     Reduced mass of particles in question.
+       * @param ternary
+       *     Whether the data is for a three-body equation, such that the cross
+       *     section has units of m^5 instead of m^2 (see Equation::cs).
        * */
       DoubleDataSet loadCrossSectionData( const xml::Context & x,
-                                          const ReducedMass & mu );
+                                          const ReducedMass & mu,
+                                          const bool & ternary = false );
 
       /** Emperical data cross section provider.
+       *
+       * By default, the cross section is interpolated by searching the
+       * original table of data.  Optionally, the table can be resampled onto a
+       * contiguous grid that is uniform in v or in log(v) such that the bin is
+       * found by arithmetic rather than by a search (see DATA::resample).  The
+       * resampling can also be requested by setting the
+       * CHIMP_CROSS_SECTION_DATA_GRID environment variable to 'uniform' or
+       * 'log'.  The tolerance of the resampled grid, relative to the maximum
+       * cross section of the table, is then taken from the
+       * CHIMP_CROSS_SECTION_DATA_GRID_TOLERANCE environment variable
+       * [Default: 1e-3].
+       *
        * @tparam options
        *    The RuntimeDB template options (see make_options::type for the
        *    default options class).  
        */
       template < typename options >
       class DATA : public cross_section::Base<options> {
+        /* TYPEDEFS */
+      public:
+        /** Spacing of the optional resampled lookup grid. */
+        enum GRID_SPACING {
+          /** No resampled grid; the original table is searched. */
+          NO_GRID,
+          /** Grid is uniform in v. */
+          UNIFORM_GRID,
+          /** Grid is uniform in log(v). */
+          LOG_GRID
+        };
+
+      private:
+        /** Node of the resampled grid.  The cross section within the bin
+         * starting at this node is sigma + slope * (v_rel - v). */
+        struct GridNode {
+          double v;
+          double sigma;
+          double slope;
+        };
+
+
         /* STATIC STORAGE */
       public:
         static const std::string label;
@@ -96,9 +137,43 @@ namespace chimp {
         /** Extrapolation coeff.    v^2 in C*b*ln(a*(v^2-v0^2+b)/(a*(v^2-v0^2+b). */
         double v02;
 
-        /** Extrapolation warning issued already. */
+        /** Number of extrapolations done.  This is counted atomically since
+         * the cross section may be evaluated concurrently (such as by
+         * ParallelDriver). */
         mutable unsigned int extraps_done;
 
+        /** Resampled lookup grid (empty if not resampled). */
+        std::vector<GridNode> grid;
+
+        /** Spacing of the resampled grid. */
+        enum GRID_SPACING grid_spacing;
+
+        /** Lower limit of the resampled grid in v or log(v). */
+        double grid_x0;
+
+        /** Inverse of the bin width of the resampled grid in v or log(v). */
+        double grid_dx_inv;
+
+        /** Lower limit (exclusive) of v covered by the resampled grid. */
+        double grid_v0;
+
+        /** Upper limit (exclusive) of v covered by the resampled grid. */
+        double grid_v1;
+
+        /** Contiguous copy of the velocities of the table. */
+        std::vector<double> knot_v;
+
+        /** Contiguous copy of the cross sections of the table. */
+        std::vector<double> knot_sigma;
+
+        /** Running maximum of v*sigma over the table:  max_sigma_v[i] is the
+         * maximum of knot_v[j]*knot_sigma[j] for j <= i. */
+        std::vector<double> max_sigma_v;
+
+        /** Velocity at which max_sigma_v[i] occurs (the first such velocity).
+         * */
+        std::vector<double> max_sigma_v_at;
+
 
         /* MEMBER FUNCTIONS */
       public:
@@ -107,13 +182,22 @@ namespace chimp {
          * DATA::new_load. 
          */
         DATA()
-          : cross_section::Base<options>(), a(0.0), b(0.0), extraps_done(0u) { }
-
-        /** Constructor with the reduced mass already specified. */
+          : cross_section::Base<options>(), a(0.0), b(0.0), extraps_done(0u),
+            grid_spacing(NO_GRID), grid_x0(0.0), grid_dx_inv(0.0),
+            grid_v0(0.0), grid_v1(0.0) { }
+
+        /** Constructor with the reduced mass already specified.
+         * @param ternary
+         *    Whether the data is for a three-body equation (see
+         *    loadCrossSectionData).
+         */
         DATA( const xml::Context & x,
-              const ReducedMass & mu )
-          : table( loadCrossSectionData(x, mu ) ) {
+              const ReducedMass & mu,
+              const bool & ternary = false )
+          : table( loadCrossSectionData(x, mu, ternary ) ) {
           setCoeffs();
+          setMaxSigmaV();
+          resampleFromEnvironment();
         }
 
         /** Constructor to initialize the cross section data by copying from a
@@ -121,6 +205,8 @@ namespace chimp {
         DATA( const DoubleDataSet & table )
           : cross_section::Base<options>(), table( table ) {
           setCoeffs();
+          setMaxSigmaV();
+          resampleFromEnvironment();
         }
 
         /** Virtual NO-OP destructor. */
@@ -132,10 +218,31 @@ namespace chimp {
          *     The relative velocity between two particles.
          * */
         inline virtual double operator() (const double & v_relative) const {
+          if ( v_relative > grid_v0 && v_relative < grid_v1 )
+            return evalGrid( v_relative );
+
           /* find the first entry not less that v_relative */
           return this->eval( table.lower_bound(v_relative), v_relative );
         }
 
+        /** Interpolate the cross-section for a batch of relative speeds. */
+        virtual void evaluate( const double * v_relative,
+                               double * sigma,
+                               const unsigned int & n ) const {
+          for ( unsigned int i = 0u; i < n; ++i )
+            sigma[i] = DATA::operator()( v_relative[i] );
+        }
+
+        /** Interpolate the cross-section from the original table of data,
+         * regardless of whether a resampled grid is in use.
+         *
+         * @param v_relative
+         *     The relative velocity between two particles.
+         * */
+        inline double evalTable(const double & v_relative) const {
+          return this->eval( table.lower_bound(v_relative), v_relative );
+        }
+
         /** Determine by inspection the maximum value of the product v_rel *
          * cross_section given a specific maximum v_rel to include in the search.
          *
@@ -146,17 +253,17 @@ namespace chimp {
          */
         virtual std::pair<double,double>
         findMaxSigmaV(const double & v_rel_max) const {
-          /* search through the data within the range [0:v_rel_max) to find
-           * maximum product. */
+          /* the maximum product of the data within the range [0:v_rel_max) is
+           * taken from the running maximum at the last entry less than
+           * v_rel_max. */
           std::pair<double,double> retval = std::make_pair(0.0,0.0);
           /* find the first entry not less than v_rel_max */
-          const DoubleDataSet::const_iterator e = table.lower_bound(v_rel_max);
-          for (DoubleDataSet::const_iterator i = table.begin(); i != e; ++i) {
-            double prod_i = i->first * i->second;
-            if (retval.first < prod_i) {
-              retval.first = prod_i;
-              retval.second = i->first;
-            }
+          const unsigned int k =
+            std::lower_bound( knot_v.begin(), knot_v.end(), v_rel_max )
+            - knot_v.begin();
+          if ( k > 0u && max_sigma_v[k-1u] > 0.0 ) {
+            retval.first  = max_sigma_v[k-1u];
+            retval.second = max_sigma_v_at[k-1u];
           }
 
           /* make one last ditch effort to find (v*sigma)_max by determining the
@@ -165,7 +272,18 @@ namespace chimp {
            * extrapolations should only be allowed for functions that can be
            * approximated by a decaying ln(E)/E curve. */
           {
-            double prod_interp = v_rel_max * this->eval(e, v_rel_max);
+            double sigma_interp = 0.0;
+            if ( k > 0u && k < knot_v.size() ) {
+              /* normal lever rule (same as eval) */
+              const unsigned int i = k - 1u;
+              double L_inv = 1.0/(knot_v[k] - knot_v[i]);
+              sigma_interp = knot_sigma[i] * L_inv * (knot_v[k] - v_rel_max) +
+                             knot_sigma[k] * L_inv * (v_rel_max - knot_v[i]);
+            } else if ( k > 0u ) {
+              sigma_interp = this->eval( table.end(), v_rel_max );
+            }
+
+            double prod_interp = v_rel_max * sigma_interp;
             if ( retval.first < prod_interp ) {
               retval.first = prod_interp;
               retval.second = v_rel_max;
@@ -175,10 +293,40 @@ namespace chimp {
           return retval;
         }
 
+        /** Compute D[v*sigma, v] of the interpolated data.  Between two knots,
+         * this is sigma + v * (slope of the segment).  Beyond the table, the
+         * derivative of the extrapolation is computed numerically. */
+        virtual double dSigmaV(const double & v_relative) const {
+          const unsigned int k =
+            std::lower_bound( knot_v.begin(), knot_v.end(), v_relative )
+            - knot_v.begin();
+          if ( k == 0u )
+            return 0.0;
+          else if ( k == knot_v.size() )
+            return cross_section::Base<options>::dSigmaV( v_relative );
+
+          const unsigned int i = k - 1u;
+          const double slope = ( knot_sigma[k] - knot_sigma[i] )
+                             / ( knot_v[k] - knot_v[i] );
+          return knot_sigma[i] + slope * ( 2.0 * v_relative - knot_v[i] );
+        }
+
+        /** The interpolated data is only smooth between the knots of the
+         * table. */
+        virtual void getBreakpoints( const double & v_rel_max,
+                                     std::vector<double> & v ) const {
+          v.insert( v.end(), knot_v.begin(),
+                    std::upper_bound( knot_v.begin(), knot_v.end(), v_rel_max ) );
+        }
+
+        /** v*sigma is quadratic between the knots of the table and follows the
+         * smooth ln(E)/E extrapolation beyond them. */
+        virtual bool hasExactExtrema() const { return true; }
+
         virtual DATA * new_load( const xml::Context & x,
                                  const interaction::Equation<options> & eq,
                                  const RuntimeDB<options> & db ) const {
-          return new DATA( x, eq.reducedMass );
+          return new DATA( x, eq.reducedMass, eq.isTernary() );
         }
 
         /** Obtain the label of the model. */
@@ -192,10 +340,134 @@ namespace chimp {
           return out;
         }
 
-        /** Set the table explicitly. */
+        /** Set the table explicitly.  Any resampled grid is recomputed with
+         * the same spacing and tolerance as requested by the environment
+         * (see DATA class documentation). */
         void setTable( const DoubleDataSet & table ) {
           this->table = table;
           setCoeffs();
+          setMaxSigmaV();
+          resampleFromEnvironment();
+        }
+
+        /** Return the original table of cross section data. */
+        const DoubleDataSet & getTable() const {
+          return table;
+        }
+
+        /** Return the spacing of the resampled grid (NO_GRID if the original
+         * table is searched). */
+        const enum GRID_SPACING & getGridSpacing() const {
+          return grid_spacing;
+        }
+
+        /** Return the number of bins of the resampled grid. */
+        unsigned int getGridSize() const {
+          return grid.size();
+        }
+
+        /** Resample the table onto a grid that is uniform in v or log(v).  The
+         * grid covers the range of the table data.  Outside of this range
+         * (including v below the second data point for a LOG_GRID, when the
+         * first data point is at v=0), the original table is used.  The
+         * number of bins is doubled, starting from the number of intervals of
+         * the table, until the resampled interpolation differs from the table
+         * interpolation by no more than tolerance times the maximum cross
+         * section of the table.
+         *
+         * @param spacing
+         *    Spacing of the new grid.  NO_GRID removes any resampled grid.
+         * @param tolerance
+         *    Maximum error of the grid, relative to the maximum cross section
+         *    of the table.
+         * @param max_bins
+         *    Maximum number of bins to use.  If the tolerance is not met with
+         *    this number of bins, a warning is issued.
+         * */
+        void resample( const enum GRID_SPACING & spacing,
+                       const double & tolerance = 1e-3,
+                       const unsigned int & max_bins = (1u << 20) ) {
+          grid.clear();
+          grid_spacing = NO_GRID;
+          grid_x0 = grid_dx_inv = grid_v0 = grid_v1 = 0.0;
+
+          if ( spacing == NO_GRID || table.size() < 2u )
+            return;
+
+          DoubleDataSet::const_iterator first = table.begin();
+          DoubleDataSet::const_iterator last  = table.end();
+          --last;
+
+          if ( spacing == LOG_GRID && first->first <= 0.0 )
+            ++first;
+
+          const double v0 = first->first;
+          const double v1 = last->first;
+          if ( !(v1 > v0) || (spacing == LOG_GRID && v0 <= 0.0) )
+            return;
+
+          double sigma_max = 0.0;
+          for ( DoubleDataSet::const_iterator i = table.begin(),
+                                            end = table.end();
+                                              i != end; ++i )
+            sigma_max = std::max( sigma_max, std::abs(i->second) );
+
+          const double x0 = ( spacing == LOG_GRID ? std::log(v0) : v0 );
+          const double x1 = ( spacing == LOG_GRID ? std::log(v1) : v1 );
+
+          unsigned int n_bins = std::max( table.size() - 1u, size_t(1u) );
+          std::vector<double> sigma;
+          while ( true ) {
+            const double dx = ( x1 - x0 ) / n_bins;
+
+            /* tabulate the nodes.  The first node is taken as the limit from
+             * above since the table returns zero at its first point. */
+            sigma.resize( n_bins + 1u );
+            std::vector<double> v( n_bins + 1u );
+            for ( unsigned int k = 0u; k <= n_bins; ++k ) {
+              const double x = x0 + k * dx;
+              v[k] = ( k == 0u      ? v0 :
+                       k == n_bins  ? v1 :
+                       spacing == LOG_GRID ? std::exp(x) : x );
+              sigma[k] = ( k == 0u && first == table.begin()
+                           ? first->second : evalTable(v[k]) );
+            }
+
+            grid.resize( n_bins );
+            for ( unsigned int k = 0u; k < n_bins; ++k ) {
+              grid[k].v     = v[k];
+              grid[k].sigma = sigma[k];
+              grid[k].slope = ( sigma[k+1] - sigma[k] ) / ( v[k+1] - v[k] );
+            }
+
+            grid_spacing = spacing;
+            grid_x0 = x0;
+            grid_dx_inv = 1.0 / dx;
+            grid_v0 = v0;
+            grid_v1 = v1;
+
+            /* Both interpolations are piecewise linear in v, so the maximum
+             * difference is found at the data points of the table (the grid
+             * nodes are exact). */
+            double err = 0.0;
+            for ( DoubleDataSet::const_iterator i = first; i != last; ++i ) {
+              if ( i->first > v0 )
+                err = std::max( err, std::abs( evalGrid(i->first) - i->second ) );
+            }
+
+            if ( err <= tolerance * sigma_max )
+              break;
+
+            if ( 2u * n_bins > max_bins ) {
+              using xylose::logger::log_warning;
+              log_warning( "cross section DATA grid tolerance (%g) not met "
+                           "with %u bins (error=%g)", tolerance, n_bins,
+                           err / sigma_max );
+              break;
+            }
+
+            n_bins *= 2u;
+          }
         }
 
         /** return the number of extrapolations performed till now. */
@@ -204,6 +476,70 @@ namespace chimp {
         }
 
       private:
+        /** Compute the contiguous copy of the table and the running maximum of
+         * v*sigma that are used by findMaxSigmaV. */
+        void setMaxSigmaV() {
+          const unsigned int n = table.size();
+          knot_v.resize( n );
+          knot_sigma.resize( n );
+          max_sigma_v.resize( n );
+          max_sigma_v_at.resize( n );
+
+          double max_sv = 0.0, max_sv_at = 0.0;
+          unsigned int k = 0u;
+          for ( DoubleDataSet::const_iterator i  = table.begin(),
+                                            end  = table.end();
+                                              i != end; ++i, ++k ) {
+            knot_v[k] = i->first;
+            knot_sigma[k] = i->second;
+
+            const double prod_i = i->first * i->second;
+            if ( max_sv < prod_i ) {
+              max_sv = prod_i;
+              max_sv_at = i->first;
+            }
+
+            max_sigma_v[k] = max_sv;
+            max_sigma_v_at[k] = max_sv_at;
+          }
+        }
+
+        /** Resample the table as requested by the
+         * CHIMP_CROSS_SECTION_DATA_GRID and
+         * CHIMP_CROSS_SECTION_DATA_GRID_TOLERANCE environment variables. */
+        void resampleFromEnvironment() {
+          enum GRID_SPACING spacing = NO_GRID;
+          double tolerance = 1e-3;
+
+          const std::string uniform_str = "uniform", log_str = "log";
+          const char * env_grid = std::getenv("CHIMP_CROSS_SECTION_DATA_GRID");
+          if ( env_grid && env_grid == uniform_str )
+            spacing = UNIFORM_GRID;
+          else if ( env_grid && env_grid == log_str )
+            spacing = LOG_GRID;
+
+          const char * env_tol
+            = std::getenv("CHIMP_CROSS_SECTION_DATA_GRID_TOLERANCE");
+          if ( env_tol )
+            tolerance = std::atof( env_tol );
+
+          resample( spacing, tolerance );
+        }
+
+        /** Evaluate the cross section from the resampled grid.  v_relative is
+         * assumed to be within (grid_v0, grid_v1). */
+        inline double evalGrid( const double & v_relative ) const {
+          const double x = ( grid_spacing == LOG_GRID ? std::log(v_relative)
+                                                      : v_relative );
+          unsigned int k = static_cast<unsigned int>( (x - grid_x0) * grid_dx_inv );
+          /* guard against round-off at the upper end. */
+          if ( k >= grid.size() )
+            k = grid.size() - 1u;
+
+          const GridNode & node = grid[k];
+          return node.sigma + node.slope * ( v_relative - node.v );
+        }
+
         void setCoeffs() {
           C = a = b = v02 = 0.0;
           extraps_done = 0u;
@@ -265,8 +601,13 @@ namespace chimp {
                 "velocity " + xylose::to_string(v_relative) +
                 " out of range of cross section data" );
 
-            if ( ! extraps_done ) {
-              ++extraps_done;
+            unsigned int n_extraps;
+#ifdef _OPENMP
+            #pragma omp atomic capture
+#endif
+            n_extraps = extraps_done++;
+
+            if ( n_extraps == 0u ) {
               using xylose::logger::log_warning;
               log_warning( "extrapolating cross section DATA at v=%g",
                            v_relative );
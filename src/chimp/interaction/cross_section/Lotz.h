@@ -39,6 +39,9 @@
 #include <xylose/xml/Doc.h>
 #include <xylose/xml/vector_parse.h>
 #include <xylose/power.h>
+#include <xylose/logger.h>
+
+#include <physical/physical.h>
 
 #include <boost/math/tools/roots.hpp>
 
@@ -46,6 +49,12 @@
 #include <iterator>
 #include <limits>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+#include <cstdlib>
+#include <cmath>
 
 namespace chimp {
   namespace xml = xylose::xml;
@@ -54,6 +63,17 @@ namespace chimp {
     namespace cross_section {
 
       /** Lotz electron-impact cross section model.
+       *
+       * Optionally, the cross section can be tabulated as a piecewise cubic
+       * Hermite interpolant over [threshold, v_max] (see Lotz::tabulate) so
+       * that evaluation requires no transcendental functions.  The analytic
+       * form is used outside of the tabulated range.  The tabulation can also
+       * be requested by setting the CHIMP_CROSS_SECTION_LOTZ_EMAX environment
+       * variable to the maximum electron energy (in eV) to tabulate.  The
+       * relative tolerance is then taken from the
+       * CHIMP_CROSS_SECTION_LOTZ_TOLERANCE environment variable
+       * [Default: 1e-6].
+       *
        * @tparam options
        *    The RuntimeDB template options (see make_options::type for the
        *    default options class).  
@@ -88,6 +108,20 @@ namespace chimp {
          * [threshold, inf] as determined during initialization time. */
         double sigmaV_max_vrel;
 
+      private:
+        /** Coefficients of the cubic polynomial in each bin of the tabulated
+         * form (four per bin, in increasing order of power of the normalized
+         * position within the bin).  Empty if not tabulated. */
+        std::vector<double> spline;
+
+        /** Upper limit of the tabulated range. */
+        double spline_v1;
+
+        /** Inverse of the bin width of the tabulated form. */
+        double spline_dv_inv;
+
+      public:
+
 
         /* MEMBER FUNCTIONS */
         /** Default constructor creates a Lotz instance with no parameters.
@@ -99,7 +133,9 @@ namespace chimp {
             parameters(),
             threshold( std::numeric_limits<double>::infinity() ),
             maxSigmaV(0),
-            sigmaV_max_vrel( std::numeric_limits<double>::infinity() )
+            sigmaV_max_vrel( std::numeric_limits<double>::infinity() ),
+            spline_v1(0.0),
+            spline_dv_inv(0.0)
           { }
 
         /** Constructor with the reduced mass already specified. */
@@ -107,7 +143,9 @@ namespace chimp {
           : parameters( x.parse< ParametersVector >() ),
             threshold(0),
             maxSigmaV(0),
-            sigmaV_max_vrel( std::numeric_limits<double>::infinity() ) {
+            sigmaV_max_vrel( std::numeric_limits<double>::infinity() ),
+            spline_v1(0.0),
+            spline_dv_inv(0.0) {
           using boost::math::tools::toms748_solve;
           boost::math::tools::eps_tolerance<double> tol(64);
           typedef typename ParametersVector::const_iterator CIter;
@@ -165,6 +203,8 @@ namespace chimp {
             this->sigmaV_max_vrel = z.second;
             this->maxSigmaV = z.second * this->operator()( z.second );
           }
+
+          tabulateFromEnvironment();
         }
 
         /** Virtual NO-OP destructor. */
@@ -179,6 +219,31 @@ namespace chimp {
           if ( v <= this->threshold )
             return 0.0;
 
+          if ( v < spline_v1 ) {
+            const double t = ( v - this->threshold ) * spline_dv_inv;
+            unsigned int k = static_cast<unsigned int>( t );
+            /* guard against round-off at the upper end. */
+            if ( 4u * k >= spline.size() )
+              k = spline.size() / 4u - 1u;
+
+            const double s = t - k;
+            const double * c = &spline[4u * k];
+            return c[0] + s * ( c[1] + s * ( c[2] + s * c[3] ) );
+          }
+
+          return evalAnalytic( v );
+        }
+
+        /** Evaluate the analytic form of the Lotz cross section, regardless of
+         * whether the cross section has been tabulated.
+         *
+         * @param v
+         *     The relative velocity between two particles.
+         * */
+        inline double evalAnalytic( const double & v ) const {
+          if ( v <= this->threshold )
+            return 0.0;
+
           const double v2 = v*v;
           typedef typename ParametersVector::const_iterator CIter;
           CIter end = parameters.end();
@@ -197,6 +262,139 @@ namespace chimp {
           return sigma;
         }
 
+        /** Evaluate the derivative of the analytic form of the Lotz cross
+         * section with respect to the relative velocity.
+         *
+         * @param v
+         *     The relative velocity between two particles.
+         * */
+        double derivative( const double & v ) const {
+          if ( v <= this->threshold )
+            return 0.0;
+
+          const double v2 = v*v;
+          typedef typename ParametersVector::const_iterator CIter;
+          CIter end = parameters.end();
+          double dsigma_dx_x = 0.0;
+          for ( CIter i = parameters.begin(); i != end; ++i ) {
+            using std::log;
+            using std::exp;
+            using xylose::SQR;
+            Parameters const & p = *i;
+            /* sigma_i = K ln(x)/x (1 - b exp(-c(x-1))),  x = beta v^2 */
+            const double x = v2 * p.beta;
+            const double ln_x = log( x );
+            const double e = p.b * exp( -p.c * ( x - 1 ) );
+            /* x * d(sigma_i)/dx */
+            dsigma_dx_x += p.a * p.q / SQR(p.P)
+                         * ( ( 1 - ln_x ) * ( 1 - e ) + ln_x * p.c * e * x ) / x;
+          }
+
+          /* dx/dv = 2 x / v */
+          return 2.0 * dsigma_dx_x / v;
+        }
+
+        /** Tabulate the cross section over the range [threshold, v_max] as a
+         * piecewise cubic Hermite interpolant of the analytic values and
+         * derivatives on a uniform grid.  Starting from 16 bins, the number of
+         * bins is doubled until the difference from the analytic form, checked
+         * at three interior points of each bin, satisfies
+         *    |error| <= rel_tol * ( |sigma| + 1e-3 * sigma_max ).
+         * The small absolute floor only matters in the vicinity of the
+         * threshold, where sigma itself goes to zero.
+         *
+         * @param v_max
+         *    Upper limit of the tabulated range.  If v_max <= threshold, any
+         *    previous tabulation is removed.
+         * @param rel_tol
+         *    Relative tolerance of the tabulated form.
+         * @param max_bins
+         *    Maximum number of bins.  If the tolerance is not met with this
+         *    number of bins, a warning is issued.
+         * */
+        void tabulate( const double & v_max,
+                       const double & rel_tol = 1e-6,
+                       const unsigned int & max_bins = (1u << 16) ) {
+          spline.clear();
+          spline_v1 = spline_dv_inv = 0.0;
+
+          if ( !(v_max > this->threshold) || parameters.empty() )
+            return;
+
+          const double v0 = this->threshold;
+          std::vector<double> coeffs;
+          for ( unsigned int n_bins = 16u; ; n_bins *= 2u ) {
+            const double dv = ( v_max - v0 ) / n_bins;
+            coeffs.resize( 4u * n_bins );
+
+            double y0 = evalAnalytic( v0 ),
+                   m0 = derivative( v0 * (1.0 + 1e-12) ) * dv;
+            for ( unsigned int k = 0u; k < n_bins; ++k ) {
+              const double v1 = ( k + 1u == n_bins ? v_max : v0 + (k+1u) * dv );
+              const double y1 = evalAnalytic( v1 );
+              const double m1 = derivative( v1 ) * dv;
+
+              double * c = &coeffs[4u * k];
+              c[0] = y0;
+              c[1] = m0;
+              c[2] = 3.0 * ( y1 - y0 ) - 2.0 * m0 - m1;
+              c[3] = 2.0 * ( y0 - y1 ) + m0 + m1;
+
+              y0 = y1;
+              m0 = m1;
+            }
+
+            /* check the error at interior points of each bin. */
+            double sigma_max = 0.0;
+            for ( unsigned int k = 0u; k < n_bins; ++k )
+              sigma_max = std::max( sigma_max, std::abs( coeffs[4u * k] ) );
+
+            bool ok = true;
+            double max_err = 0.0;
+            for ( unsigned int k = 0u; k < n_bins; ++k ) {
+              const double * c = &coeffs[4u * k];
+              for ( unsigned int j = 1u; j < 4u; ++j ) {
+                const double s = 0.25 * j;
+                const double approx = c[0] + s * ( c[1] + s * ( c[2] + s * c[3] ) );
+                const double exact = evalAnalytic( v0 + (k + s) * dv );
+                const double err = std::abs( approx - exact );
+                max_err = std::max( max_err, err / std::max(sigma_max, 1e-300) );
+                if ( err > rel_tol * ( std::abs(exact) + 1e-3 * sigma_max ) )
+                  ok = false;
+              }
+            }
+
+            if ( ok || 2u * n_bins > max_bins ) {
+              if ( !ok ) {
+                using xylose::logger::log_warning;
+                log_warning( "Lotz tabulation tolerance (%g) not met with %u "
+                             "bins (max error/sigma_max=%g)",
+                             rel_tol, n_bins, max_err );
+              }
+
+              spline.swap( coeffs );
+              spline_v1 = v_max;
+              spline_dv_inv = 1.0 / dv;
+              return;
+            }
+          }
+        }
+
+        /** Return the number of bins of the tabulated form (zero if not
+         * tabulated). */
+        unsigned int getTableSize() const {
+          return spline.size() / 4u;
+        }
+
+        /** Evaluate the cross-section of the Lotz model for a batch of
+         * relative speeds. */
+        virtual void evaluate( const double * v_relative,
+                               double * sigma,
+                               const unsigned int & n ) const {
+          for ( unsigned int i = 0u; i < n; ++i )
+            sigma[i] = Lotz::operator()( v_relative[i] );
+        }
+
         /** Determine the maximum value of the product v_rel * cross_section
          * based on cached results of the maximum search done at class
          * initialization time.
@@ -215,6 +413,22 @@ namespace chimp {
                                   v_rel_max);
         }
 
+        /** Compute D[v*sigma, v] from the analytic form of the cross section. */
+        virtual double dSigmaV(const double & v_relative) const {
+          return evalAnalytic( v_relative )
+               + v_relative * derivative( v_relative );
+        }
+
+        /** The cross section is zero up to the threshold. */
+        virtual void getBreakpoints( const double & v_rel_max,
+                                     std::vector<double> & v ) const {
+          if ( this->threshold > 0.0 && this->threshold <= v_rel_max )
+            v.push_back( this->threshold );
+        }
+
+        /** dSigmaV is analytic and the only breakpoint is the threshold. */
+        virtual bool hasExactExtrema() const { return true; }
+
         virtual Lotz * new_load( const xml::Context & x,
                                  const interaction::Equation<options> & eq,
                                  const RuntimeDB<options> & db ) const {
@@ -234,6 +448,28 @@ namespace chimp {
           return out;
         }
 
+      private:
+        /** Tabulate the cross section as requested by the
+         * CHIMP_CROSS_SECTION_LOTZ_EMAX and CHIMP_CROSS_SECTION_LOTZ_TOLERANCE
+         * environment variables. */
+        void tabulateFromEnvironment() {
+          const char * env_Emax = std::getenv("CHIMP_CROSS_SECTION_LOTZ_EMAX");
+          if ( !env_Emax )
+            return;
+
+          using physical::constant::si::eV;
+          using physical::constant::si::m_e;
+          const double Emax = std::atof( env_Emax ) * eV;
+
+          double rel_tol = 1e-6;
+          const char * env_tol
+            = std::getenv("CHIMP_CROSS_SECTION_LOTZ_TOLERANCE");
+          if ( env_tol )
+            rel_tol = std::atof( env_tol );
+
+          tabulate( std::sqrt( 2.0 * Emax / m_e ), rel_tol );
+        }
+
       };
 
       template < typename options >
@@ -30,6 +30,7 @@
 
 #include <chimp/interaction/cross_section/Base.h>
 #include <chimp/interaction/cross_section/detail/VHSInfo.h>
+#include <chimp/interaction/cross_section/detail/VHSKernel.h>
 #include <chimp/interaction/Equation.h>
 #include <chimp/interaction/ReducedMass.h>
 
@@ -59,28 +60,43 @@ namespace chimp {
 
 
         /* MEMBER STORAGE */
+      private:
         /** The vhs information for this particular interaction. */
         detail::VHSInfo vhs;
 
         /** The reduced mass. */
         ReducedMass mu;
 
+        /** Evaluator with all of the constants of vhs and mu folded together.
+         * This is refolded by setVHSInfo and setReducedMass. */
+        detail::VHSKernel kernel;
+
 
 
 
         /* MEMBER FUNCTIONS */
-        /** Default constructor creates a VHS instance with invalid data.  This
-         * is primarily useful for obtaining a class from which to call
-         * VHS::new_load. 
+      public:
+        /** Default constructor creates a VHS instance with invalid data (for
+         * which the cross section is zero).  This is primarily useful for
+         * obtaining a class from which to call VHS::new_load. 
          */
-        VHS() : cross_section::Base<options>() { }
+        VHS() : cross_section::Base<options>(), vhs(), mu(), kernel() { }
 
         /** Constructor with the reduced mass already specified. */
         VHS( const xml::Context & x,
              const ReducedMass & mu )
         : cross_section::Base<options>(),
           vhs( detail::VHSInfo::load(x) ),
-          mu( mu ) { }
+          mu( mu ),
+          kernel( vhs, mu.value ) { }
+
+        /** Constructor from the vhs information and the reduced mass. */
+        VHS( const detail::VHSInfo & vhs,
+             const ReducedMass & mu )
+        : cross_section::Base<options>(),
+          vhs( vhs ),
+          mu( mu ),
+          kernel( vhs, mu.value ) { }
 
         /** Virtual NO-OP destructor. */
         virtual ~VHS() {}
@@ -93,24 +109,39 @@ namespace chimp {
          *     The relative velocity between two particles.
          * */
         inline virtual double operator() (const double & v_relative) const {
-          using physical::constant::si::K_B;
-          using xylose::SQR;
-          using xylose::fast_pow;
-
           /* the collision cross-section is based on eqn (4.63) for VHS model.
-           * NOTE that we are guarding against (1/0).
-           */
-          return 
-              vhs.cross_section
-            * fast_pow(
-                ( 2.0 * K_B * vhs.T_ref
-                  / ( mu.value * SQR(v_relative)
-                      + std::numeric_limits<double>::min()
-                    )
-                ), (vhs.visc_T_law - 0.5))
-            * vhs.gamma_visc_inv;
+           * All of the constants are already folded into the kernel. */
+          return kernel( v_relative );
         }
 
+        /** Compute the cross section for a batch of relative speeds. */
+        virtual void evaluate( const double * v_relative,
+                               double * sigma,
+                               const unsigned int & n ) const {
+          kernel.evaluate( v_relative, sigma, n );
+        }
+
+        /** The vhs information for this particular interaction. */
+        const detail::VHSInfo & getVHSInfo() const { return vhs; }
+
+        /** Set the vhs information and refold the constants of the kernel. */
+        void setVHSInfo( const detail::VHSInfo & vhs ) {
+          this->vhs = vhs;
+          kernel = detail::VHSKernel( vhs, mu.value );
+        }
+
+        /** The reduced mass. */
+        const ReducedMass & getReducedMass() const { return mu; }
+
+        /** Set the reduced mass and refold the constants of the kernel. */
+        void setReducedMass( const ReducedMass & mu ) {
+          this->mu = mu;
+          kernel = detail::VHSKernel( vhs, mu.value );
+        }
+
+        /** The evaluator with all of the constants folded together. */
+        const detail::VHSKernel & getKernel() const { return kernel; }
+
         virtual std::pair<double,double>
         findMaxSigmaV(const double & v_rel_max) const {
           /* just return the product since the product is monotonically
@@ -118,6 +149,14 @@ namespace chimp {
           return std::make_pair(operator()(v_rel_max) * v_rel_max, v_rel_max);
         }
 
+        /** Compute D[v*sigma, v] = (1 + 2*exponent) * sigma. */
+        virtual double dSigmaV(const double & v_relative) const {
+          return ( 1.0 + 2.0 * kernel.exponent ) * kernel( v_relative );
+        }
+
+        /** v*sigma is a power of v and thus monotone. */
+        virtual bool hasExactExtrema() const { return true; }
+
         virtual VHS * new_load( const xml::Context & x,
                                 const interaction::Equation<options> & eq,
                                 const RuntimeDB<options> & db ) const {
@@ -30,6 +30,10 @@
 #define chimp_interaction_cross_section_detail_AvgEasy_h
 
 #include <chimp/interaction/cross_section/Base.h>
+#include <chimp/interaction/cross_section/VHS.h>
+#include <chimp/interaction/cross_section/Constant.h>
+#include <chimp/interaction/cross_section/detail/VHSKernel.h>
+#include <chimp/interaction/cross_section/detail/batch.h>
 #include <chimp/interaction/Equation.h>
 
 #include <xylose/xml/Doc.h>
@@ -41,6 +45,7 @@
 #include <ostream>
 #include <cassert>
 #include <set>
+#include <algorithm>
 
 namespace chimp {
   namespace xml = xylose::xml;
@@ -51,6 +56,13 @@ namespace chimp {
       namespace detail {
 
         /** Averaged cross section provider.
+         *
+         * When both of the sub-cross-sections are VHS or Constant models,
+         * their constants are folded together at construction.  If both have
+         * the same exponent, the average is itself of the VHS form and is
+         * evaluated by a single VHSKernel.  Otherwise, the square-roots of the
+         * two cross sections are evaluated by two pre-folded kernels.
+         *
          * @tparam options
          *    The RuntimeDB template options (see make_options::type for the
          *    default options class).  
@@ -66,18 +78,60 @@ namespace chimp {
           static const std::set< std::string > easy_labels;
 
 
+          /** How the average is evaluated. */
+          enum FORM {
+            /** Call the sub-cross-sections through their virtual interface. */
+            VIRTUAL_FORM,
+            /** Evaluate a single VHS-equivalent kernel. */
+            SINGLE_FORM,
+            /** Evaluate the two square-root kernels. */
+            TWO_TERM_FORM
+          };
+
+
           /* MEMBER STORAGE */
           /** Pointers to the sub-cross-section instances. */
           CSPtr cs0, cs1;
 
+          /** How the average is evaluated. */
+          enum FORM form;
+
+          /** VHS-equivalent kernel of the average for SINGLE_FORM. */
+          VHSKernel single;
+
+          /** Kernels of the square-roots of the sub-cross-sections for
+           * TWO_TERM_FORM. */
+          VHSKernel root0, root1;
+
 
           /* MEMBER FUNCTIONS */
           /** Constructor to initialize the cross section data by copying from a
            * set of data previously loaded. */
           AvgEasy( const CSPtr & cs0, const CSPtr & cs1 )
-            : cross_section::Base<options>(), cs0(cs0), cs1(cs1) {
+            : cross_section::Base<options>(), cs0(cs0), cs1(cs1),
+              form(VIRTUAL_FORM) {
             assert( easy_labels.find( cs0->getLabel() ) != easy_labels.end() );
             assert( easy_labels.find( cs1->getLabel() ) != easy_labels.end() );
+
+            VHSKernel k0, k1;
+            if ( !getKernel( *cs0, k0 ) || !getKernel( *cs1, k1 ) )
+              return;
+
+            if ( k0.exponent == k1.exponent ) {
+              /* 0.25 * ( sqrt(C0 (mu0 v^2)^e) + sqrt(C1 (mu1 v^2)^e) )^2
+               *  == C * (v^2)^e */
+              using xylose::SQR;
+              single = VHSKernel(
+                0.25 * SQR( std::sqrt( k0.C * std::pow( k0.mu, k0.exponent ) ) +
+                            std::sqrt( k1.C * std::pow( k1.mu, k1.exponent ) ) ),
+                1.0, k0.exponent
+              );
+              form = SINGLE_FORM;
+            } else {
+              root0 = k0.sqrtKernel();
+              root1 = k1.sqrtKernel();
+              form = TWO_TERM_FORM;
+            }
           }
 
           /** Virtual NO-OP destructor. */
@@ -90,8 +144,39 @@ namespace chimp {
            * */
           inline virtual double operator() (const double & v_relative) const {
             using xylose::SQR;
-            return 0.25 * SQR( sqrt(cs0->operator()(v_relative)) +
-                               sqrt(cs1->operator()(v_relative)) );
+            switch ( form ) {
+              case SINGLE_FORM:
+                return single( v_relative );
+              case TWO_TERM_FORM:
+                return 0.25 * SQR( root0(v_relative) + root1(v_relative) );
+              default:
+                return 0.25 * SQR( sqrt(cs0->operator()(v_relative)) +
+                                   sqrt(cs1->operator()(v_relative)) );
+            }
+          }
+
+          /** Compute the cross section for a batch of relative speeds. */
+          virtual void evaluate( const double * v_relative,
+                                 double * sigma,
+                                 const unsigned int & n ) const {
+            if ( form == SINGLE_FORM ) {
+              single.evaluate( v_relative, sigma, n );
+              return;
+            }
+
+            double s1[batch::chunk_size];
+            for ( unsigned int i = 0u; i < n; i += batch::chunk_size ) {
+              const unsigned int m = std::min( n - i, batch::chunk_size );
+              if ( form == TWO_TERM_FORM ) {
+                root0.evaluate( v_relative + i, sigma + i, m );
+                root1.evaluate( v_relative + i, s1, m );
+                batch::combineDiameters( sigma + i, s1, sigma + i, m );
+              } else {
+                cs0->evaluate( v_relative + i, sigma + i, m );
+                cs1->evaluate( v_relative + i, s1, m );
+                batch::averageDiameters( sigma + i, s1, sigma + i, m );
+              }
+            }
           }
 
           virtual std::pair<double,double>
@@ -101,6 +186,30 @@ namespace chimp {
             return std::make_pair(operator()(v_rel_max) * v_rel_max, v_rel_max);
           }
 
+          /** Compute D[v*sigma, v].  For the VHS-equivalent forms, this is
+           * computed analytically. */
+          virtual double dSigmaV(const double & v_relative) const {
+            using xylose::SQR;
+            switch ( form ) {
+              case SINGLE_FORM:
+                return ( 1.0 + 2.0 * single.exponent ) * single( v_relative );
+              case TWO_TERM_FORM: {
+                /* sigma = (r0 + r1)^2 / 4  with  D[r_i, v] = 2 p_i r_i / v */
+                const double r0 = root0( v_relative );
+                const double r1 = root1( v_relative );
+                return 0.25 * SQR( r0 + r1 )
+                     + ( r0 + r1 ) * ( root0.exponent * r0
+                                     + root1.exponent * r1 );
+              }
+              default:
+                return cross_section::Base<options>::dSigmaV( v_relative );
+            }
+          }
+
+          /** Both sub-cross-sections are VHS or Constant models, so v*sigma
+           * is monotone. */
+          virtual bool hasExactExtrema() const { return true; }
+
           virtual AvgEasy * new_load( const xml::Context & x,
                                    const interaction::Equation<options> & eq,
                                    const RuntimeDB<options> & db ) const {
@@ -120,6 +229,25 @@ namespace chimp {
             return out;
           }
 
+        private:
+          /** Obtain the folded VHS-form kernel of a VHS or Constant cross
+           * section.
+           * @return false if cs is neither VHS nor Constant. */
+          static bool getKernel( const cross_section::Base<options> & cs,
+                                 VHSKernel & k ) {
+            typedef cross_section::VHS<options> VHS;
+            typedef cross_section::Constant<options> Constant;
+
+            if ( const VHS * vhs = dynamic_cast<const VHS *>( &cs ) ) {
+              k = vhs->getKernel();
+              return true;
+            } else if ( const Constant * c = dynamic_cast<const Constant *>(&cs) ) {
+              k = VHSKernel( c->value, 1.0, 0.0 );
+              return true;
+            }
+
+            return false;
+          }
         };
 
         template < typename options >
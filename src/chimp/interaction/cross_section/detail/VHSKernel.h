@@ -0,0 +1,151 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Evaluator for cross sections of the VHS form with all constants folded
+ * together.
+ *
+ * @see cross_section::VHS.
+ * */
+
+#ifndef chimp_interaction_cross_section_detail_VHSKernel_h
+#define chimp_interaction_cross_section_detail_VHSKernel_h
+
+#include <chimp/interaction/cross_section/detail/VHSInfo.h>
+#include <chimp/interaction/cross_section/detail/batch.h>
+
+#include <physical/physical.h>
+
+#include <limits>
+#include <cmath>
+
+namespace chimp {
+  namespace interaction {
+    namespace cross_section {
+      namespace detail {
+
+        /** Evaluates cross sections of the form
+         *   sigma(v) = C * ( mu * v^2 + DBL_MIN )^exponent.
+         * The VHS model (eqn (4.63) of Graeme Bird's book) is of this form
+         * with
+         *   C = cross_section * (2 K_B T_ref)^(visc_T_law - 0.5)
+         *     / Gamma(5/2 - visc_T_law),
+         *   exponent = 0.5 - visc_T_law.
+         * The common exponents 0, -1/4, and -1/2 (visc_T_law = 0.5, 0.75, and
+         * 1.0) are evaluated with sqrt instead of pow.
+         * */
+        struct VHSKernel {
+          /* TYPEDEFS */
+          /** The specialized forms of the kernel. */
+          enum FORM {
+            /** exponent == 0:  sigma = C. */
+            CONSTANT_FORM,
+            /** exponent == -1/4:  sigma = C / sqrt(sqrt(x)). */
+            RSQRT_SQRT_FORM,
+            /** exponent == -1/2:  sigma = C / sqrt(x). */
+            RSQRT_FORM,
+            /** Any other exponent:  sigma = C * pow(x, exponent). */
+            GENERAL_FORM
+          };
+
+
+          /* MEMBER STORAGE */
+          /** Constant factor. */
+          double C;
+
+          /** Coefficient of v^2 (typically the reduced mass). */
+          double mu;
+
+          /** Exponent. */
+          double exponent;
+
+          /** Specialized form that is used for the exponent. */
+          enum FORM form;
+
+
+
+          /* MEMBER FUNCTIONS */
+          /** Default constructor gives a zero cross section. */
+          VHSKernel()
+            : C(0.0), mu(1.0), exponent(0.0), form(CONSTANT_FORM) { }
+
+          /** Constructor with each of the constants specified. */
+          VHSKernel( const double & C,
+                     const double & mu,
+                     const double & exponent )
+            : C(C), mu(mu), exponent(exponent), form(getForm(exponent)) { }
+
+          /** Constructor to fold the VHS parameters together. */
+          VHSKernel( const VHSInfo & vhs, const double & mu )
+            : C( vhs.cross_section * vhs.gamma_visc_inv
+                 * std::pow( 2.0 * physical::constant::si::K_B * vhs.T_ref,
+                             vhs.visc_T_law - 0.5 ) ),
+              mu(mu),
+              exponent( 0.5 - vhs.visc_T_law ),
+              form( getForm(exponent) ) { }
+
+          /** Return the kernel that evaluates sqrt(sigma(v)). */
+          VHSKernel sqrtKernel() const {
+            return VHSKernel( std::sqrt(C), mu, 0.5 * exponent );
+          }
+
+          /** Evaluate the cross section. */
+          inline double operator() ( const double & v_relative ) const {
+            if ( form == CONSTANT_FORM )
+              return C;
+
+            /* NOTE that we are guarding against (1/0). */
+            const double x = mu * v_relative * v_relative
+                           + std::numeric_limits<double>::min();
+            switch ( form ) {
+              case RSQRT_SQRT_FORM:
+                return C / std::sqrt( std::sqrt(x) );
+              case RSQRT_FORM:
+                return C / std::sqrt(x);
+              default:
+                return C * std::pow( x, exponent );
+            }
+          }
+
+          /** Evaluate the cross section for a batch of relative speeds. */
+          void evaluate( const double * v_relative,
+                         double * sigma,
+                         const unsigned int & n ) const {
+            batch::vhs( v_relative, sigma, n, C, mu, exponent );
+          }
+
+          /** Determine the specialized form to use for the given exponent. */
+          static enum FORM getForm( const double & exponent ) {
+            if      ( exponent ==  0.0  ) return CONSTANT_FORM;
+            else if ( exponent == -0.25 ) return RSQRT_SQRT_FORM;
+            else if ( exponent == -0.5  ) return RSQRT_FORM;
+            else                          return GENERAL_FORM;
+          }
+        };
+
+      } /* namespace chimp::interaction::cross_section::detail */
+    } /* namespace chimp::interaction::cross_section */
+  } /* namespace chimp::interaction */
+} /* namespace chimp */
+
+#endif // chimp_interaction_cross_section_detail_VHSKernel_h
@@ -0,0 +1,186 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Implementation of the kernels used by the batched cross section
+ * evaluation.
+ *
+ * Where supported (GCC on x86-64 Linux), each kernel is compiled for AVX-512,
+ * AVX2, and the baseline instruction set, and the version that matches the
+ * CPU is selected at load time.  Define CHIMP_NO_TARGET_CLONES to build only
+ * the baseline version.
+ *
+ * The general VHS exponent is evaluated as exp(exponent * log(x)) with the
+ * branch-free polynomial approximations below instead of std::pow, so that
+ * the loop can be vectorized without a vector math library.  Vectorizing
+ * these loops requires -fno-math-errno and -fno-trapping-math (see
+ * CMakeLists.txt).
+ * */
+
+#include <chimp/interaction/cross_section/detail/batch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER) \
+ && (__GNUC__ >= 6) && defined(__x86_64__) && defined(__linux__)       \
+ && !defined(CHIMP_NO_TARGET_CLONES)
+#  define CHIMP_BATCH_KERNEL \
+     __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#  define CHIMP_BATCH_KERNEL
+#endif
+
+namespace chimp {
+  namespace interaction {
+    namespace cross_section {
+      namespace detail {
+        namespace batch {
+
+          namespace {
+
+            typedef unsigned long long uint64;
+
+            inline double fromBits( const uint64 & b ) {
+              double d;
+              std::memcpy( &d, &b, sizeof(d) );
+              return d;
+            }
+
+            inline uint64 toBits( const double & d ) {
+              uint64 b;
+              std::memcpy( &b, &d, sizeof(b) );
+              return b;
+            }
+
+            /** Natural logarithm of a positive, normal x to a relative
+             * accuracy of about 1e-15.  x is split into 2^k * m with
+             * sqrt(1/2) <= m < sqrt(2) using integer operations only, and
+             * log(m) = 2 atanh( (m-1)/(m+1) ) is summed as a series. */
+            inline double log( const double & x ) {
+              const uint64 ix = toBits(x);
+              /* biased exponent of x / sqrt(1/2) */
+              const uint64 E = ( ix + ( 0x3ff0000000000000ULL
+                                      - 0x3fe6a09e667f3bcdULL ) ) >> 52;
+              /* k = E - 1023 converted to double without an int->double
+               * conversion (which does not vectorize before AVX-512). */
+              const double k = fromBits( 0x4330000000000000ULL | E )
+                             - ( 4503599627370496.0 + 1023.0 );
+              const double m = fromBits( ix - ( E << 52 )
+                                         + 0x3ff0000000000000ULL );
+              const double f = ( m - 1.0 ) / ( m + 1.0 );
+              const double s = f * f;
+              const double p =
+                1.0 + s*( 1.0/3.0  + s*( 1.0/5.0  + s*( 1.0/7.0
+                    + s*( 1.0/9.0  + s*( 1.0/11.0 + s*( 1.0/13.0
+                    + s*( 1.0/15.0 + s*( 1.0/17.0 + s*( 1.0/19.0 )))))))));
+              return k * 6.93147180559945286227e-01 + 2.0 * f * p;
+            }
+
+            /** Exponential of y to a relative accuracy of about 1e-15 for
+             * |y| < 1 (the error grows as |y| * 1e-16).  y is clamped to
+             * [-708,709] so that the result is always a finite, normal
+             * number. */
+            inline double exp( double y ) {
+              y = std::min( std::max( y, -708.0 ), 709.0 );
+              /* round y/ln(2) to the nearest integer n by adding 1.5*2^52;
+               * the low bits of t then hold n in two's complement. */
+              const double shift = 6755399441055744.0;
+              const double t = y * 1.44269504088896338700e+00 + shift;
+              const double n = t - shift;
+              const double r = ( y - n * 6.93147180369123816490e-01 )
+                             - n * 1.90821492927058770002e-10;
+              /* Taylor series of exp(r) for |r| <= ln(2)/2 */
+              double p = 1.0 / 6227020800.0;
+              p = p * r + 1.0 / 479001600.0;
+              p = p * r + 1.0 / 39916800.0;
+              p = p * r + 1.0 / 3628800.0;
+              p = p * r + 1.0 / 362880.0;
+              p = p * r + 1.0 / 40320.0;
+              p = p * r + 1.0 / 5040.0;
+              p = p * r + 1.0 / 720.0;
+              p = p * r + 1.0 / 120.0;
+              p = p * r + 1.0 / 24.0;
+              p = p * r + 1.0 / 6.0;
+              p = p * r + 0.5;
+              p = p * r + 1.0;
+              p = p * r + 1.0;
+              const uint64 n_bits = toBits(t) - toBits(shift);
+              return p * fromBits( ( n_bits << 52 ) + 0x3ff0000000000000ULL );
+            }
+
+          }/* namespace <anonymous> */
+
+          CHIMP_BATCH_KERNEL
+          void vhs( const double * v,
+                    double * sigma,
+                    const unsigned int n,
+                    const double C,
+                    const double mu,
+                    const double exponent ) {
+            const double tiny = std::numeric_limits<double>::min();
+            if ( exponent == 0.0 ) {
+              for ( unsigned int i = 0u; i < n; ++i )
+                sigma[i] = C;
+            } else if ( exponent == -0.25 ) {
+              for ( unsigned int i = 0u; i < n; ++i )
+                sigma[i] = C / std::sqrt( std::sqrt( mu * v[i] * v[i] + tiny ) );
+            } else if ( exponent == -0.5 ) {
+              for ( unsigned int i = 0u; i < n; ++i )
+                sigma[i] = C / std::sqrt( mu * v[i] * v[i] + tiny );
+            } else {
+              for ( unsigned int i = 0u; i < n; ++i )
+                sigma[i] = C * exp( exponent
+                                  * log( mu * v[i] * v[i] + tiny ) );
+            }
+          }
+
+          CHIMP_BATCH_KERNEL
+          void averageDiameters( const double * s0,
+                                 const double * s1,
+                                 double * out,
+                                 const unsigned int n ) {
+            for ( unsigned int i = 0u; i < n; ++i ) {
+              const double d = std::sqrt(s0[i]) + std::sqrt(s1[i]);
+              out[i] = 0.25 * d * d;
+            }
+          }
+
+          CHIMP_BATCH_KERNEL
+          void combineDiameters( const double * r0,
+                                 const double * r1,
+                                 double * out,
+                                 const unsigned int n ) {
+            for ( unsigned int i = 0u; i < n; ++i ) {
+              const double d = r0[i] + r1[i];
+              out[i] = 0.25 * d * d;
+            }
+          }
+
+        }/* namespace chimp::interaction::cross_section::detail::batch */
+      }/* namespace chimp::interaction::cross_section::detail */
+    }/* namespace chimp::interaction::cross_section */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
@@ -0,0 +1,81 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Declaration of the kernels used by the batched cross section evaluation
+ * (cross_section::Base::evaluate).
+ * */
+
+#ifndef chimp_interaction_cross_section_detail_batch_h
+#define chimp_interaction_cross_section_detail_batch_h
+
+namespace chimp {
+  namespace interaction {
+    namespace cross_section {
+      namespace detail {
+        namespace batch {
+
+          /** Number of values processed at a time by batch implementations
+           * that require temporary storage. */
+          static const unsigned int chunk_size = 256u;
+
+          /** Evaluate the VHS cross section for a batch of relative speeds as
+           *   sigma[i] = C * ( mu * v[i]^2 + DBL_MIN )^exponent.
+           * All of the constant parts of the VHS model must already be folded
+           * into C.  The exponents 0, -1/4, and -1/2 are evaluated with sqrt.
+           * Other exponents are evaluated as exp(exponent * log(x)) with
+           * vectorizable polynomial approximations that agree with std::pow
+           * to a relative accuracy of about 1e-16 * |exponent * log(x)|.
+           * @see VHSKernel. */
+          void vhs( const double * v,
+                    double * sigma,
+                    const unsigned int n,
+                    const double C,
+                    const double mu,
+                    const double exponent );
+
+          /** Combine two batches of cross sections by averaging their
+           * diameters:
+           *   out[i] = 0.25 * ( sqrt(s0[i]) + sqrt(s1[i]) )^2.
+           * out may be the same array as s0 or s1. */
+          void averageDiameters( const double * s0,
+                                 const double * s1,
+                                 double * out,
+                                 const unsigned int n );
+
+          /** Combine two batches of square-roots of cross sections by
+           * averaging the diameters:
+           *   out[i] = 0.25 * ( r0[i] + r1[i] )^2.
+           * out may be the same array as r0 or r1. */
+          void combineDiameters( const double * r0,
+                                 const double * r1,
+                                 double * out,
+                                 const unsigned int n );
+
+        }/* namespace chimp::interaction::cross_section::detail::batch */
+      }/* namespace chimp::interaction::cross_section::detail */
+    }/* namespace chimp::interaction::cross_section */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_cross_section_detail_batch_h
@@ -0,0 +1,150 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the adaptive table of the AveragedDiameters cross section
+ * class.
+ * */
+#define BOOST_TEST_MODULE  AveragedDiameters
+
+
+#include <chimp/interaction/cross_section/AveragedDiameters.h>
+#include <chimp/interaction/cross_section/Constant.h>
+#include <chimp/make_options.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <cmath>
+
+namespace {
+  typedef chimp::make_options<>::type options;
+  typedef chimp::interaction::cross_section::Base<options> Base;
+  typedef chimp::interaction::cross_section::Constant<options> Constant;
+  typedef chimp::interaction::cross_section::AveragedDiameters<options>
+    AveragedDiameters;
+  typedef boost::shared_ptr<Base> CSPtr;
+
+  const double vmax = 1e5;
+
+  /** A smooth, slowly varying cross section:  sigma = c / (1 + v/v0). */
+  struct Smooth : Base {
+    double c, v0;
+
+    Smooth( const double & c, const double & v0 ) : c(c), v0(v0) { }
+
+    virtual double operator() ( const double & v ) const {
+      return c / ( 1.0 + v / v0 );
+    }
+
+    virtual std::pair<double,double>
+    findMaxSigmaV( const double & v_rel_max ) const {
+      return std::make_pair( operator()(v_rel_max) * v_rel_max, v_rel_max );
+    }
+
+    virtual Base * new_load( const chimp::xml::Context & x,
+                             const chimp::interaction::Equation<options> & eq,
+                             const chimp::RuntimeDB<options> & db ) const {
+      return NULL;
+    }
+
+    virtual std::string getLabel() const { return "smooth"; }
+  };
+
+  /** The smooth cross section with a narrow Gaussian resonance added. */
+  struct Peaked : Smooth {
+    double height, center, width;
+
+    Peaked( const double & c, const double & v0,
+            const double & height, const double & center,
+            const double & width )
+      : Smooth(c, v0), height(height), center(center), width(width) { }
+
+    virtual double operator() ( const double & v ) const {
+      const double x = ( v - center ) / width;
+      return Smooth::operator()(v) + height * std::exp( -x*x );
+    }
+
+    virtual std::pair<double,double>
+    findMaxSigmaV( const double & v_rel_max ) const {
+      return std::make_pair( operator()(center) * center, center );
+    }
+  };
+
+  std::size_t nodes( const CSPtr & cs0, const CSPtr & cs1,
+                     const double & tolerance ) {
+    return AveragedDiameters( cs0, cs1, vmax, 0.0, tolerance )
+           .getTable().size();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( AveragedDiameters_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( adaptive_matches_exact ) {
+    const CSPtr cs0( new Smooth( 1e-19, 1e3 ) );
+    const CSPtr cs1(
+      new Peaked( 5e-20, 1e4, 2e-19, 0.53 * vmax, 1e-2 * vmax ) );
+
+    const double tolerances[] = { 1e-2, 1e-3, 1e-4 };
+    for ( unsigned int t = 0u; t < 3u; ++t ) {
+      const double & tol = tolerances[t];
+      const AveragedDiameters avg( cs0, cs1, vmax, 0.0, tol );
+
+      /* The refinement only tests the midpoint of each interval; for smooth
+       * input the error anywhere in the interval is of the same order, so
+       * allow a modest factor over the requested tolerance.  The table is
+       * treated as starting at a threshold, so skip its first node. */
+      double max_rel_err = 0.0;
+      for ( double v = 1.0037e-6 * vmax; v <= vmax; v *= 1.0037 ) {
+        const double exact = avg.exact(v);
+        const double rel_err = std::abs( avg(v) - exact ) / exact;
+        if ( rel_err > max_rel_err )
+          max_rel_err = rel_err;
+      }
+      BOOST_CHECK_LE( max_rel_err, 2.0 * tol );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( fewer_nodes_for_smooth_input ) {
+    const CSPtr c0( new Constant( 1e-19 ) );
+    const CSPtr c1( new Constant( 4e-19 ) );
+    const CSPtr smooth( new Smooth( 1e-19, 1e3 ) );
+    const CSPtr peaked(
+      new Peaked( 1e-19, 1e3, 2e-19, 0.53 * vmax, 1e-2 * vmax ) );
+
+    /* constant input:  nothing beyond the log-spaced seeds. */
+    BOOST_CHECK_EQUAL( nodes( c0, c1, 1e-3 ), 32u );
+
+    /* smooth input needs fewer nodes than the same input with a peak. */
+    const std::size_t n_smooth = nodes( c0, smooth, 1e-3 );
+    const std::size_t n_peaked = nodes( c0, peaked, 1e-3 );
+    BOOST_CHECK_GT( n_smooth, 32u );
+    BOOST_CHECK_LT( n_smooth, n_peaked );
+
+    /* and the node count goes down as the tolerance is relaxed. */
+    BOOST_CHECK_LT( nodes( c0, smooth, 1e-2 ), n_smooth );
+    BOOST_CHECK_LT( n_smooth, nodes( c0, smooth, 1e-4 ) );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
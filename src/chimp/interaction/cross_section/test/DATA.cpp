@@ -0,0 +1,182 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the DATA cross section class.
+ * */
+#define BOOST_TEST_MODULE  DATA
+
+
+#include <chimp/interaction/cross_section/DATA.h>
+#include <chimp/make_options.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  typedef chimp::interaction::cross_section::DATA<
+    chimp::make_options<>::type > DATA;
+  using chimp::interaction::cross_section::DoubleDataSet;
+
+  DoubleDataSet makeTable( const double & v_first ) {
+    DoubleDataSet table;
+    table.insert( std::make_pair( v_first, 0.0   ) );
+    table.insert( std::make_pair( 1.0,     1e-20 ) );
+    table.insert( std::make_pair( 1.1,     5e-20 ) );
+    table.insert( std::make_pair( 2.0,     8e-20 ) );
+    table.insert( std::make_pair( 4.0,     6e-20 ) );
+    table.insert( std::make_pair( 40.0,    1e-20 ) );
+    table.insert( std::make_pair( 400.0,   0.0   ) );
+    return table;
+  }
+
+  void checkGrid( const DATA & data, const double & tolerance ) {
+    const double sigma_max = 8e-20;
+    for ( double v = 0.0; v < 400.0; v += 0.0137 ) {
+      BOOST_CHECK_SMALL( data(v) - data.evalTable(v), tolerance * sigma_max );
+    }
+
+    BOOST_CHECK_EQUAL( data(0.5), data.evalTable(0.5) );
+    BOOST_CHECK_EQUAL( data(400.0), data.evalTable(400.0) );
+    BOOST_CHECK_EQUAL( data(500.0), data.evalTable(500.0) );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( DATA_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( no_grid ) {
+    DATA data( makeTable(0.5) );
+
+    BOOST_CHECK_EQUAL( data.getGridSpacing(), DATA::NO_GRID );
+    BOOST_CHECK_EQUAL( data.getTable().size(), 7u );
+    BOOST_CHECK_EQUAL( data(3.0), data.evalTable(3.0) );
+    BOOST_CHECK_CLOSE( data(3.0), 7e-20, 1e-10 );
+  }
+
+  BOOST_AUTO_TEST_CASE( uniform_grid ) {
+    DATA data( makeTable(0.5) );
+    data.resample( DATA::UNIFORM_GRID, 1e-2 );
+
+    BOOST_CHECK_EQUAL( data.getGridSpacing(), DATA::UNIFORM_GRID );
+    BOOST_CHECK_EQUAL( data.getTable().size(), 7u );
+    checkGrid( data, 1e-2 );
+
+    /* the table must remain unchanged. */
+    BOOST_CHECK_CLOSE( data.evalTable(3.0), 7e-20, 1e-10 );
+  }
+
+  BOOST_AUTO_TEST_CASE( log_grid ) {
+    DATA data( makeTable(0.5) );
+    data.resample( DATA::LOG_GRID, 1e-4 );
+
+    BOOST_CHECK_EQUAL( data.getGridSpacing(), DATA::LOG_GRID );
+    checkGrid( data, 1e-4 );
+
+    /* the log grid needs far fewer bins than the uniform grid for this
+     * data. */
+    data.resample( DATA::LOG_GRID, 1e-2 );
+    DATA udata( makeTable(0.5) );
+    udata.resample( DATA::UNIFORM_GRID, 1e-2 );
+    BOOST_CHECK( data.getGridSize() < udata.getGridSize() );
+  }
+
+  BOOST_AUTO_TEST_CASE( log_grid_from_zero ) {
+    DATA data( makeTable(0.0) );
+    data.resample( DATA::LOG_GRID, 1e-4 );
+
+    BOOST_CHECK_EQUAL( data.getGridSpacing(), DATA::LOG_GRID );
+    checkGrid( data, 1e-4 );
+  }
+
+  BOOST_AUTO_TEST_CASE( remove_grid ) {
+    DATA data( makeTable(0.5) );
+    data.resample( DATA::UNIFORM_GRID );
+    data.resample( DATA::NO_GRID );
+
+    BOOST_CHECK_EQUAL( data.getGridSpacing(), DATA::NO_GRID );
+    BOOST_CHECK_EQUAL( data.getGridSize(), 0u );
+    BOOST_CHECK_EQUAL( data(3.0), data.evalTable(3.0) );
+  }
+
+  BOOST_AUTO_TEST_CASE( batch_evaluate ) {
+    DATA data( makeTable(0.5) );
+
+    std::vector<double> v, sigma;
+    for ( double vi = 0.0; vi < 500.0; vi += 0.37 )
+      v.push_back( vi );
+    sigma.resize( v.size() );
+
+    data.evaluate( &v[0], &sigma[0], v.size() );
+    for ( unsigned int i = 0u; i < v.size(); ++i )
+      BOOST_CHECK_EQUAL( sigma[i], data(v[i]) );
+
+    data.resample( DATA::LOG_GRID );
+    data.evaluate( &v[0], &sigma[0], v.size() );
+    for ( unsigned int i = 0u; i < v.size(); ++i )
+      BOOST_CHECK_EQUAL( sigma[i], data(v[i]) );
+  }
+
+  BOOST_AUTO_TEST_CASE( findMaxSigmaV ) {
+    const DoubleDataSet table = makeTable(0.5);
+    DATA data( table );
+
+    for ( double v_max = 0.0; v_max < 400.0; v_max += 0.173 ) {
+      /* brute-force search of the table. */
+      std::pair<double,double> expected( 0.0, 0.0 );
+      for ( DoubleDataSet::const_iterator i = table.begin();
+            i != table.end() && i->first < v_max; ++i ) {
+        if ( expected.first < i->first * i->second )
+          expected = std::make_pair( i->first * i->second, i->first );
+      }
+      if ( expected.first < v_max * data.evalTable(v_max) )
+        expected = std::make_pair( v_max * data.evalTable(v_max), v_max );
+
+      std::pair<double,double> result = data.findMaxSigmaV( v_max );
+      BOOST_CHECK_CLOSE( result.first, expected.first, 1e-10 );
+      BOOST_CHECK_EQUAL( result.second, expected.second );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( dSigmaV ) {
+    DATA data( makeTable(0.5) );
+    const chimp::interaction::cross_section::Base<
+      chimp::make_options<>::type > & base = data;
+
+    /* between the knots, the analytic derivative must match the default
+     * central difference. */
+    const double v[] = { 0.75, 1.05, 1.5, 3.0, 20.0, 300.0 };
+    for ( unsigned int i = 0u; i < sizeof(v)/sizeof(double); ++i ) {
+      BOOST_CHECK_CLOSE( data.dSigmaV( v[i] ),
+                         base.Base::dSigmaV( v[i] ), 1e-4 );
+    }
+
+    std::vector<double> bp;
+    data.getBreakpoints( 3.0, bp );
+    BOOST_REQUIRE_EQUAL( bp.size(), 4u );
+    BOOST_CHECK_EQUAL( bp.front(), 0.5 );
+    BOOST_CHECK_EQUAL( bp.back(), 2.0 );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
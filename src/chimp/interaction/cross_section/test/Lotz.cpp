@@ -41,6 +41,7 @@
 
 #include <vector>
 #include <fstream>
+#include <cmath>
 
 #ifndef XML_FILENAME
 #  error The filename was supposed to already be defined on the command line
@@ -151,5 +152,47 @@ BOOST_AUTO_TEST_SUITE( Lotz_test ); // {
     }
 
   }
+
+  BOOST_AUTO_TEST_CASE( tabulate ) {
+    xml::Doc doc(XSTR(XML_FILENAME));
+    chimp::prepareCalculator(doc);
+
+    xml::Context x = doc.find("//good/LotzVector");
+    Lotz lotz(x);
+
+    /* the analytic derivative should match a finite difference. */
+    for ( double v = 1.01 * lotz.threshold; v < 50. * lotz.threshold; v *= 1.1 ) {
+      const double h = 1e-6 * v;
+      BOOST_CHECK_CLOSE( lotz.derivative(v),
+                         ( lotz.evalAnalytic(v+h) - lotz.evalAnalytic(v-h) )
+                         / ( 2. * h ),
+                         1e-5 );
+    }
+
+    /* D[v*sigma, v] vanishes at the maximum of v*sigma. */
+    BOOST_CHECK_SMALL( lotz.dSigmaV( lotz.sigmaV_max_vrel )
+                       * lotz.sigmaV_max_vrel / lotz.maxSigmaV, 1e-6 );
+
+    const double v_max = 10. * lotz.sigmaV_max_vrel;
+    const double rel_tol = 1e-6;
+    lotz.tabulate( v_max, rel_tol );
+    BOOST_CHECK( lotz.getTableSize() > 0u );
+
+    const double sigma_max = lotz.maxSigmaV / lotz.sigmaV_max_vrel;
+    const double dv = ( 1.1 * v_max - lotz.threshold ) / 100000.;
+    for ( double v = lotz.threshold; v < 1.1 * v_max; v += dv ) {
+      const double exact = lotz.evalAnalytic(v);
+      BOOST_CHECK_SMALL( lotz(v) - exact,
+                         2. * rel_tol * ( std::abs(exact) + 1e-3 * sigma_max ) );
+    }
+
+    /* beyond the table, the analytic form is used. */
+    BOOST_CHECK_EQUAL( lotz(1.5 * v_max), lotz.evalAnalytic(1.5 * v_max) );
+    BOOST_CHECK_EQUAL( lotz(0.5 * lotz.threshold), 0.0 );
+
+    /* remove the table again. */
+    lotz.tabulate( 0.0 );
+    BOOST_CHECK_EQUAL( lotz.getTableSize(), 0u );
+  }
 BOOST_AUTO_TEST_SUITE_END(); // }  Lotz
 
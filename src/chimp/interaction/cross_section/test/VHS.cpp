@@ -0,0 +1,228 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+/** \file
+ * Test file for the folded VHS kernels and the averaged-diameter
+ * combinations of VHS cross sections.
+ * */
+#define BOOST_TEST_MODULE  VHS
+
+
+#include <chimp/interaction/cross_section/VHS.h>
+#include <chimp/interaction/cross_section/Constant.h>
+#include <chimp/interaction/cross_section/detail/AvgEasy.h>
+#include <chimp/make_options.h>
+
+#include <physical/physical.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <cmath>
+#include <limits>
+
+namespace {
+  typedef chimp::make_options<>::type options;
+  typedef chimp::interaction::cross_section::Base<options> Base;
+  typedef chimp::interaction::cross_section::VHS<options> VHS;
+  typedef chimp::interaction::cross_section::Constant<options> Constant;
+  typedef chimp::interaction::cross_section::detail::AvgEasy<options> AvgEasy;
+  typedef chimp::interaction::cross_section::detail::VHSKernel VHSKernel;
+  typedef chimp::interaction::cross_section::detail::VHSInfo VHSInfo;
+  using chimp::interaction::ReducedMass;
+  typedef boost::shared_ptr<Base> CSPtr;
+
+  const double amu = 1.66053886e-27;
+
+  const double visc_T_laws[] = { 0.5, 0.75, 1.0, 0.81 };
+  const VHSKernel::FORM forms[] = {
+    VHSKernel::CONSTANT_FORM,
+    VHSKernel::RSQRT_SQRT_FORM,
+    VHSKernel::RSQRT_FORM,
+    VHSKernel::GENERAL_FORM
+  };
+
+  /** Unfolded VHS cross section (eqn (4.63) of Bird's book). */
+  struct UnfoldedVHS : Base {
+    double cross_section, T_ref, visc_T_law, mu;
+
+    UnfoldedVHS( const double & cross_section,
+                 const double & T_ref,
+                 const double & visc_T_law,
+                 const double & mu )
+      : cross_section(cross_section), T_ref(T_ref),
+        visc_T_law(visc_T_law), mu(mu) { }
+
+    virtual double operator() ( const double & v ) const {
+      using physical::constant::si::K_B;
+      return cross_section
+           * std::pow( 2.0 * K_B * T_ref
+                       / ( mu * v * v + std::numeric_limits<double>::min() ),
+                       visc_T_law - 0.5 )
+           / tgamma( 2.5 - visc_T_law );
+    }
+
+    virtual std::pair<double,double>
+    findMaxSigmaV( const double & v_rel_max ) const {
+      return std::make_pair( operator()(v_rel_max) * v_rel_max, v_rel_max );
+    }
+
+    virtual UnfoldedVHS * new_load( const chimp::xml::Context & x,
+                        const chimp::interaction::Equation<options> & eq,
+                        const chimp::RuntimeDB<options> & db ) const {
+      return 0;
+    }
+
+    /* Claims to be a VHS model so that AvgEasy accepts it, but AvgEasy
+     * cannot fold its constants, so AvgEasy must use VIRTUAL_FORM. */
+    virtual std::string getLabel() const { return "vhs"; }
+
+    std::ostream & print( std::ostream & out ) const { return out; }
+  };
+
+  VHSInfo makeInfo( const double & cross_section,
+                    const double & T_ref,
+                    const double & visc_T_law ) {
+    VHSInfo info;
+    info.cross_section = cross_section;
+    info.T_ref = T_ref;
+    info.visc_T_law = visc_T_law;
+    info.compute_gamma_visc_inv();
+    return info;
+  }
+
+  ReducedMass makeMu( const double & mu ) {
+    ReducedMass retval;
+    retval.value = mu;
+    return retval;
+  }
+
+  CSPtr makeVHS( const double & cross_section,
+                 const double & T_ref,
+                 const double & visc_T_law,
+                 const double & mu ) {
+    return CSPtr( new VHS( makeInfo( cross_section, T_ref, visc_T_law ),
+                           makeMu( mu ) ) );
+  }
+
+  std::vector<double> velocitySweep() {
+    std::vector<double> v;
+    for ( double vi = 1.0; vi < 1e6; vi *= 1.0713 )
+      v.push_back( vi );
+    return v;
+  }
+
+  /** Check the scalar and batch evaluation of cs against ref. */
+  void checkSweep( const Base & cs, const Base & ref ) {
+    const std::vector<double> v = velocitySweep();
+    std::vector<double> sigma( v.size() );
+    cs.evaluate( &v[0], &sigma[0], v.size() );
+
+    for ( unsigned int i = 0u; i < v.size(); ++i ) {
+      BOOST_CHECK_CLOSE( cs(v[i]), ref(v[i]), 1e-10 );
+      BOOST_CHECK_CLOSE( sigma[i], ref(v[i]), 1e-10 );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( VHS_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( folded_kernel ) {
+    const double mu = 0.5 * 40.0 * amu;
+    for ( unsigned int i = 0u; i < 4u; ++i ) {
+      CSPtr vhs = makeVHS( 4e-19, 273.0, visc_T_laws[i], mu );
+      BOOST_CHECK_EQUAL( dynamic_cast<VHS&>(*vhs).getKernel().form,
+                         forms[i] );
+      checkSweep( *vhs, UnfoldedVHS( 4e-19, 273.0, visc_T_laws[i], mu ) );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( setters_refold ) {
+    const double mu0 = 0.5 * 28.0 * amu;
+    const double mu1 = 0.5 * 40.0 * amu;
+
+    /* a default VHS has a zero cross section until it is set. */
+    VHS vhs;
+    BOOST_CHECK_EQUAL( vhs( 100.0 ), 0.0 );
+
+    vhs.setReducedMass( makeMu( mu0 ) );
+    vhs.setVHSInfo( makeInfo( 4e-19, 273.0, 0.81 ) );
+    checkSweep( vhs, UnfoldedVHS( 4e-19, 273.0, 0.81, mu0 ) );
+
+    vhs.setReducedMass( makeMu( mu1 ) );
+    checkSweep( vhs, UnfoldedVHS( 4e-19, 273.0, 0.81, mu1 ) );
+
+    vhs.setVHSInfo( makeInfo( 1e-19, 300.0, 0.75 ) );
+    BOOST_CHECK_EQUAL( vhs.getKernel().form, VHSKernel::RSQRT_SQRT_FORM );
+    checkSweep( vhs, UnfoldedVHS( 1e-19, 300.0, 0.75, mu1 ) );
+  }
+
+  BOOST_AUTO_TEST_CASE( averaged_single_form ) {
+    const double mu = 0.5 * 28.0 * amu;
+    for ( unsigned int i = 0u; i < 4u; ++i ) {
+      CSPtr vhs0 = makeVHS( 4e-19, 273.0, visc_T_laws[i], mu );
+      CSPtr vhs1 = makeVHS( 1e-19, 300.0, visc_T_laws[i], mu );
+      AvgEasy avg( vhs0, vhs1 );
+      BOOST_CHECK_EQUAL( avg.form, AvgEasy::SINGLE_FORM );
+
+      AvgEasy ref( CSPtr( new UnfoldedVHS( 4e-19, 273.0, visc_T_laws[i], mu ) ),
+                   CSPtr( new UnfoldedVHS( 1e-19, 300.0, visc_T_laws[i], mu )));
+      BOOST_CHECK_EQUAL( ref.form, AvgEasy::VIRTUAL_FORM );
+      checkSweep( avg, ref );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( averaged_two_term_form ) {
+    const double mu0 = 0.5 * 28.0 * amu;
+    const double mu1 = 0.5 * 40.0 * amu;
+    for ( unsigned int i = 0u; i < 4u; ++i ) {
+      const unsigned int j = ( i + 1u ) % 4u;
+      CSPtr vhs0 = makeVHS( 4e-19, 273.0, visc_T_laws[i], mu0 );
+      CSPtr vhs1 = makeVHS( 1e-19, 300.0, visc_T_laws[j], mu1 );
+      AvgEasy avg( vhs0, vhs1 );
+      BOOST_CHECK_EQUAL( avg.form, AvgEasy::TWO_TERM_FORM );
+
+      AvgEasy ref( CSPtr( new UnfoldedVHS(4e-19, 273.0, visc_T_laws[i], mu0) ),
+                   CSPtr( new UnfoldedVHS(1e-19, 300.0, visc_T_laws[j], mu1) ));
+      checkSweep( avg, ref );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( averaged_constant ) {
+    const double mu = 0.5 * 28.0 * amu;
+    for ( unsigned int i = 0u; i < 4u; ++i ) {
+      CSPtr vhs = makeVHS( 4e-19, 273.0, visc_T_laws[i], mu );
+      AvgEasy avg( vhs, CSPtr( new Constant(2e-19) ) );
+      /* Constant has the exponent of visc_T_law == 0.5 */
+      BOOST_CHECK_EQUAL( avg.form, i == 0u ? AvgEasy::SINGLE_FORM
+                                           : AvgEasy::TWO_TERM_FORM );
+
+      AvgEasy ref( CSPtr( new UnfoldedVHS( 4e-19, 273.0, visc_T_laws[i], mu ) ),
+                   CSPtr( new UnfoldedVHS( 2e-19, 273.0, 0.5, mu ) ) );
+      checkSweep( avg, ref );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,222 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Devirtualized storage of the cross sections of a set of equations.
+ * */
+
+#ifndef chimp_interaction_detail_CompiledCrossSections_h
+#define chimp_interaction_detail_CompiledCrossSections_h
+
+#include <chimp/interaction/Equation.h>
+#include <chimp/interaction/cross_section/Base.h>
+#include <chimp/interaction/cross_section/VHS.h>
+#include <chimp/interaction/cross_section/DATA.h>
+#include <chimp/interaction/cross_section/Lotz.h>
+#include <chimp/interaction/cross_section/Constant.h>
+#include <chimp/interaction/cross_section/AveragedDiameters.h>
+#include <chimp/interaction/cross_section/detail/AvgEasy.h>
+
+#include <vector>
+#include <typeinfo>
+
+namespace chimp {
+  namespace interaction {
+    namespace detail {
+
+      /** Compiled form of the cross sections of a list of equations.
+       * Pointers to the library-provided cross section types are stored,
+       * with their static type, in arrays sorted by type such that they can
+       * be evaluated with direct, inlinable (non-virtual) calls.  Any other
+       * cross section type (such as a user-registered type) is evaluated
+       * through the virtual interface.  The cross sections are not copied:
+       * they are owned by the equations, such that state like the
+       * extrapolation count of DATA is shared with the equations and any
+       * change of the parameters of a cross section is seen immediately.
+       *
+       * Only cross sections whose dynamic type is exactly one of the library
+       * types are compiled, so that classes derived from these types still
+       * behave correctly.  An AveragedDiameters instance is stored as its DATA
+       * base since it does not change the evaluation of DATA.
+       * */
+      template < typename options >
+      class CompiledCrossSections {
+        /* TYPEDEFS */
+      public:
+        typedef interaction::Equation<options> Equation;
+        typedef typename Equation::list eq_list;
+
+        typedef cross_section::Base<options>      Base;
+        typedef cross_section::VHS<options>       VHS;
+        typedef cross_section::DATA<options>      DATA;
+        typedef cross_section::Lotz<options>      Lotz;
+        typedef cross_section::Constant<options>  Constant;
+        typedef cross_section::AveragedDiameters<options> AveragedDiameters;
+        typedef cross_section::detail::AvgEasy<options>   AvgEasy;
+
+
+        /* MEMBER STORAGE */
+      private:
+        /** Number of equations that were compiled. */
+        unsigned int n;
+
+        /** The cross section of each equation at the time of compile()
+         * (see isCompiled). */
+        std::vector<const Base *> source;
+
+        std::vector<const VHS *>      vhs;
+        std::vector<unsigned int> vhs_index;
+
+        std::vector<const DATA *>     data;
+        std::vector<unsigned int> data_index;
+
+        std::vector<const Lotz *>     lotz;
+        std::vector<unsigned int> lotz_index;
+
+        std::vector<const Constant *> constant;
+        std::vector<unsigned int> constant_index;
+
+        std::vector<const AvgEasy *>  avg_easy;
+        std::vector<unsigned int> avg_easy_index;
+
+        /** Cross sections of other types (evaluated via the virtual
+         * interface). */
+        std::vector<const Base *> other;
+        std::vector<unsigned int> other_index;
+
+
+        /* MEMBER FUNCTIONS */
+      public:
+        /** Default constructor creates an empty compiled list. */
+        CompiledCrossSections() : n(0u) { }
+
+        /** Compile the cross sections of the given equations.
+         * @param rhs
+         *    The equations to compile.
+         * @param mask
+         *    [Optional] If given, only the cross sections of equations i for
+         *    which mask[i] is true are compiled; evaluate() does not write
+         *    the remaining entries of its output.  The indices still refer to
+         *    rhs and size() still returns rhs.size().
+         * */
+        void compile( const eq_list & rhs,
+                      const std::vector<bool> & mask = std::vector<bool>() ) {
+          clear();
+
+          for ( unsigned int i = 0u; i < rhs.size(); ++i ) {
+            source.push_back( rhs[i].cs.get() );
+            if ( !mask.empty() && !mask[i] )
+              continue;
+
+            const Base & cs = *rhs[i].cs;
+            const std::type_info & t = typeid(cs);
+
+            if ( t == typeid(VHS) ) {
+              vhs.push_back( static_cast<const VHS *>(&cs) );
+              vhs_index.push_back( i );
+            } else if ( t == typeid(DATA) || t == typeid(AveragedDiameters) ) {
+              data.push_back( static_cast<const DATA *>(&cs) );
+              data_index.push_back( i );
+            } else if ( t == typeid(Lotz) ) {
+              lotz.push_back( static_cast<const Lotz *>(&cs) );
+              lotz_index.push_back( i );
+            } else if ( t == typeid(Constant) ) {
+              constant.push_back( static_cast<const Constant *>(&cs) );
+              constant_index.push_back( i );
+            } else if ( t == typeid(AvgEasy) ) {
+              avg_easy.push_back( static_cast<const AvgEasy *>(&cs) );
+              avg_easy_index.push_back( i );
+            } else {
+              other.push_back( &cs );
+              other_index.push_back( i );
+            }
+          }
+
+          n = rhs.size();
+        }
+
+        /** Remove all compiled cross sections. */
+        void clear() {
+          n = 0u;
+          source.clear();
+          vhs.clear();        vhs_index.clear();
+          data.clear();       data_index.clear();
+          lotz.clear();       lotz_index.clear();
+          constant.clear();   constant_index.clear();
+          avg_easy.clear();   avg_easy_index.clear();
+          other.clear();      other_index.clear();
+        }
+
+        /** The number of equations that were compiled. */
+        unsigned int size() const { return n; }
+
+        /** Whether the given equations still have the cross sections that
+         * were compiled, i.e. none were added, removed, or replaced since
+         * compile(). */
+        bool isCompiled( const eq_list & rhs ) const {
+          if ( rhs.size() != n )
+            return false;
+          for ( unsigned int i = 0u; i < n; ++i )
+            if ( rhs[i].cs.get() != source[i] )
+              return false;
+          return true;
+        }
+
+        /** Number of cross sections that must be evaluated via the virtual
+         * interface. */
+        unsigned int numberVirtual() const { return other.size(); }
+
+        /** Evaluate all of the cross sections at the given relative speed.
+         * @param v_relative
+         *    The relative speed.
+         * @param sigma
+         *    [output] Array of size() cross sections in the order of the
+         *    equations that were compiled.
+         * */
+        inline void evaluate( const double & v_relative, double * sigma ) const {
+          for ( unsigned int i = 0u; i < vhs.size(); ++i )
+            sigma[ vhs_index[i] ] = vhs[i]->VHS::operator()( v_relative );
+
+          for ( unsigned int i = 0u; i < data.size(); ++i )
+            sigma[ data_index[i] ] = data[i]->DATA::operator()( v_relative );
+
+          for ( unsigned int i = 0u; i < lotz.size(); ++i )
+            sigma[ lotz_index[i] ] = lotz[i]->Lotz::operator()( v_relative );
+
+          for ( unsigned int i = 0u; i < constant.size(); ++i )
+            sigma[ constant_index[i] ] = constant[i]->value;
+
+          for ( unsigned int i = 0u; i < avg_easy.size(); ++i )
+            sigma[ avg_easy_index[i] ]
+              = avg_easy[i]->AvgEasy::operator()( v_relative );
+
+          for ( unsigned int i = 0u; i < other.size(); ++i )
+            sigma[ other_index[i] ] = (*other[i])( v_relative );
+        }
+      };
+
+    }/* namespace chimp::interaction::detail */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_detail_CompiledCrossSections_h
@@ -24,30 +24,76 @@
 #ifndef chimp_interaction_detail_DriverRetval_h
 #define chimp_interaction_detail_DriverRetval_h
 
+#include <utility>
+#include <vector>
+
 namespace chimp {
   namespace interaction {
     namespace detail {
 
-      /** Implementation of OUT-OF-PLACE interactions!! */
+      /** Handling of the particles of an interaction that created products,
+       * depending on whether interactions are done in place.
+       *
+       * During the pass over a cell, the input particles of such
+       * interactions are only marked as removed (in the driver Workspace).
+       * The schemes avoid selecting marked particles again, and compact()
+       * removes all marked particles of each species range at once, at the
+       * end of the pass over the cell.
+       */
       template < bool InplaceInteractions >
       struct DriverRetval;
 
 
-      /** Implementation of OUT-OF-PLACE interactions!! */
+      /** Implementation of OUT-OF-PLACE interactions!!  The input particles
+       * are never removed by the driver. */
       template <>
       struct DriverRetval<false> {
-        template < typename Path, typename PIter, typename Iq, typename Eq,
-                   typename Range >
+        template < typename Path, typename PIter, typename Iq,
+                   typename Workspace, typename Range >
         void operator() ( const Path & path,
                           const std::pair<PIter, PIter> & pair,
                           const Iq & iq,
                           const size_t & iq_sz_i,
-                          Eq & eq,
+                          Workspace & ws,
                           const unsigned int & A,
                           const unsigned int & B,
-                          Range & aRange,
-                          Range & bRange
+                          const Range & aRange,
+                          const Range & bRange
                         ) { }
+
+        /** Same as above, given whether products were created. */
+        template < typename Path, typename PIter,
+                   typename Workspace, typename Range >
+        void operator() ( const Path & path,
+                          const std::pair<PIter, PIter> & pair,
+                          const bool & created,
+                          Workspace & ws,
+                          const unsigned int & A,
+                          const unsigned int & B,
+                          const Range & aRange,
+                          const Range & bRange
+                        ) { }
+
+        /** Whether the given particle (by index into the range of its
+         * species) has been removed. */
+        template < typename Workspace >
+        static bool removed( const Workspace & ws,
+                             const unsigned int & A,
+                             const unsigned int & i ) {
+          return false;
+        }
+
+        /** Mark the given particle (by index into the range of its species,
+         * which has n particles) as removed. */
+        template < typename Workspace >
+        static void markRemoved( Workspace & ws,
+                                 const unsigned int & A,
+                                 const unsigned int & i,
+                                 const unsigned int & n ) { }
+
+        /** Remove the marked particles from the species ranges. */
+        template < typename Workspace, typename CellInfo, typename Eq >
+        static void compact( Workspace & ws, CellInfo & cell, Eq & eq ) { }
       };
 
 
@@ -56,47 +102,102 @@ namespace chimp {
       /** Implementation of IN-PLACE interactions!! */
       template <>
       struct DriverRetval<true> {
-        template < typename Path, typename PIter, typename Iq, typename Eq,
-                   typename Range >
+        /** Mark the input particles for removal if the path is valid AND
+         * products were created--if no products were created, we assume the
+         * interaction operated on the particles in place. */
+        template < typename Path, typename PIter, typename Iq,
+                   typename Workspace, typename Range >
         void operator() ( const Path & path,
                           const std::pair<PIter, PIter> & pair,
                           const Iq & iq,
                           const size_t & iq_sz_i,
-                          Eq & eq,
+                          Workspace & ws,
                           const unsigned int & A,
                           const unsigned int & B,
-                          Range & aRange,
-                          Range & bRange
+                          const Range & aRange,
+                          const Range & bRange
                         ) {
+          (*this)( path, pair, iq.size() > iq_sz_i, ws, A, B, aRange, bRange );
+        }
 
-          if ( path.first < 0 || iq.size() <= iq_sz_i )
+        /** Same as above, given whether products were created. */
+        template < typename Path, typename PIter,
+                   typename Workspace, typename Range >
+        void operator() ( const Path & path,
+                          const std::pair<PIter, PIter> & pair,
+                          const bool & created,
+                          Workspace & ws,
+                          const unsigned int & A,
+                          const unsigned int & B,
+                          const Range & aRange,
+                          const Range & bRange
+                        ) {
+          if ( path.first < 0 || !created )
             return;
 
-          /* the path IS valid AND products were created:
-           *    remove the initial pair--if no products were created, we assume
-           *    the interaction operated on the particles in place.
-           */
-          PIter last = aRange.end() -1;
-          eq.insert( last ); // queue the deletion
-
-          if ( pair.second == last ) {
-            /* we have to take care of this one special case */
-            assert( A == B );
-            --last;
-            *pair.first = *last;
-          } else {
-            *pair.first = *last; // move the last up
-            /* set the new range for A species. */
-            aRange = SpeciesRange( aRange.begin(), last );
-
-            last = bRange.end() -1;
-            *pair.second = *last; // move the last up
-          }
+          ws.markRemoved( A, pair.first  - aRange.begin(), aRange.size() );
+          ws.markRemoved( B, pair.second - bRange.begin(), bRange.size() );
+        }
 
-          eq.insert( last ); // queue the deletion
-          /* set the new range for B species. */
-          bRange = SpeciesRange( bRange.begin(), last );
+        /** Whether the given particle (by index into the range of its
+         * species) has been removed. */
+        template < typename Workspace >
+        static bool removed( const Workspace & ws,
+                             const unsigned int & A,
+                             const unsigned int & i ) {
+          return ws.n_removed[A] > 0u && ws.removed[A][i];
+        }
 
+        /** Mark the given particle (by index into the range of its species,
+         * which has n particles) as removed. */
+        template < typename Workspace >
+        static void markRemoved( Workspace & ws,
+                                 const unsigned int & A,
+                                 const unsigned int & i,
+                                 const unsigned int & n ) {
+          ws.markRemoved( A, i, n );
+        }
+
+        /** Remove the marked particles from the species ranges.  The holes
+         * are filled with the last particles of each range (which thus does
+         * not preserve the order of the particles), the ranges are shrunk,
+         * and the positions left at the end of each range are queued for
+         * deletion in eq.
+         */
+        template < typename Workspace, typename CellInfo, typename Eq >
+        static void compact( Workspace & ws, CellInfo & cell, Eq & eq ) {
+          typedef typename CellInfo::SpeciesRange SpeciesRange;
+          typedef typename SpeciesRange::iterator PIter;
+
+          for ( unsigned int A = 0u; A < ws.n_species; ++A ) {
+            if ( ws.n_removed[A] == 0u )
+              continue;
+
+            SpeciesRange & range = cell.getSpecies(A);
+            std::vector<char> & dead = ws.removed[A];
+            const PIter begin = range.begin();
+            unsigned int lo = 0u, hi = range.size();
+
+            while ( true ) {
+              while ( lo < hi && !dead[lo] )
+                ++lo;
+              while ( lo < hi && dead[hi-1u] )
+                --hi;
+              if ( lo >= hi )
+                break;
+
+              /* move the last live particle into the hole. */
+              --hi;
+              *(begin + lo) = *(begin + hi);
+              ++lo;
+            }
+
+            for ( PIter i = begin + hi, end = range.end(); i != end; ++i )
+              eq.insert( i ); // queue the deletion
+
+            range = SpeciesRange( begin, begin + hi );
+            ws.n_removed[A] = 0u;
+          }
         }
       };
 
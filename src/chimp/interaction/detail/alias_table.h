@@ -0,0 +1,113 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Construction of Walker alias tables for O(1) sampling of discrete
+ * distributions.
+ * */
+
+#ifndef chimp_interaction_detail_alias_table_h
+#define chimp_interaction_detail_alias_table_h
+
+#include <vector>
+
+namespace chimp {
+  namespace interaction {
+    namespace detail {
+
+      /** Build a Walker alias table for the (un-normalized) discrete
+       * distribution given by the weights.  This uses the construction of
+       * M. D. Vose, IEEE Trans. Softw. Eng. 17, 972-975 (1991).
+       *
+       * To sample from the table, pick a column j uniformly from [0,n) and a
+       * uniform number u from [0,1).  If u < prob[j], j is the result;
+       * otherwise, alias[j] is the result.
+       *
+       * If the sum of the weights is zero, each column will simply return its
+       * own index.
+       *
+       * @param weights
+       *    Array of n non-negative weights.
+       * @param n
+       *    Number of weights.
+       * @param prob
+       *    [output] Array of n acceptance probabilities.
+       * @param alias
+       *    [output] Array of n alias indices.
+       * */
+      inline void buildAliasTable( const double * weights,
+                                   const unsigned int & n,
+                                   double * prob,
+                                   int * alias ) {
+        double total = 0.0;
+        for ( unsigned int i = 0u; i < n; ++i )
+          total += weights[i];
+
+        if ( total <= 0.0 ) {
+          for ( unsigned int i = 0u; i < n; ++i ) {
+            prob[i] = 1.0;
+            alias[i] = i;
+          }
+          return;
+        }
+
+        std::vector<double> scaled(n);
+        std::vector<unsigned int> small, large;
+        small.reserve(n);
+        large.reserve(n);
+
+        for ( unsigned int i = 0u; i < n; ++i ) {
+          scaled[i] = weights[i] * n / total;
+          alias[i] = i;
+          if ( scaled[i] < 1.0 )
+            small.push_back(i);
+          else
+            large.push_back(i);
+        }
+
+        while ( !small.empty() && !large.empty() ) {
+          unsigned int s = small.back(); small.pop_back();
+          unsigned int l = large.back(); large.pop_back();
+
+          prob[s] = scaled[s];
+          alias[s] = l;
+
+          scaled[l] = ( scaled[l] + scaled[s] ) - 1.0;
+          if ( scaled[l] < 1.0 )
+            small.push_back(l);
+          else
+            large.push_back(l);
+        }
+
+        /* anything left over is only there because of round-off error. */
+        for ( unsigned int i = 0u; i < large.size(); ++i )
+          prob[ large[i] ] = 1.0;
+        for ( unsigned int i = 0u; i < small.size(); ++i )
+          prob[ small[i] ] = 1.0;
+      }
+
+    }/* namespace chimp::interaction::detail */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_detail_alias_table_h
@@ -33,6 +33,7 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <cstddef>
 
 namespace chimp {
 
@@ -51,11 +52,13 @@ namespace chimp {
       template < typename T, bool creat_const >
       struct TypeRef {
         typedef T & const_ref;
+        typedef T * const_ptr;
       };
 
       template < typename T >
       struct TypeRef<T,false> {
         typedef const T & const_ref;
+        typedef const T * const_ptr;
       };
 
       /** The base class for interaction models.  */
@@ -63,9 +66,13 @@ namespace chimp {
       struct Base {
         /* TYPEDEFS */
         typedef typename options::Particle Particle;
+        typedef typename options::ProductSink ProductSink;
         typedef typename TypeRef<
           Particle, options::inplace_interactions
         >::const_ref ParticleArgRef;
+        typedef typename TypeRef<
+          Particle, options::inplace_interactions
+        >::const_ptr ParticleArgPtr;
 
         /* MEMBER FUNCTIONS */
         /** Virtual NO-OP destructor. */
@@ -77,7 +84,7 @@ namespace chimp {
         /** Two-body collision interface. */
         virtual void interact( ParticleArgRef part1,
                                ParticleArgRef part2,
-                               std::vector< Particle > & products,
+                               ProductSink & products,
                                typename options::RNG & rng ) {
           throw std::runtime_error(
             "Two body interactions are not supported by "
@@ -85,11 +92,32 @@ namespace chimp {
           );
         }
 
-        /** Three-body collision interface. */
+        /** Batched two-body collision interface.  The pairs
+         * (*part1[k], *part2[k]) for k < n interact as with the two-body
+         * interface.  The products of pair k are
+         * products[ends[k-1]:ends[k]] (where ends[-1] is the initial size
+         * of products).  The pairs must not share particles.  This default
+         * implementation interacts the pairs one at a time; models may
+         * override it to process the pairs together.
+         */
+        virtual void interact( const ParticleArgPtr * part1,
+                               const ParticleArgPtr * part2,
+                               const unsigned int & n,
+                               ProductSink & products,
+                               std::size_t * ends,
+                               typename options::RNG & rng ) {
+          for ( unsigned int k = 0u; k < n; ++k ) {
+            this->interact( *part1[k], *part2[k], products, rng );
+            ends[k] = products.size();
+          }
+        }
+
+        /** Three-body collision interface.  The particles are given in the
+         * order of increasing species (see Set::performInteraction). */
         virtual void interact( ParticleArgRef part1,
                                ParticleArgRef part2,
                                ParticleArgRef part3,
-                               std::vector< Particle > & products,
+                               ProductSink & products,
                                typename options::RNG & rng ) {
           throw std::runtime_error(
             "Three body interactions are not supported by "
@@ -32,6 +32,8 @@
 #include <chimp/interaction/Term.h>
 #include <chimp/interaction/Equation.h>
 #include <chimp/interaction/model/Base.h>
+#include <chimp/interaction/model/detail/weight_split.h>
+#include <chimp/interaction/model/detail/scatter.h>
 #include <chimp/interaction/ReducedMass.h>
 
 #include <xylose/power.h>
@@ -41,6 +43,7 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 #include <cassert>
 
 namespace chimp {
@@ -52,6 +55,7 @@ namespace chimp {
       struct Elastic : Base<options> {
         /* TYPEDEFS */
         typedef typename options::Particle Particle;
+        typedef typename options::ProductSink ProductSink;
 
 
         /* STATIC STORAGE */
@@ -83,28 +87,119 @@ namespace chimp {
           return label;
         }
 
-        /** Two-body collision interface.  const particle version. */
+        /** Two-body collision interface.  const particle version.  If the
+         * weights of the particles differ, the heavier particle is split (see
+         * detail::splitWeights) and three products are created, unless
+         * options::split_weights is false (see detail::scatterUnsplit). */
         virtual void interact( const Particle & part1,
                                const Particle & part2,
-                               std::vector< Particle > & products,
+                               ProductSink & products,
                                typename options::RNG & rng )  {
-          products.reserve( products.size() + 2u );
+          const std::size_t i = products.size();
+          products.reserve( i + detail::splitSize( part1, part2,
+                                                   options::split_weights ) );
           products.push_back( part1 );
           products.push_back( part2 );
 
-          typename std::vector< Particle >::reverse_iterator rbeg
-            = products.rbegin();
-          interact( *(rbeg+1), *rbeg, rng );
+          if ( !options::split_weights ) {
+            detail::scatterUnsplit( *this, products[i], products[i+1u], rng );
+            return;
+          }
+
+          detail::splitWeights( products, i );
+          interact( products[i], products[i+1u], rng );
         }
 
-        /** Two-body collision interface.  in-place operation version */
+        /** Two-body collision interface.  in-place operation version.  If the
+         * weights of the particles differ, the interaction cannot be done in
+         * place and all of the products are created instead, unless
+         * options::split_weights is false (see detail::scatterUnsplit). */
         virtual void interact( Particle & part1,
                                Particle & part2,
-                               std::vector< Particle > & products,
+                               ProductSink & products,
                                typename options::RNG & rng )  {
+          using chimp::accessors::particle::weight;
+
+          if ( !options::split_weights ) {
+            detail::scatterUnsplit( *this, part1, part2, rng );
+            return;
+          }
+
+          if ( weight(part1) != weight(part2) ) {
+            const Particle & p1 = part1, & p2 = part2;
+            interact( p1, p2, products, rng );
+            return;
+          }
+
           interact( part1, part2, rng );
         }
 
+        /** Batched two-body collision interface.  const particle version.
+         * @see detail::scatterCopies. */
+        virtual void interact( const Particle * const * part1,
+                               const Particle * const * part2,
+                               const unsigned int & n,
+                               ProductSink & products,
+                               std::size_t * ends,
+                               typename options::RNG & rng ) {
+          detail::scatterCopies( *this, part1, part2, n, products, ends, rng,
+                                 options::split_weights );
+        }
+
+        /** Batched two-body collision interface.  in-place operation
+         * version.  @see detail::scatterInPlace. */
+        virtual void interact( Particle * const * part1,
+                               Particle * const * part2,
+                               const unsigned int & n,
+                               ProductSink & products,
+                               std::size_t * ends,
+                               typename options::RNG & rng ) {
+          detail::scatterInPlace( *this, part1, part2, n, products, ends, rng,
+                                  options::split_weights );
+        }
+
+        /** Binary elastic collision of the pairs (*part1[k], *part2[k]) for
+         * k < n <= detail::scatter_chunk.  This is equivalent to calling
+         * interact(*part1[k], *part2[k], rng) for each pair, but the random
+         * numbers are drawn for all pairs first and the azimuth is sampled
+         * without trigonometric functions (detail::randomAzimuth). */
+        void scatter( Particle * const * part1,
+                      Particle * const * part2,
+                      const unsigned int & n,
+                      typename options::RNG & rng ) {
+          using xylose::Vector;
+          using xylose::V3;
+          using chimp::accessors::particle::velocity;
+          using chimp::accessors::particle::setVelocity;
+
+          double B[detail::scatter_chunk],
+                 COSC[detail::scatter_chunk],
+                 SINC[detail::scatter_chunk];
+
+          /* B is the cosine of a random elevation angle */
+          for ( unsigned int k = 0u; k < n; ++k )
+            B[k] = 2.0 * rng.rand() - 1.0;
+
+          for ( unsigned int k = 0u; k < n; ++k )
+            detail::randomAzimuth( rng, COSC[k], SINC[k] );
+
+          for ( unsigned int k = 0u; k < n; ++k ) {
+            const Vector<double,3> v1 = velocity(*part1[k]);
+            const Vector<double,3> v2 = velocity(*part2[k]);
+
+            const Vector<double,3> VelCM = (mu.over_m2 * v1) +
+                                           (mu.over_m1 * v2);
+            const double SpeedRel = (v1 - v2).abs();
+            const double A = std::sqrt( 1.0 - B[k]*B[k] ) * SpeedRel;
+
+            const Vector<double,3> VelRelPost =
+              V3( B[k] * SpeedRel, A * COSC[k], A * SINC[k] );
+
+            setVelocity(*part1[k], VelCM + ( mu.over_m1 * VelRelPost ) );
+            setVelocity(*part2[k], VelCM - ( mu.over_m2 * VelRelPost ) );
+          }
+        }
+
         /** Binary elastic collision. */
         void interact( Particle & part1, Particle & part2,
                        typename options::RNG & rng ) {
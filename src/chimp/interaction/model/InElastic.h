@@ -28,9 +28,15 @@
 #ifndef chimp_interaction_model_InElastic_h
 #define chimp_interaction_model_InElastic_h
 
+#include <chimp/accessors.h>
+#include <chimp/property/mass.h>
 #include <chimp/interaction/Equation.h>
+#include <chimp/interaction/ReducedMass.h>
 #include <chimp/interaction/model/Base.h>
+#include <chimp/interaction/model/detail/scatter.h>
+#include <chimp/interaction/model/detail/inelastic_helpers.h>
 
+#include <xylose/logger.h>
 #include <xylose/power.h>
 #include <xylose/Vector.h>
 #include <xylose/xml/Doc.h>
@@ -38,24 +44,159 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
 
 namespace chimp {
   namespace interaction {
     namespace model {
 
-      /** Implementation of an <b>in</b>elastic interaction model. */
+      /** Implementation of an <b>in</b>elastic interaction model.  The input
+       * particles (two or three) are replaced by the products of the
+       * equation.  The relative kinetic energy of the inputs, less the
+       * threshold energy of the interaction (the <threshold_energy> of the
+       * xml description), is distributed among the products in the center of
+       * mass frame, such that momentum is conserved.  Two products scatter
+       * isotropically.  The velocities of more than two products are sampled
+       * uniformly from their phase space (the surface of constant energy at
+       * zero total momentum), that is, according to the statistical model of
+       * the decay.  A negative threshold energy (such as for recombination)
+       * is released to the products.
+       *
+       * If the relative kinetic energy of the inputs is below the threshold
+       * energy (such as for a cross section that does not vanish below the
+       * threshold), the interaction is rejected:  no products are created,
+       * which leaves in-place inputs unchanged.  A warning is logged for the
+       * first such rejection.
+       *
+       * The products (species, masses, and which input particle each one is
+       * copied from) are compiled into a flat list when the model is loaded
+       * such that no lookups are required per interaction.  All the products
+       * of an interaction are reserved in the product sink at once (see
+       * interaction::ProductSlab for preallocated product storage).
+       *
+       * If the weights of the input particles differ, the products take the
+       * smallest weight and the remainder of each heavier particle is also
+       * emitted with its pre-interaction state (see detail::splitWeights).
+       * This is done regardless of options::split_weights, which only
+       * applies to the elastic models.
+       */
       template < typename options >
       struct InElastic : Base<options> {
         /* TYPEDEFS */
         typedef typename options::Particle Particle;
+        typedef typename options::ProductSink ProductSink;
+
+        /** A product particle of the equation. */
+        struct Product {
+          /** Species of the product. */
+          int species;
+
+          /** Mass of the product. */
+          double mass;
+
+          /** Input particle from which the product is copied (0, 1, or 2 for
+           * the particle of species Input::A, Input::B, or Input::C).  This
+           * is an input of the same species if any, otherwise the input of
+           * the closest mass. */
+          unsigned int source;
+
+          /** Constructor. */
+          Product( const int & species = 0,
+                   const double & mass = 0.0,
+                   const unsigned int & source = 0u )
+            : species( species ), mass( mass ), source( source ) { }
+        };
 
 
         /* STATIC STORAGE */
         static const std::string label;
 
 
+        /* MEMBER STORAGE */
+        /** Reduced mass of the (first two) inputs. */
+        ReducedMass mu;
+
+        /** Species of the input Input::A. */
+        int species_A;
+
+        /** Energy lost by the interaction. */
+        double threshold_energy;
+
+        /** The products, one entry per particle. */
+        std::vector<Product> outputs;
+
+        /** Masses of the inputs, in the order of Input::A, B, (and C). */
+        std::vector<double> input_mass;
+
+        /** Reduced mass of the two products (if there are two). */
+        ReducedMass mu_out;
+
+        /** Total mass of the inputs. */
+        double m_in;
+
+        /** Ratio of the total mass of the inputs to that of the products. */
+        double mass_ratio;
+
+        /** Number of interactions rejected below the threshold energy.  This
+         * is counted atomically since the model may be used concurrently
+         * (such as by ParallelDriver). */
+        mutable unsigned int rejects_done;
+
 
         /* MEMBER FUNCTIONS */
+        /** Default constructor creates a model without any products. */
+        InElastic()
+          : mu(), species_A( 0 ), threshold_energy( 0.0 ), outputs(),
+            input_mass(), mu_out(), m_in( 0.0 ), mass_ratio( 1.0 ),
+            rejects_done( 0u ) { }
+
+        /** Constructor for two-body interactions.
+         * @param mu
+         *    Reduced mass of the inputs.
+         * @param species_A
+         *    Species of the first input (Input::A).
+         * @param threshold_energy
+         *    Energy lost by the interaction.
+         * @param outputs
+         *    The products of the interaction.
+         */
+        InElastic( const ReducedMass & mu,
+                   const int & species_A,
+                   const double & threshold_energy,
+                   const std::vector<Product> & outputs )
+          : mu( mu ), species_A( species_A ),
+            threshold_energy( threshold_energy ), outputs( outputs ),
+            input_mass(), mu_out(), m_in( 0.0 ), mass_ratio( 1.0 ),
+            rejects_done( 0u ) {
+          input_mass.push_back( mu.value / mu.over_m1 );
+          input_mass.push_back( mu.value / mu.over_m2 );
+          init();
+        }
+
+        /** Constructor for two- or three-body interactions.
+         * @param input_mass
+         *    Masses of the two or three inputs, in the order of increasing
+         *    species (Input::A, B, and C).
+         * @param species_A
+         *    Species of the first input (Input::A).
+         * @param threshold_energy
+         *    Energy lost by the interaction.
+         * @param outputs
+         *    The products of the interaction.
+         */
+        InElastic( const std::vector<double> & input_mass,
+                   const int & species_A,
+                   const double & threshold_energy,
+                   const std::vector<Product> & outputs )
+          : mu( input_mass.at(0), input_mass.at(1) ), species_A( species_A ),
+            threshold_energy( threshold_energy ), outputs( outputs ),
+            input_mass( input_mass ), mu_out(), m_in( 0.0 ),
+            mass_ratio( 1.0 ), rejects_done( 0u ) {
+          init();
+        }
+
         /** Virtual NO-OP destructor. */
         virtual ~InElastic() { }
 
@@ -64,11 +205,264 @@ namespace chimp {
           return label;
         }
 
+        /** Two-body collision interface.  const particle version. */
+        virtual void interact( const Particle & part1,
+                               const Particle & part2,
+                               ProductSink & products,
+                               typename options::RNG & rng ) {
+          using chimp::accessors::particle::species;
+
+          const Particle * in[2] = { &part1, &part2 };
+          if ( species(part1) != species_A )
+            std::swap( in[0], in[1] );
+          emit( in, 2u, products, rng );
+        }
+
+        /** Two-body collision interface.  in-place operation version.  The
+         * species change, so all of the products are created instead. */
+        virtual void interact( Particle & part1,
+                               Particle & part2,
+                               ProductSink & products,
+                               typename options::RNG & rng ) {
+          const Particle & p1 = part1, & p2 = part2;
+          interact( p1, p2, products, rng );
+        }
+
+        /** Three-body collision interface.  const particle version.  The
+         * inputs may be given in any order. */
+        virtual void interact( const Particle & part1,
+                               const Particle & part2,
+                               const Particle & part3,
+                               ProductSink & products,
+                               typename options::RNG & rng ) {
+          using chimp::accessors::particle::species;
+
+          /* sort the inputs by species, as Input::A, B, and C. */
+          const Particle * in[3] = { &part1, &part2, &part3 };
+          if ( species(*in[0]) > species(*in[1]) ) std::swap( in[0], in[1] );
+          if ( species(*in[1]) > species(*in[2]) ) std::swap( in[1], in[2] );
+          if ( species(*in[0]) > species(*in[1]) ) std::swap( in[0], in[1] );
+          emit( in, 3u, products, rng );
+        }
+
+        /** Three-body collision interface.  in-place operation version.  The
+         * species change, so all of the products are created instead. */
+        virtual void interact( Particle & part1,
+                               Particle & part2,
+                               Particle & part3,
+                               ProductSink & products,
+                               typename options::RNG & rng ) {
+          const Particle & p1 = part1, & p2 = part2, & p3 = part3;
+          interact( p1, p2, p3, products, rng );
+        }
+
+        /** Create the products of the interaction of the n_in input
+         * particles, given in the order of input_mass. */
+        void emit( const Particle * const * in,
+                   const unsigned int & n_in,
+                   ProductSink & out,
+                   typename options::RNG & rng ) const {
+          using xylose::SQR;
+          using xylose::Vector;
+          using chimp::accessors::particle::weight;
+          using chimp::accessors::particle::setWeight;
+          using chimp::accessors::particle::species;
+          using chimp::accessors::particle::setSpecies;
+          using chimp::accessors::particle::velocity;
+          using chimp::accessors::particle::setVelocity;
+
+          Vector<double,3> v[3];
+          float w_in[3];
+          Vector<double,3> P = 0.0;
+          float w = weight(*in[0]);
+          for ( unsigned int k = 0u; k < n_in; ++k ) {
+            v[k] = velocity(*in[k]);
+            w_in[k] = weight(*in[k]);
+            w = std::min( w, w_in[k] );
+            P += input_mass[k] * v[k];
+          }
+
+          /* velocity of the center of mass (of the products). */
+          const Vector<double,3> VelCM = ( mass_ratio / m_in ) * P;
+
+          /* kinetic energy in the center of mass frame after the loss. */
+          double E_rel = 0.0;
+          for ( unsigned int k = 0u; k < n_in; ++k )
+            for ( unsigned int l = k + 1u; l < n_in; ++l )
+              E_rel += input_mass[k] * input_mass[l] * SQR( (v[k]-v[l]).abs() );
+          const double E = 0.5 * E_rel / m_in - threshold_energy;
+          if ( E < 0.0 ) {
+            unsigned int n_rejects;
+#ifdef _OPENMP
+            #pragma omp atomic capture
+#endif
+            n_rejects = rejects_done++;
+
+            if ( n_rejects == 0u ) {
+              using xylose::logger::log_warning;
+              log_warning( "InElastic interaction rejected %g below the "
+                           "threshold energy", -E );
+              log_warning( "NOTE:  rejection warning only issued once!" );
+            }
+            return;
+          }
+
+          const unsigned int n = outputs.size();
+          unsigned int n_remainders = 0u;
+          for ( unsigned int k = 0u; k < n_in; ++k )
+            n_remainders += ( w_in[k] != w ? 1u : 0u );
+
+          const std::size_t i = out.size();
+          out.reserve( i + n + n_remainders );
+
+          for ( unsigned int j = 0u; j < n; ++j ) {
+            out.push_back( *in[ outputs[j].source ] );
+            setSpecies( out.back(), outputs[j].species );
+            setWeight( out.back(), w );
+          }
+
+          /* velocities of the products. */
+          if ( n == 1u )
+            setVelocity( out[i], VelCM );
+          else if ( n == 2u ) {
+            const Vector<double,3> VelRelPost =
+              std::sqrt( 2.0 * E / mu_out.value )
+              * detail::randomDirection( rng );
+            setVelocity( out[i],    VelCM + ( mu_out.over_m1 * VelRelPost ) );
+            setVelocity( out[i+1u], VelCM - ( mu_out.over_m2 * VelRelPost ) );
+          } else if ( n > 2u ) {
+            /* In the coordinates sqrt(m_j)*v_j, the phase space of the
+             * products is a sphere within the subspace of zero momentum.
+             * Velocities of a Maxwellian distribution (of any temperature)
+             * are isotropic in these coordinates, so that projecting them to
+             * zero momentum (subtracting the velocity of their center of mass)
+             * and scaling them to the available energy samples the sphere
+             * uniformly. */
+            Vector<double,3> P = 0.0;
+            double M = 0.0;
+            for ( unsigned int j = 0u; j < n; ++j ) {
+              const Vector<double,3> u = ( 1.0 / std::sqrt(outputs[j].mass) )
+                                       * detail::randomNormal( rng );
+              setVelocity( out[i+j], u );
+              P += outputs[j].mass * u;
+              M += outputs[j].mass;
+            }
+
+            const Vector<double,3> U = P / M;
+            double K = 0.0;
+            for ( unsigned int j = 0u; j < n; ++j )
+              K += 0.5 * outputs[j].mass
+                       * SQR( (velocity(out[i+j]) - U).abs() );
+
+            const double scale = ( K > 0.0 ) ? std::sqrt( E / K ) : 0.0;
+            for ( unsigned int j = 0u; j < n; ++j )
+              setVelocity( out[i+j],
+                           VelCM + scale * ( velocity(out[i+j]) - U ) );
+          }
+
+          /* the parts of the heavier particles that did not interact. */
+          for ( unsigned int k = 0u; k < n_in; ++k ) {
+            if ( w_in[k] != w ) {
+              out.push_back( *in[k] );
+              setWeight( out.back(), w_in[k] - w );
+            }
+          }
+        }
+
+        /** Create the products of the interaction of pA (of species
+         * Input::A) and pB. */
+        void emit( const Particle & pA,
+                   const Particle & pB,
+                   ProductSink & out,
+                   typename options::RNG & rng ) const {
+          const Particle * in[2] = { &pA, &pB };
+          emit( in, 2u, out, rng );
+        }
+
+        /** The number of interactions rejected below the threshold energy
+         * till now. */
+        const unsigned int & getNumberRejects() const {
+          return rejects_done;
+        }
+
+        /** Compile the products of an equation. */
+        template < typename RnDB >
+        static std::vector<Product>
+        compileProducts( const interaction::Equation<options> & eq,
+                         const RnDB & db ) {
+          using property::mass;
+
+          const Term * in[3] = { &eq.A, &eq.B, &eq.C };
+          const unsigned int n_in = eq.isTernary() ? 3u : 2u;
+          const std::vector<double> m_in = inputMasses( eq, db );
+
+          std::vector<Product> retval;
+          for ( unsigned int i = 0u; i < eq.products.size(); ++i ) {
+            const Term & t = eq.products[i];
+            const double m = db[t.species].mass::value;
+
+            /* the last input of the same species, or else the first input of
+             * the closest mass. */
+            unsigned int source = n_in;
+            for ( unsigned int k = n_in; k > 0u && source == n_in; --k )
+              if ( in[k-1u]->species == t.species )
+                source = k - 1u;
+
+            if ( source == n_in ) {
+              source = 0u;
+              for ( unsigned int k = 1u; k < n_in; ++k )
+                if ( std::abs( m - m_in[k] ) < std::abs( m - m_in[source] ) )
+                  source = k;
+            }
+
+            for ( int k = 0; k < t.n; ++k )
+              retval.push_back( Product( t.species, m, source ) );
+          }
+
+          return retval;
+        }
+
+        /** The masses of the inputs of an equation. */
+        template < typename RnDB >
+        static std::vector<double>
+        inputMasses( const interaction::Equation<options> & eq,
+                     const RnDB & db ) {
+          using property::mass;
+
+          std::vector<double> retval;
+          retval.push_back( db[eq.A.species].mass::value );
+          retval.push_back( db[eq.B.species].mass::value );
+          if ( eq.isTernary() )
+            retval.push_back( db[eq.C.species].mass::value );
+          return retval;
+        }
+
         /** load a new instance of the Interaction. */
         virtual InElastic * new_load( const xml::Context & x,
                                       const interaction::Equation<options> & eq,
                                       const RuntimeDB<options> & db ) const {
-          return new InElastic/*( eq.reducedMass )*/;
+          return new InElastic( inputMasses( eq, db ), eq.A.species,
+                                detail::loadThresholdEnergy( x ),
+                                compileProducts( eq, db ) );
+        }
+
+      private:
+        /** Cache the masses of the products and the total mass of the
+         * inputs. */
+        void init() {
+          m_in = 0.0;
+          for ( unsigned int k = 0u; k < input_mass.size(); ++k )
+            m_in += input_mass[k];
+
+          double m_out = 0.0;
+          for ( unsigned int i = 0u; i < outputs.size(); ++i )
+            m_out += outputs[i].mass;
+
+          if ( m_out > 0.0 )
+            mass_ratio = m_in / m_out;
+
+          if ( outputs.size() == 2u )
+            mu_out = ReducedMass( outputs[0].mass, outputs[1].mass );
         }
 
       };
@@ -35,6 +35,8 @@
 #include <chimp/interaction/model/Base.h>
 #include <chimp/interaction/ReducedMass.h>
 #include <chimp/interaction/model/detail/vss_helpers.h>
+#include <chimp/interaction/model/detail/weight_split.h>
+#include <chimp/interaction/model/detail/scatter.h>
 
 #include <xylose/power.h>
 #include <xylose/Vector.h>
@@ -43,6 +45,7 @@
 
 #include <string>
 #include <vector>
+#include <cstddef>
 
 namespace chimp {
   namespace interaction {
@@ -53,6 +56,7 @@ namespace chimp {
       struct VSSElastic : Base<options> {
         /* TYPEDEFS */
         typedef typename options::Particle Particle;
+        typedef typename options::ProductSink ProductSink;
         typedef property::mass mass;
 
 
@@ -66,19 +70,25 @@ namespace chimp {
 
         /** Inverse of VSS model parameter. */
         double vss_param_inv;
+
+        /** Tabulated deflection for vss_param_inv (used by scatter).  If
+         * vss_param_inv is changed after construction, scatter evaluates the
+         * deflection directly. */
+        detail::VSSDeflectionTable deflection;
         
 
 
         /* MEMBER FUNCTIONS */
         /** Default constructor sets mu to invalid values and vss_param_inv to
          * 1.0. */
-        VSSElastic() : mu(), vss_param_inv(1.0) { }
+        VSSElastic() : mu(), vss_param_inv(1.0), deflection(1.0) { }
 
         /** Construct from xml::Context and use the specified reduced mass. */
         VSSElastic( const xml::Context & x,
                     const ReducedMass & mu )
           : mu( mu ),
-            vss_param_inv( detail::loadVSSParamInv( x ) ) { }
+            vss_param_inv( detail::loadVSSParamInv( x ) ),
+            deflection( vss_param_inv ) { }
 
         /** Virtual NO-OP destructor. */
         virtual ~VSSElastic() { }
@@ -88,28 +98,144 @@ namespace chimp {
           return label;
         }
 
-        /** Two-body collision interface.  const particle version. */
+        /** Two-body collision interface.  const particle version.  If the
+         * weights of the particles differ, the heavier particle is split (see
+         * detail::splitWeights) and three products are created, unless
+         * options::split_weights is false (see detail::scatterUnsplit). */
         virtual void interact( const Particle & part1,
                                const Particle & part2,
-                               std::vector< Particle > & products,
+                               ProductSink & products,
                                typename options::RNG & rng ) {
-          products.reserve( products.size() + 2u );
+          const std::size_t i = products.size();
+          products.reserve( i + detail::splitSize( part1, part2,
+                                                   options::split_weights ) );
           products.push_back( part1 );
           products.push_back( part2 );
 
-          typename std::vector< Particle >::reverse_iterator rbeg
-            = products.rbegin();
-          interact( *(rbeg+1), *rbeg, rng );
+          if ( !options::split_weights ) {
+            detail::scatterUnsplit( *this, products[i], products[i+1u], rng );
+            return;
+          }
+
+          detail::splitWeights( products, i );
+          interact( products[i], products[i+1u], rng );
         }
 
-        /** Two-body collision interface.  in-place operation version */
+        /** Two-body collision interface.  in-place operation version.  If the
+         * weights of the particles differ, the interaction cannot be done in
+         * place and all of the products are created instead, unless
+         * options::split_weights is false (see detail::scatterUnsplit). */
         virtual void interact( Particle & part1,
                                Particle & part2,
-                               std::vector< Particle > & products,
+                               ProductSink & products,
                                typename options::RNG & rng ) {
+          using chimp::accessors::particle::weight;
+
+          if ( !options::split_weights ) {
+            detail::scatterUnsplit( *this, part1, part2, rng );
+            return;
+          }
+
+          if ( weight(part1) != weight(part2) ) {
+            const Particle & p1 = part1, & p2 = part2;
+            interact( p1, p2, products, rng );
+            return;
+          }
+
           interact( part1, part2, rng );
         }
 
+        /** Batched two-body collision interface.  const particle version.
+         * @see detail::scatterCopies. */
+        virtual void interact( const Particle * const * part1,
+                               const Particle * const * part2,
+                               const unsigned int & n,
+                               ProductSink & products,
+                               std::size_t * ends,
+                               typename options::RNG & rng ) {
+          detail::scatterCopies( *this, part1, part2, n, products, ends, rng,
+                                 options::split_weights );
+        }
+
+        /** Batched two-body collision interface.  in-place operation
+         * version.  @see detail::scatterInPlace. */
+        virtual void interact( Particle * const * part1,
+                               Particle * const * part2,
+                               const unsigned int & n,
+                               ProductSink & products,
+                               std::size_t * ends,
+                               typename options::RNG & rng ) {
+          detail::scatterInPlace( *this, part1, part2, n, products, ends, rng,
+                                  options::split_weights );
+        }
+
+        /** Binary elastic collision of the pairs (*part1[k], *part2[k]) for
+         * k < n <= detail::scatter_chunk.  This is equivalent to calling
+         * interact(*part1[k], *part2[k], rng) for each pair, but the random
+         * numbers are drawn for all pairs first, the deflection cosine is
+         * interpolated from the table, and the azimuth is sampled without
+         * trigonometric functions (detail::randomAzimuth). */
+        void scatter( Particle * const * part1,
+                      Particle * const * part2,
+                      const unsigned int & n,
+                      typename options::RNG & rng ) {
+          using xylose::SQR;
+          using xylose::fast_pow;
+          using xylose::Vector;
+          using chimp::accessors::particle::velocity;
+          using chimp::accessors::particle::setVelocity;
+
+          static const unsigned int X = 0u;
+          static const unsigned int Y = 1u;
+          static const unsigned int Z = 2u;
+
+          double B[detail::scatter_chunk],
+                 COSC[detail::scatter_chunk],
+                 SINC[detail::scatter_chunk];
+
+          /* B is the cosine of the deflection angle */
+          if ( deflection.vss_param_inv == vss_param_inv )
+            for ( unsigned int k = 0u; k < n; ++k )
+              B[k] = 2.0 * deflection( rng.rand() ) - 1.0;
+          else
+            for ( unsigned int k = 0u; k < n; ++k )
+              B[k] = 2.0 * fast_pow( rng.rand(), vss_param_inv ) - 1.0;
+
+          for ( unsigned int k = 0u; k < n; ++k )
+            detail::randomAzimuth( rng, COSC[k], SINC[k] );
+
+          for ( unsigned int k = 0u; k < n; ++k ) {
+            const Vector<double,3> v1 = velocity(*part1[k]);
+            const Vector<double,3> v2 = velocity(*part2[k]);
+
+            const Vector<double,3> VelCM = (mu.over_m2 * v1) +
+                                           (mu.over_m1 * v2);
+            const Vector<double,3> VelRelPre = v1 - v2;
+            const double SpeedRel = VelRelPre.abs();
+
+            const double A = std::sqrt( 1.0 - B[k]*B[k] );
+            const double D = std::sqrt( SQR(VelRelPre[Y]) + SQR(VelRelPre[Z]) );
+            Vector<double,3> VelRelPost;
+            if ( D > 1.0E-6 ) {
+              const double AD = A / D;
+              VelRelPost[X] = B[k] * VelRelPre[X] + A * SINC[k] * D;
+              VelRelPost[Y] = B[k] * VelRelPre[Y]
+                            + AD * ( SpeedRel * VelRelPre[Z] * COSC[k]
+                                   - VelRelPre[X] * VelRelPre[Y] * SINC[k] );
+              VelRelPost[Z] = B[k] * VelRelPre[Z]
+                            - AD * ( SpeedRel * VelRelPre[Y] * COSC[k]
+                                   + VelRelPre[X] * VelRelPre[Z] * SINC[k] );
+            } else {
+              VelRelPost[X] = B[k] * VelRelPre[X];
+              VelRelPost[Y] = A * COSC[k] * VelRelPre[X];
+              VelRelPost[Z] = A * SINC[k] * VelRelPre[X];
+            }
+
+            setVelocity(*part1[k], VelCM + ( mu.over_m1 * VelRelPost ) );
+            setVelocity(*part2[k], VelCM - ( mu.over_m2 * VelRelPost ) );
+          }
+        }
+
         /** Binary elastic collision of VHS and VSS models. */
         void interact( Particle & part1, Particle & part2,
                        typename options::RNG & rng ) {
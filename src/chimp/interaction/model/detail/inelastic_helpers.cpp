@@ -0,0 +1,56 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Implementation of InElastic helper functions.
+ */
+
+#include <chimp/interaction/model/detail/inelastic_helpers.h>
+
+#include <xylose/xml/physical_parse.h>
+
+#include <physical/runtime.h>
+#include <physical/physical.h>
+
+#include <string>
+
+namespace chimp {
+  namespace interaction {
+    namespace model {
+      namespace detail {
+
+        double loadThresholdEnergy( const xml::Context & x ) {
+          using runtime::physical::Quantity;
+          using runtime::physical::constant::si::eV;
+
+          if ( x.query<std::string>( "threshold_energy", "" ).empty() )
+            return 0.0;
+
+          return x.query<Quantity>("threshold_energy")
+                  .assertMatch(eV).getCoeff<double>();
+        }
+
+      } /* namespace chimp::interaction::model::detail */
+    } /* namespace chimp::interaction::model */
+  } /* namespace chimp::interaction */
+} /* namespace chimp */
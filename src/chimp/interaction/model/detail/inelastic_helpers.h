@@ -0,0 +1,49 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Helper functions for loading information useful for the InElastic model.
+ */
+
+#ifndef chimp_interaction_model_detail_inelastic_helpers_h
+#define chimp_interaction_model_detail_inelastic_helpers_h
+
+#include <xylose/xml/Doc.h>
+
+namespace chimp {
+  namespace xml = xylose::xml;
+
+  namespace interaction {
+    namespace model {
+      namespace detail {
+
+        /** Load the threshold energy (in Joules) of an inelastic
+         * interaction, or zero if the interaction does not specify one. */
+        double loadThresholdEnergy( const xml::Context & x );
+
+      } /* namespace chimp::interaction::model::detail */
+    } /* namespace chimp::interaction::model */
+  } /* namespace chimp::interaction */
+} /* namespace chimp */
+
+#endif // chimp_interaction_model_detail_inelastic_helpers_h
@@ -0,0 +1,244 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Helpers for the scattering kernels of the interaction models.
+ */
+
+#ifndef chimp_interaction_model_detail_scatter_h
+#define chimp_interaction_model_detail_scatter_h
+
+#include <chimp/accessors.h>
+#include <chimp/interaction/model/detail/weight_split.h>
+
+#include <xylose/Vector.h>
+
+#include <cmath>
+#include <cstddef>
+
+namespace chimp {
+  namespace interaction {
+    namespace model {
+      namespace detail {
+
+        /** Maximum number of pairs that the batched scattering kernels
+         * process at once (the size of their stack buffers). */
+        static const unsigned int scatter_chunk = 64u;
+
+        /** Draw the cosine and sine of a uniformly distributed azimuth angle
+         * without evaluating trigonometric functions.  A point (x,y) is drawn
+         * uniformly within the unit disk by rejection and the angle is taken
+         * as twice the polar angle of (x,y), i.e.
+         *    cos = (x^2 - y^2) / r^2,   sin = 2*x*y / r^2.
+         */
+        template < typename RNG >
+        inline void randomAzimuth( RNG & rng, double & cos_c, double & sin_c ) {
+          double x, y, r2;
+          do {
+            x = 2.0 * rng.rand() - 1.0;
+            y = 2.0 * rng.rand() - 1.0;
+            r2 = x*x + y*y;
+          } while ( r2 > 1.0 || r2 == 0.0 );
+
+          const double r2_inv = 1.0 / r2;
+          cos_c = ( x*x - y*y ) * r2_inv;
+          sin_c = 2.0 * x * y * r2_inv;
+        }
+
+        /** Draw a uniformly distributed unit vector. */
+        template < typename RNG >
+        inline xylose::Vector<double,3> randomDirection( RNG & rng ) {
+          const double cos_t = 2.0 * rng.rand() - 1.0;
+          const double sin_t = std::sqrt( 1.0 - cos_t * cos_t );
+          double cos_p, sin_p;
+          randomAzimuth( rng, cos_p, sin_p );
+          return xylose::V3( cos_t, sin_t * cos_p, sin_t * sin_p );
+        }
+
+        /** Draw a vector of three independent standard normal deviates
+         * (with the polar method of Marsaglia). */
+        template < typename RNG >
+        inline xylose::Vector<double,3> randomNormal( RNG & rng ) {
+          double g[4];
+          for ( unsigned int i = 0u; i < 4u; i += 2u ) {
+            double x, y, r2;
+            do {
+              x = 2.0 * rng.rand() - 1.0;
+              y = 2.0 * rng.rand() - 1.0;
+              r2 = x*x + y*y;
+            } while ( r2 >= 1.0 || r2 == 0.0 );
+
+            const double f = std::sqrt( -2.0 * std::log( r2 ) / r2 );
+            g[i]    = x * f;
+            g[i+1u] = y * f;
+          }
+
+          return xylose::V3( g[0], g[1], g[2] );
+        }
+
+        /** The heavier particles of a chunk of pairs that keep their
+         * pre-interaction velocities when the particles are not split (see
+         * unsplitHeavy). */
+        template < typename Particle >
+        struct UnsplitChunk {
+          /** The heavier particles that keep their velocities. */
+          Particle * heavy[scatter_chunk];
+
+          /** The pre-interaction velocities of heavy. */
+          xylose::Vector<double,3> v[scatter_chunk];
+
+          /** Number of entries in heavy and v. */
+          unsigned int n;
+
+          UnsplitChunk() : n(0u) { }
+
+          /** Record the heavier of p1 and p2 if it must keep its velocity. */
+          template < typename RNG >
+          void add( Particle & p1, Particle & p2, RNG & rng ) {
+            using chimp::accessors::particle::velocity;
+            Particle * const h = unsplitHeavy( p1, p2, rng );
+            if ( h ) {
+              heavy[n] = h;
+              v[n] = velocity(*h);
+              ++n;
+            }
+          }
+
+          /** Restore the recorded velocities after the chunk is scattered. */
+          void restore() {
+            using chimp::accessors::particle::setVelocity;
+            for ( unsigned int k = 0u; k < n; ++k )
+              setVelocity( *heavy[k], v[k] );
+            n = 0u;
+          }
+        };
+
+        /** Batched two-body interaction of the elastic models.  in-place
+         * operation version.  The pairs of equal weights are scattered in
+         * place by model.scatter, scatter_chunk pairs at a time.  If
+         * split_weights is true, the other pairs create all of their
+         * products with the const two-body interface of the model.
+         * Otherwise, they are also scattered in place without being split
+         * (see unsplitHeavy).  The pairs must not share particles.
+         */
+        template < typename Model, typename Particle, typename ProductSink,
+                   typename RNG >
+        inline void scatterInPlace( Model & model,
+                                    Particle * const * part1,
+                                    Particle * const * part2,
+                                    const unsigned int & n,
+                                    ProductSink & products,
+                                    std::size_t * ends,
+                                    RNG & rng,
+                                    const bool split_weights = true ) {
+          using chimp::accessors::particle::weight;
+
+          Particle * p1[scatter_chunk], * p2[scatter_chunk];
+          UnsplitChunk<Particle> unsplit;
+          unsigned int m = 0u;
+
+          for ( unsigned int k = 0u; k < n; ++k ) {
+            if ( split_weights && weight(*part1[k]) != weight(*part2[k]) ) {
+              const Particle & a = *part1[k], & b = *part2[k];
+              model.interact( a, b, products, rng );
+            } else {
+              if ( !split_weights )
+                unsplit.add( *part1[k], *part2[k], rng );
+
+              p1[m] = part1[k];
+              p2[m] = part2[k];
+              if ( ++m == scatter_chunk ) {
+                model.scatter( p1, p2, m, rng );
+                unsplit.restore();
+                m = 0u;
+              }
+            }
+
+            ends[k] = products.size();
+          }
+
+          if ( m > 0u ) {
+            model.scatter( p1, p2, m, rng );
+            unsplit.restore();
+          }
+        }
+
+        /** Batched two-body interaction of the elastic models.  const
+         * particle version.  The pairs are copied into products (splitting
+         * the heavier particle of each pair as detail::splitWeights if
+         * split_weights is true) and the copies are scattered by
+         * model.scatter, scatter_chunk pairs at a time.  If split_weights is
+         * false, the copies of pairs of unequal weights are scattered
+         * without being split (see unsplitHeavy).
+         */
+        template < typename Model, typename Particle, typename ProductSink,
+                   typename RNG >
+        inline void scatterCopies( Model & model,
+                                   const Particle * const * part1,
+                                   const Particle * const * part2,
+                                   const unsigned int & n,
+                                   ProductSink & products,
+                                   std::size_t * ends,
+                                   RNG & rng,
+                                   const bool split_weights = true ) {
+          /* pointers into products must remain valid until scattered. */
+          std::size_t n_products = products.size();
+          for ( unsigned int k = 0u; k < n; ++k )
+            n_products += splitSize( *part1[k], *part2[k], split_weights );
+          products.reserve( n_products );
+
+          Particle * p1[scatter_chunk], * p2[scatter_chunk];
+          UnsplitChunk<Particle> unsplit;
+          unsigned int m = 0u;
+
+          for ( unsigned int k = 0u; k < n; ++k ) {
+            const std::size_t i = products.size();
+            products.push_back( *part1[k] );
+            products.push_back( *part2[k] );
+            if ( split_weights )
+              splitWeights( products, i );
+            else
+              unsplit.add( products[i], products[i+1u], rng );
+            ends[k] = products.size();
+
+            p1[m] = &products[i];
+            p2[m] = &products[i+1u];
+            if ( ++m == scatter_chunk ) {
+              model.scatter( p1, p2, m, rng );
+              unsplit.restore();
+              m = 0u;
+            }
+          }
+
+          if ( m > 0u ) {
+            model.scatter( p1, p2, m, rng );
+            unsplit.restore();
+          }
+        }
+
+      } /* namespace chimp::interaction::model::detail */
+    } /* namespace chimp::interaction::model */
+  } /* namespace chimp::interaction */
+} /* namespace chimp */
+
+#endif // chimp_interaction_model_detail_scatter_h
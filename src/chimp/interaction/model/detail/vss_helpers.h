@@ -30,6 +30,9 @@
 
 #include <xylose/xml/Doc.h>
 
+#include <vector>
+#include <cmath>
+
 namespace chimp {
   namespace xml = xylose::xml;
 
@@ -40,6 +43,48 @@ namespace chimp {
         /** load a new instance of the Interaction. */
         double loadVSSParamInv( const xml::Context & x );
 
+        /** Tabulated inverse CDF of the VSS deflection:  u^vss_param_inv for
+         * u in [0,1].  The table is uniform in x = sqrt(u), where the
+         * tabulated function x^(2*vss_param_inv) is much smoother near 0 than
+         * u^vss_param_inv.  The first interval, where the interpolation is
+         * least accurate, is evaluated directly instead.  Linear interpolation
+         * is thus accurate to better than 6e-6 for
+         * 0.8 <= 1/vss_param_inv <= 2. */
+        struct VSSDeflectionTable {
+          /* STATIC STORAGE */
+          /** Number of intervals of the table. */
+          static const unsigned int size = 1024u;
+
+
+          /* MEMBER STORAGE */
+          /** The VSS parameter inverse for which the table was computed. */
+          double vss_param_inv;
+
+          /** Values of x^(2*vss_param_inv) for x = j/size, j <= size. */
+          std::vector<double> table;
+
+
+          /* MEMBER FUNCTIONS */
+          /** Constructor computes the table. */
+          explicit VSSDeflectionTable( const double & vss_param_inv = 1.0 )
+            : vss_param_inv( vss_param_inv ), table( size + 1u ) {
+            for ( unsigned int j = 0u; j <= size; ++j )
+              table[j] = std::pow( double(j) / size, 2.0 * vss_param_inv );
+          }
+
+          /** Interpolate u^vss_param_inv. */
+          double operator() ( const double & u ) const {
+            const double x = std::sqrt( u ) * size;
+            if ( x < 1.0 )
+              return std::pow( u, vss_param_inv );
+
+            unsigned int j = static_cast<unsigned int>( x );
+            if ( j >= size )
+              j = size - 1u;
+            return table[j] + ( x - j ) * ( table[j+1u] - table[j] );
+          }
+        };
+
       } /* namespace chimp::interaction::model::detail */
     } /* namespace chimp::interaction::model */
   } /* namespace chimp::interaction */
@@ -0,0 +1,163 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Helper for the interaction models to handle particles of unequal weights.
+ *
+ * By default (options::split_weights), the heavier particle of a pair of
+ * unequal weights is split (see splitWeights), such that every such
+ * collision adds a particle to the simulation.  A trace species of small
+ * weight that collides with a species of large weight therefore makes the
+ * number of particles of the latter grow without bound unless the particles
+ * are merged elsewhere.  With options::split_weights == false, the pair is
+ * instead scattered without splitting (see unsplitHeavy, scatterUnsplit),
+ * which keeps the number of particles constant at the cost of conserving
+ * momentum and energy only on average.
+ */
+
+#ifndef chimp_interaction_model_detail_weight_split_h
+#define chimp_interaction_model_detail_weight_split_h
+
+#include <chimp/accessors.h>
+
+#include <xylose/Vector.h>
+
+#include <cstddef>
+
+namespace chimp {
+  namespace interaction {
+    namespace model {
+      namespace detail {
+
+        /** Number of particles after splitWeights is applied to copies of
+         * p1 and p2:  two if their weights are equal or if split is false,
+         * three otherwise. */
+        template < typename Particle >
+        inline std::size_t splitSize( const Particle & p1,
+                                      const Particle & p2,
+                                      const bool split = true ) {
+          using chimp::accessors::particle::weight;
+          return ( !split || weight(p1) == weight(p2) ) ? 2u : 3u;
+        }
+
+        /** Split the heavier of the two particles products[i] and
+         * products[i+1] if their weights are not equal.  The part of the
+         * heavier particle that does not take part in the interaction (of
+         * weight w_heavy - w_light) is appended to products with its
+         * pre-interaction state, and the weight of products[i] or
+         * products[i+1] is reduced to w_light.  The two particles may then
+         * interact as particles of equal weights, which conserves momentum
+         * and energy exactly.
+         *
+         * The capacity of products must allow one more element such that
+         * references to products[i] and products[i+1] remain valid.
+         *
+         * @tparam ProductSink
+         *    The product sink type (see interaction::VectorSink).
+         *
+         * @return Whether a particle was split.
+         */
+        template < typename ProductSink >
+        inline bool splitWeights( ProductSink & products,
+                                  const std::size_t & i ) {
+          typedef typename ProductSink::value_type Particle;
+          using chimp::accessors::particle::weight;
+          using chimp::accessors::particle::setWeight;
+
+          Particle & p1 = products[i];
+          Particle & p2 = products[i+1u];
+          const float w1 = weight(p1);
+          const float w2 = weight(p2);
+
+          if ( w1 == w2 )
+            return false;
+
+          Particle & heavy = ( w1 > w2 ) ? p1 : p2;
+          const float w_light = ( w1 > w2 ) ? w2 : w1;
+
+          products.push_back( heavy );
+          setWeight( products.back(), weight(heavy) - w_light );
+          setWeight( heavy, w_light );
+          return true;
+        }
+
+        /** Decide whether the heavier of p1 and p2 takes part in their
+         * interaction when the particles are not split.  The lighter
+         * particle always takes its post-interaction state, while the
+         * heavier one only does so with probability w_light/w_heavy, such
+         * that momentum and energy are conserved on average (but not for
+         * each collision) and no particle is created.  A random number is
+         * drawn only if the weights differ.
+         *
+         * @return The heavier particle if it must keep its pre-interaction
+         *    velocity, or 0 otherwise.
+         */
+        template < typename Particle, typename RNG >
+        inline Particle * unsplitHeavy( Particle & p1,
+                                        Particle & p2,
+                                        RNG & rng ) {
+          using chimp::accessors::particle::weight;
+
+          const float w1 = weight(p1);
+          const float w2 = weight(p2);
+
+          if ( w1 == w2 )
+            return 0;
+
+          const double w_light = ( w1 > w2 ) ? w2 : w1;
+          const double w_heavy = ( w1 > w2 ) ? w1 : w2;
+
+          if ( rng.rand() * w_heavy < w_light )
+            return 0;
+
+          return ( w1 > w2 ) ? &p1 : &p2;
+        }
+
+        /** Binary interaction of p1 and p2 with model.interact(p1,p2,rng)
+         * without splitting particles of unequal weights (see
+         * unsplitHeavy). */
+        template < typename Model, typename Particle, typename RNG >
+        inline void scatterUnsplit( Model & model,
+                                    Particle & p1,
+                                    Particle & p2,
+                                    RNG & rng ) {
+          using chimp::accessors::particle::velocity;
+          using chimp::accessors::particle::setVelocity;
+
+          Particle * const heavy = unsplitHeavy( p1, p2, rng );
+          if ( !heavy ) {
+            model.interact( p1, p2, rng );
+            return;
+          }
+
+          const xylose::Vector<double,3> v = velocity(*heavy);
+          model.interact( p1, p2, rng );
+          setVelocity( *heavy, v );
+        }
+
+      } /* namespace chimp::interaction::model::detail */
+    } /* namespace chimp::interaction::model */
+  } /* namespace chimp::interaction */
+} /* namespace chimp */
+
+#endif // chimp_interaction_model_detail_weight_split_h
@@ -28,6 +28,7 @@
 
 
 #include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
 #include <chimp/interaction/Term.h>
 #include <chimp/interaction/Input.h>
 #include <chimp/interaction/Particle.h>
@@ -184,4 +185,194 @@ BOOST_AUTO_TEST_SUITE( Elastic_tests ); // {
     }
   }
 
+  BOOST_AUTO_TEST_CASE( weight_splitting ) {
+    typedef chimp::RuntimeDB<> DB;
+    DB db;
+    db.addParticleType("87Rb");
+    int part_i = db.findParticleIndx("87Rb");
+
+    typedef chimp::interaction::model::Elastic<DB::options> Elastic;
+    Term t0(part_i);
+    chimp::interaction::Equation<DB::options> eq;
+    eq.A = eq.B = t0;
+    eq.reducedMass = chimp::interaction::ReducedMass( eq, db );
+    shared_ptr<Elastic> el( Elastic().new_load(xml::Context(), eq, db) );
+
+    const Particle p0( V3(0,0,0), V3( 10,-3, 2), part_i, 1.0f ),
+                   p1( V3(1,1,1), V3(-20, 4, 7), part_i, 3.0f );
+
+    std::vector<Particle> products;
+    el->interact( p0, p1, products, global_rng );
+
+    BOOST_REQUIRE_EQUAL( products.size(), 3u );
+    BOOST_CHECK_EQUAL( products[0].weight, 1.0f );
+    BOOST_CHECK_EQUAL( products[1].weight, 1.0f );
+    /* the remainder of the heavier particle is left untouched. */
+    BOOST_CHECK_EQUAL( products[2].weight, 2.0f );
+    BOOST_CHECK_EQUAL( products[2].v, p1.v );
+    BOOST_CHECK_EQUAL( products[2].x, p1.x );
+
+    /* weighted momentum and energy are conserved. */
+    Vector<double,3> Pi = test::momentum(p0, part_i, db) +
+                          test::momentum(p1, part_i, db);
+    double Ei = test::energy(p0, part_i, db) + test::energy(p1, part_i, db);
+    Vector<double,3> Pf(0.0);
+    double Ef = 0.0;
+    for ( unsigned int i = 0u; i < products.size(); ++i ) {
+      Pf += test::momentum(products[i], part_i, db);
+      Ef += test::energy(products[i], part_i, db);
+    }
+
+    BOOST_CHECK_LE( (Pf - Pi).abs() / Pi.abs(), 1e-14 );
+    BOOST_CHECK_CLOSE( Ef, Ei, 1e-12 );
+
+    {
+      /* the in-place version must also create all products. */
+      Particle q0 = p0, q1 = p1;
+      products.clear();
+      el->interact( q0, q1, products, global_rng );
+      BOOST_CHECK_EQUAL( products.size(), 3u );
+
+      /* equal weights are still handled in place. */
+      q1.weight = 1.0f;
+      products.clear();
+      el->interact( q0, q1, products, global_rng );
+      BOOST_CHECK_EQUAL( products.size(), 0u );
+      BOOST_CHECK_CLOSE( (q0.v + q1.v)[0], (p0.v + p1.v)[0], 1e-12 );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( weights_without_splitting ) {
+    typedef chimp::make_options<>::type::setSplitWeights<false>::type options;
+    typedef chimp::interaction::model::Elastic<options> Elastic;
+    Elastic el( chimp::interaction::ReducedMass( 1.0, 1.0 ) );
+
+    const Particle p0( V3(0,0,0), V3( 10,-3, 2), 0, 1.0f ),
+                   p1( V3(1,1,1), V3(-20, 4, 7), 0, 4.0f );
+
+    /* no particle is split. */
+    std::vector<Particle> products;
+    el.interact( p0, p1, products, global_rng );
+    BOOST_REQUIRE_EQUAL( products.size(), 2u );
+    BOOST_CHECK_EQUAL( products[0].weight, 1.0f );
+    BOOST_CHECK_EQUAL( products[1].weight, 4.0f );
+
+    /* the heavier particle keeps its velocity with probability
+     * 1 - w_light/w_heavy; otherwise the pair scatters normally. */
+    const unsigned int N = 4000u;
+    std::vector<Particle> q0(N, p0), q1(N, p1);
+    unsigned int n_kept = 0u;
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      el.interact( q0[k], q1[k], products, global_rng );
+      if ( q1[k].v == p1.v )
+        ++n_kept;
+      else
+        BOOST_CHECK_SMALL( (q0[k].v + q1[k].v - p0.v - p1.v).abs(), 1e-12 );
+    }
+
+    BOOST_CHECK_EQUAL( products.size(), 2u );
+    BOOST_CHECK_CLOSE( double(n_kept) / N, 0.75, 4.0 );
+
+    /* likewise for the batched kernels. */
+    std::vector<Particle *> pp0(N), pp1(N);
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      q0[k] = p0;
+      q1[k] = p1;
+      pp0[k] = &q0[k];
+      pp1[k] = &q1[k];
+    }
+
+    std::vector<std::size_t> ends(N);
+    products.clear();
+    el.interact( &pp0[0], &pp1[0], N, products, &ends[0], global_rng );
+    BOOST_CHECK_EQUAL( products.size(), 0u );
+    BOOST_CHECK_EQUAL( ends[N-1u], 0u );
+
+    n_kept = 0u;
+    for ( unsigned int k = 0u; k < N; ++k )
+      if ( q1[k].v == p1.v )
+        ++n_kept;
+    BOOST_CHECK_CLOSE( double(n_kept) / N, 0.75, 4.0 );
+
+    const std::vector<const Particle *> cp0(pp0.begin(), pp0.end()),
+                                        cp1(pp1.begin(), pp1.end());
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      q0[k] = p0;
+      q1[k] = p1;
+    }
+
+    el.interact( &cp0[0], &cp1[0], N, products, &ends[0], global_rng );
+    BOOST_REQUIRE_EQUAL( products.size(), 2u * N );
+    BOOST_CHECK_EQUAL( ends[N-1u], 2u * N );
+
+    n_kept = 0u;
+    for ( unsigned int k = 0u; k < N; ++k )
+      if ( products[2u*k+1u].v == p1.v )
+        ++n_kept;
+    BOOST_CHECK_CLOSE( double(n_kept) / N, 0.75, 4.0 );
+  }
+
+  BOOST_AUTO_TEST_CASE( batch ) {
+    typedef chimp::RuntimeDB<> DB;
+    DB db;
+    db.addParticleType("87Rb");
+    int part_i = db.findParticleIndx("87Rb");
+
+    typedef chimp::interaction::model::Elastic<DB::options> Elastic;
+    Term t0(part_i);
+    chimp::interaction::Equation<DB::options> eq;
+    eq.A = eq.B = t0;
+    eq.reducedMass = chimp::interaction::ReducedMass( eq, db );
+    shared_ptr<Elastic> el( Elastic().new_load(xml::Context(), eq, db) );
+
+    /* more pairs than one chunk of the kernel; every third pair has unequal
+     * weights. */
+    const unsigned int N = 150u;
+    std::vector<Particle> p0(N), p1(N);
+    std::vector<Particle *> pp0(N), pp1(N);
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      randomize(p0[k]).weight = 1.0f;
+      randomize(p1[k]).weight = ( k % 3u == 0u ) ? 2.0f : 1.0f;
+      pp0[k] = &p0[k];
+      pp1[k] = &p1[k];
+    }
+    const std::vector<Particle> p0i = p0, p1i = p1;
+
+    std::vector<Particle> products;
+    std::vector<std::size_t> ends(N);
+    el->interact( &pp0[0], &pp1[0], N, products, &ends[0], global_rng );
+
+    BOOST_CHECK_EQUAL( products.size(), 3u * ((N + 2u) / 3u) );
+
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      const std::size_t begin = ( k > 0u ) ? ends[k-1u] : 0u;
+
+      Vector<double,3> Pi = test::momentum(p0i[k], part_i, db) +
+                            test::momentum(p1i[k], part_i, db);
+      double Ei = test::energy(p0i[k], part_i, db) +
+                  test::energy(p1i[k], part_i, db);
+      Vector<double,3> Pf(0.0);
+      double Ef = 0.0;
+
+      if ( k % 3u == 0u ) {
+        /* unequal weights:  all products created, inputs unchanged. */
+        BOOST_REQUIRE_EQUAL( ends[k] - begin, 3u );
+        BOOST_CHECK_EQUAL( p0[k].v, p0i[k].v );
+        for ( std::size_t i = begin; i < ends[k]; ++i ) {
+          Pf += test::momentum(products[i], part_i, db);
+          Ef += test::energy(products[i], part_i, db);
+        }
+      } else {
+        /* equal weights:  in place. */
+        BOOST_REQUIRE_EQUAL( ends[k], begin );
+        Pf = test::momentum(p0[k], part_i, db) +
+             test::momentum(p1[k], part_i, db);
+        Ef = test::energy(p0[k], part_i, db) + test::energy(p1[k], part_i, db);
+      }
+
+      BOOST_CHECK_LE( (Pf - Pi).abs() / Pi.abs(), 1e-13 );
+      BOOST_CHECK_CLOSE( Ef, Ei, 1e-12 );
+    }
+  }
+
 BOOST_AUTO_TEST_SUITE_END(); // }
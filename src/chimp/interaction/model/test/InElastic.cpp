@@ -0,0 +1,228 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the InElastic class.
+ * */
+#define BOOST_TEST_MODULE  InElastic
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/interaction/Particle.h>
+#include <chimp/interaction/ReducedMass.h>
+#include <chimp/interaction/model/InElastic.h>
+
+#include <xylose/random/Kiss.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  using chimp::interaction::Particle;
+  using chimp::interaction::ReducedMass;
+  using xylose::V3;
+  using xylose::Vector;
+
+  typedef chimp::make_options<>::type
+    ::setInplaceInteractions<false>::type options;
+  typedef chimp::interaction::model::InElastic<options> InElastic;
+  typedef InElastic::Product Product;
+
+  /* species:  0 = electron, 1 = atom, 2 = ion, 3 = excited atom. */
+  const double mass[] = { 1.0, 100.0, 99.0, 100.0 };
+
+  /** Weighted kinetic energy of a set of particles. */
+  double energy( const std::vector<Particle> & p ) {
+    double E = 0.0;
+    for ( unsigned int i = 0u; i < p.size(); ++i )
+      E += 0.5 * mass[p[i].species] * p[i].weight * (p[i].v * p[i].v);
+    return E;
+  }
+
+  /** Weighted momentum of a set of particles. */
+  Vector<double,3> momentum( const std::vector<Particle> & p ) {
+    Vector<double,3> P = 0.0;
+    for ( unsigned int i = 0u; i < p.size(); ++i )
+      P += ( mass[p[i].species] * p[i].weight ) * p[i].v;
+    return P;
+  }
+
+  /** Check that the products conserve momentum and lose the threshold
+   * energy (times the interacting weight). */
+  void checkConservation( InElastic & model, xylose::random::Kiss & rng,
+                          const float & w_atom ) {
+    const Particle e( 0.0, V3( 8,-5, 3), 0, 1.0f ),
+                   a( 1.0, V3(.2,.1,-.3), 1, w_atom );
+
+    std::vector<Particle> in;
+    in.push_back(e);
+    in.push_back(a);
+
+    std::vector<Particle> out;
+    /* the order of the inputs does not matter. */
+    model.interact( a, e, out, rng );
+
+    BOOST_REQUIRE_EQUAL( out.size(),
+                         model.outputs.size() + (w_atom != 1.0f ? 1u : 0u) );
+    for ( unsigned int i = 0u; i < model.outputs.size(); ++i ) {
+      BOOST_CHECK_EQUAL( out[i].species, model.outputs[i].species );
+      BOOST_CHECK_EQUAL( out[i].weight, 1.0f );
+    }
+
+    BOOST_CHECK_LE( (momentum(out) - momentum(in)).abs()
+                    / momentum(in).abs(), 1e-13 );
+    BOOST_CHECK_CLOSE( energy(out), energy(in) - model.threshold_energy,
+                       1e-10 );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( InElastic_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( excitation ) {
+    xylose::random::Kiss rng(1u);
+    std::vector<Product> outputs;
+    outputs.push_back( Product( 0, mass[0], 0u ) );
+    outputs.push_back( Product( 3, mass[3], 1u ) );
+    InElastic model( ReducedMass( mass[0], mass[1] ), 0, 5.0, outputs );
+
+    BOOST_CHECK_EQUAL( model.getLabel(), "inelastic" );
+    checkConservation( model, rng, 1.0f );
+    checkConservation( model, rng, 3.0f );
+  }
+
+  BOOST_AUTO_TEST_CASE( ionization ) {
+    xylose::random::Kiss rng(1u);
+    std::vector<Product> outputs;
+    outputs.push_back( Product( 0, mass[0], 0u ) );
+    outputs.push_back( Product( 0, mass[0], 0u ) );
+    outputs.push_back( Product( 2, mass[2], 1u ) );
+    InElastic model( ReducedMass( mass[0], mass[1] ), 0, 10.0, outputs );
+
+    for ( int i = 0; i < 100; ++i )
+      checkConservation( model, rng, 1.0f );
+    checkConservation( model, rng, 2.0f );
+  }
+
+  BOOST_AUTO_TEST_CASE( below_threshold ) {
+    /* the interaction is rejected without any products. */
+    xylose::random::Kiss rng(1u);
+    std::vector<Product> outputs;
+    outputs.push_back( Product( 0, mass[0], 0u ) );
+    outputs.push_back( Product( 3, mass[3], 1u ) );
+    InElastic model( ReducedMass( mass[0], mass[1] ), 0, 1e10, outputs );
+
+    const Particle e( 0.0, V3(1,0,0), 0, 1.0f ),
+                   a( 0.0, V3(0,0,0), 1, 2.0f );
+    std::vector<Particle> out;
+    model.interact( e, a, out, rng );
+    model.interact( a, e, out, rng );
+
+    BOOST_CHECK_EQUAL( out.size(), 0u );
+    BOOST_CHECK_EQUAL( model.getNumberRejects(), 2u );
+  }
+
+  BOOST_AUTO_TEST_CASE( phase_space ) {
+    /* For three products, the fraction f of the energy of product j is
+     * distributed as (1 - m_j/M) * Beta(3/2,3/2) over the phase space. */
+    xylose::random::Kiss rng(1u);
+    std::vector<Product> outputs;
+    outputs.push_back( Product( 0, mass[0], 0u ) );
+    outputs.push_back( Product( 0, mass[0], 0u ) );
+    outputs.push_back( Product( 2, mass[2], 1u ) );
+    InElastic model( ReducedMass( mass[0], mass[1] ), 0, 10.0, outputs );
+
+    const double M = 2.0 * mass[0] + mass[2];
+    const Particle e( 0.0, V3( 8,-5, 3), 0, 1.0f ),
+                   a( 1.0, V3(.2,.1,-.3), 1, 1.0f );
+    const Vector<double,3> VelCM = ( mass[0] * e.v + mass[1] * a.v ) / M;
+
+    const unsigned int N = 20000u;
+    double sum[3] = { 0.0, 0.0, 0.0 }, sum2[3] = { 0.0, 0.0, 0.0 };
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      std::vector<Particle> out;
+      model.interact( e, a, out, rng );
+      BOOST_REQUIRE_EQUAL( out.size(), 3u );
+
+      double E[3], E_tot = 0.0;
+      for ( unsigned int j = 0u; j < 3u; ++j ) {
+        const Vector<double,3> u = out[j].v - VelCM;
+        E_tot += E[j] = 0.5 * mass[out[j].species] * ( u * u );
+      }
+
+      for ( unsigned int j = 0u; j < 3u; ++j ) {
+        const double x = E[j] / E_tot / ( 1.0 - mass[out[j].species] / M );
+        sum[j] += x;
+        sum2[j] += x * x;
+      }
+    }
+
+    /* mean 1/2 and variance 1/16 of Beta(3/2,3/2) (5 standard deviations) */
+    for ( unsigned int j = 0u; j < 3u; ++j ) {
+      const double mean = sum[j] / N;
+      const double var = sum2[j] / N - mean * mean;
+      BOOST_CHECK_SMALL( mean - 0.5, 5.0 * 0.25 / std::sqrt( double(N) ) );
+      BOOST_CHECK_SMALL( var - 0.0625, 0.0025 );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( three_body_recombination ) {
+    /* e + e + ion --> e + atom, releasing 5 units of energy. */
+    xylose::random::Kiss rng(1u);
+    std::vector<double> input_mass;
+    input_mass.push_back( mass[0] );
+    input_mass.push_back( mass[0] );
+    input_mass.push_back( mass[2] );
+    std::vector<Product> outputs;
+    outputs.push_back( Product( 0, mass[0], 1u ) );
+    outputs.push_back( Product( 1, mass[1], 2u ) );
+    InElastic model( input_mass, 0, -5.0, outputs );
+
+    const float w_ion[] = { 1.0f, 4.0f };
+    for ( int k = 0; k < 2; ++k ) {
+      const Particle e1( 0.0, V3( 3, 1,-2), 0, 1.0f ),
+                     e2( 1.0, V3(-1, 4, 2), 0, 1.0f ),
+                     ion( 2.0, V3(.1,.2,.1), 2, w_ion[k] );
+
+      std::vector<Particle> in;
+      in.push_back(e1);
+      in.push_back(e2);
+      in.push_back(ion);
+
+      std::vector<Particle> out;
+      /* the order of the inputs does not matter. */
+      model.interact( ion, e1, e2, out, rng );
+
+      BOOST_REQUIRE_EQUAL( out.size(), 2u + (w_ion[k] != 1.0f ? 1u : 0u) );
+      BOOST_CHECK_EQUAL( out[0].species, 0 );
+      BOOST_CHECK_EQUAL( out[1].species, 1 );
+      BOOST_CHECK_EQUAL( out[1].x[0], 2.0 );
+
+      BOOST_CHECK_LE( (momentum(out) - momentum(in)).abs()
+                      / momentum(in).abs(), 1e-13 );
+      BOOST_CHECK_CLOSE( energy(out), energy(in) + 5.0, 1e-10 );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,210 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+/** \file
+ * Test file for the VSSElastic class.
+ * */
+#define BOOST_TEST_MODULE  VSSElastic
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/interaction/Particle.h>
+#include <chimp/interaction/ReducedMass.h>
+#include <chimp/interaction/model/VSSElastic.h>
+
+#include <xylose/random/Kiss.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  using chimp::interaction::Particle;
+  using chimp::interaction::ReducedMass;
+  using chimp::interaction::model::detail::VSSDeflectionTable;
+  using chimp::interaction::model::detail::scatter_chunk;
+  using xylose::V3;
+  using xylose::Vector;
+
+  typedef chimp::make_options<>::type options;
+  typedef chimp::interaction::model::VSSElastic<options> VSSElastic;
+
+  const double mass[] = { 1.0, 3.0 };
+
+  /** VSS model of species 0 and 1 with the given parameter inverse. */
+  VSSElastic makeModel( const double & vss_param_inv ) {
+    VSSElastic model;
+    model.mu = ReducedMass( mass[0], mass[1] );
+    model.vss_param_inv = vss_param_inv;
+    model.deflection = VSSDeflectionTable( vss_param_inv );
+    return model;
+  }
+
+  /** Random velocity with components in [-50,50). */
+  Vector<double,3> randomVelocity( xylose::random::Kiss & rng ) {
+    return V3( 100.0 * ( rng.rand() - .5 ),
+               100.0 * ( rng.rand() - .5 ),
+               100.0 * ( rng.rand() - .5 ) );
+  }
+
+  /** Weighted kinetic energy of a particle. */
+  double energy( const Particle & p ) {
+    return 0.5 * mass[p.species] * p.weight * (p.v * p.v);
+  }
+
+  /** Weighted momentum of a particle. */
+  Vector<double,3> momentum( const Particle & p ) {
+    return ( mass[p.species] * p.weight ) * p.v;
+  }
+
+  /** Check the mean and the mean square of the cosine of the deflection
+   * angle of the batch scatter against those of 2*u^vss_param_inv - 1. */
+  void checkDeflection( VSSElastic & model, xylose::random::Kiss & rng ) {
+    const double p = model.vss_param_inv;
+    const unsigned int n = 1000u * scatter_chunk;
+    double sum = 0.0, sum2 = 0.0;
+
+    Particle a[scatter_chunk], b[scatter_chunk];
+    Particle * pa[scatter_chunk], * pb[scatter_chunk];
+    Vector<double,3> v_rel[scatter_chunk];
+    for ( unsigned int done = 0u; done < n; done += scatter_chunk ) {
+      for ( unsigned int k = 0u; k < scatter_chunk; ++k ) {
+        a[k] = Particle( 0.0, randomVelocity(rng), 0, 1.0f );
+        b[k] = Particle( 0.0, randomVelocity(rng), 1, 1.0f );
+        pa[k] = &a[k];
+        pb[k] = &b[k];
+        v_rel[k] = a[k].v - b[k].v;
+      }
+
+      model.scatter( pa, pb, scatter_chunk, rng );
+
+      for ( unsigned int k = 0u; k < scatter_chunk; ++k ) {
+        const Vector<double,3> v_post = a[k].v - b[k].v;
+        const double B = ( v_post * v_rel[k] ) / ( v_rel[k] * v_rel[k] );
+        sum += B;
+        sum2 += B * B;
+      }
+    }
+
+    const double mean = 2.0 / ( p + 1.0 ) - 1.0;
+    const double mean2 = 4.0 / ( 2.0 * p + 1.0 ) - 4.0 / ( p + 1.0 ) + 1.0;
+    /* 5 standard deviations (|B| <= 1) */
+    BOOST_CHECK_SMALL( sum / n - mean, 5.0 / std::sqrt( double(n) ) );
+    BOOST_CHECK_SMALL( sum2 / n - mean2, 5.0 / std::sqrt( double(n) ) );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( VSSElastic_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( deflection_table ) {
+    const double p[] = { 0.5, 0.52, 0.55, 0.57, 0.6, 0.7, 0.8, 1.0, 1.25 };
+    for ( unsigned int i = 0u; i < sizeof(p) / sizeof(p[0]); ++i ) {
+      const VSSDeflectionTable table( p[i] );
+      double max_err = 0.0;
+      for ( unsigned int k = 0u; k <= 1000000u; ++k ) {
+        /* (dense near zero, where the interpolation is least accurate) */
+        const double x = k * 1e-6;
+        const double u = x * x;
+        max_err = std::max( max_err,
+                            std::abs( table(u) - std::pow( u, p[i] ) ) );
+      }
+      BOOST_CHECK_LT( max_err, 6e-6 );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( batch ) {
+    xylose::random::Kiss rng(1u);
+
+    for ( int tabulated = 0; tabulated < 2; ++tabulated ) {
+      VSSElastic model = makeModel( 0.6 );
+      if ( !tabulated )
+        /* the deflection is then evaluated directly. */
+        model.vss_param_inv = 0.7;
+
+      /* more pairs than one chunk of the kernel; every third pair has
+       * unequal weights. */
+      const unsigned int N = 150u;
+      std::vector<Particle> p0(N), p1(N);
+      std::vector<Particle *> pp0(N), pp1(N);
+      for ( unsigned int k = 0u; k < N; ++k ) {
+        p0[k] = Particle( 0.0, randomVelocity(rng), 0, 1.0f );
+        p1[k] = Particle( 1.0, randomVelocity(rng), 1,
+                          ( k % 3u == 0u ) ? 2.0f : 1.0f );
+        pp0[k] = &p0[k];
+        pp1[k] = &p1[k];
+      }
+      const std::vector<Particle> p0i = p0, p1i = p1;
+
+      std::vector<Particle> products;
+      std::vector<std::size_t> ends(N);
+      model.interact( &pp0[0], &pp1[0], N, products, &ends[0], rng );
+
+      BOOST_CHECK_EQUAL( products.size(), 3u * ((N + 2u) / 3u) );
+
+      for ( unsigned int k = 0u; k < N; ++k ) {
+        const std::size_t begin = ( k > 0u ) ? ends[k-1u] : 0u;
+
+        const Vector<double,3> Pi = momentum(p0i[k]) + momentum(p1i[k]);
+        const double Ei = energy(p0i[k]) + energy(p1i[k]);
+        Vector<double,3> Pf = 0.0;
+        double Ef = 0.0;
+
+        if ( k % 3u == 0u ) {
+          /* unequal weights:  all products created, inputs unchanged. */
+          BOOST_REQUIRE_EQUAL( ends[k] - begin, 3u );
+          BOOST_CHECK_EQUAL( p0[k].v[0], p0i[k].v[0] );
+          for ( std::size_t i = begin; i < ends[k]; ++i ) {
+            Pf += momentum(products[i]);
+            Ef += energy(products[i]);
+          }
+        } else {
+          /* equal weights:  in place. */
+          BOOST_REQUIRE_EQUAL( ends[k], begin );
+          BOOST_CHECK( p0[k].v[0] != p0i[k].v[0] );
+          Pf = momentum(p0[k]) + momentum(p1[k]);
+          Ef = energy(p0[k]) + energy(p1[k]);
+        }
+
+        BOOST_CHECK_LE( (Pf - Pi).abs() / Pi.abs(), 1e-13 );
+        BOOST_CHECK_CLOSE( Ef, Ei, 1e-12 );
+      }
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( batch_deflection ) {
+    xylose::random::Kiss rng(1u);
+
+    const double p[] = { 0.55, 1.0, 1.25 };
+    for ( unsigned int i = 0u; i < 3u; ++i ) {
+      VSSElastic model = makeModel( p[i] );
+      checkDeflection( model, rng );
+
+      /* directly evaluated deflection */
+      model.deflection = VSSDeflectionTable( 1.0 / p[i] );
+      checkDeflection( model, rng );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,315 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Batched version of the No Time Counter scheme.
+ * */
+
+#ifndef chimp_interaction_scheme_BatchedNTC_h
+#define chimp_interaction_scheme_BatchedNTC_h
+
+#include <chimp/interaction/scheme/NTC.h>
+#include <chimp/accessors.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <cmath>
+
+namespace chimp {
+  namespace interaction {
+    namespace scheme {
+
+      /** The No Time Counter scheme, with the pairs of a pair of species
+       * selected and tested in batches.  For each batch, the pairs are
+       * drawn first, the relative speeds of all pairs are computed in one
+       * pass, and the pairs are tested with a single call to
+       * Set::testPairs which evaluates each cross section once for the whole
+       * batch.  The accepted pairs are then collided in the order in which
+       * they were drawn.
+       *
+       * Since all pairs of a batch are tested before any of them collide, a
+       * pair that shares a particle with a pair already collided in the same
+       * batch is tested again (with the post-collision velocity) by
+       * Set::interact instead of using the result of the batch test.  A
+       * pair with a particle that was removed earlier in the batch (by an
+       * in-place interaction) is replaced by a new pair, tested the same way.
+       * The statistics are thus the same as those of NTC.
+       *
+       * The accepted pairs that do not share a particle with an earlier pair
+       * of the batch are collided together by Set::performInteractions,
+       * which passes them to the batched interface of the interaction
+       * models (see model::Base).  The products are then grouped by
+       * equation rather than following the order of the pairs.
+       *
+       * Cells with fewer than threshold tests are handled by NTC.
+       */
+      struct BatchedNTC : NTC {
+        /* TYPEDEFS */
+        /** The pairs deferred in the workspace, given as pairs of iterators
+         * for Set::performInteractions. */
+        template < typename PIter >
+        struct PendingPairs {
+          PIter a, b;
+          const unsigned int * ia, * ib;
+
+          PendingPairs( const PIter & a, const PIter & b,
+                        const unsigned int * ia, const unsigned int * ib )
+            : a(a), b(b), ia(ia), ib(ib) { }
+
+          std::pair<PIter,PIter> operator[] ( const unsigned int & k ) const {
+            return std::make_pair( a + ia[k], b + ib[k] );
+          }
+        };
+
+
+        /* MEMBER STORAGE */
+        /** Maximum number of pairs tested at once. */
+        unsigned int batch_size;
+
+        /** Minimum number of tests for a pair of species to be batched. */
+        double threshold;
+
+
+        /* MEMBER FUNCTIONS */
+        /** Constructor. */
+        BatchedNTC( const unsigned int & batch_size = 256u,
+                    const double & threshold = 256.0 )
+          : batch_size( std::max(batch_size, 1u) ), threshold( threshold ) { }
+
+        /** Select, test, and collide the pairs of species A and B. */
+        template < typename Driver,
+                   typename CellInfo,
+                   typename ChimpDB,
+                   typename BackInsertionSequence,
+                   typename ErasureQueue,
+                   typename RNG >
+        void operator() ( Driver & driver,
+                          const unsigned int & A,
+                          const unsigned int & B,
+                          CellInfo & cell,
+                          const ChimpDB & db,
+                          BackInsertionSequence & result_list,
+                          ErasureQueue & eq,
+                          RNG & rng,
+                          typename Driver::Workspace & ws ) const {
+          typedef typename CellInfo::SpeciesRange SpeciesRange;
+          typedef typename SpeciesRange::iterator PIter;
+          typedef std::pair<PIter, PIter> CollisionPair;
+          typedef detail::DriverRetval< ChimpDB::options::inplace_interactions >
+            Retval;
+
+          typename Driver::CollisionTestData & ctd = ws.ctData(A,B);
+
+          if ( ctd.number_tests < threshold ) {
+            NTC::operator()( driver, A, B, cell, db, result_list, eq, rng, ws );
+            return;
+          }
+
+          const typename ChimpDB::Set & eqset = db(A,B);
+          SpeciesRange & aRange = cell.getSpecies(A);
+          SpeciesRange & bRange = cell.getSpecies(B);
+
+          if ( !enoughParticles( A, B, aRange, bRange ) )
+            return;
+
+          /* the same number of tests as NTC performs:  all tests while more
+           * than one remains. */
+          const unsigned int n_total =
+            static_cast<unsigned int>( std::ceil( ctd.number_tests - 1.0 ) );
+
+          ws.pair_a.resize( batch_size );
+          ws.pair_b.resize( batch_size );
+          ws.v_rel.resize( 2u * batch_size );
+          ws.paths.resize( batch_size );
+          ws.scratch.resize( ( eqset.rhs.size()
+                               + ChimpDB::Set::TESTPAIRS_SCRATCH_ROWS )
+                             * batch_size );
+
+          /* flags of the particles modified earlier in the batch. */
+          std::vector<char> & touched_a = ws.touched[A];
+          std::vector<char> & touched_b = ws.touched[B];
+          if ( touched_a.size() < aRange.size() )
+            touched_a.resize( aRange.size(), 0 );
+          if ( touched_b.size() < bRange.size() )
+            touched_b.resize( bRange.size(), 0 );
+
+          using chimp::accessors::particle::velocity;
+
+          ws.pending_a.clear();
+          ws.pending_b.clear();
+          ws.pending_paths.clear();
+
+          for ( unsigned int done = 0u; done < n_total; ) {
+            const unsigned int n_drawn = std::min( batch_size, n_total - done );
+
+            /* select the pairs of the batch; pairs that fail the weight test
+             * are rejected immediately. */
+            unsigned int n = 0u;
+            for ( unsigned int k = 0u; k < n_drawn; ++k ) {
+              CollisionPair pair;
+              if ( !selectPair( driver, db, A, B, aRange, bRange, rng, ws,
+                                pair ) ||
+                   !acceptWeights( pair, ctd.max_weight, rng ) ) {
+                driver.monitor.interactions( db, pair, std::make_pair(-1,0.0),
+                                             result_list );
+                continue;
+              }
+
+              ws.pair_a[n] = pair.first  - aRange.begin();
+              ws.pair_b[n] = pair.second - bRange.begin();
+              ++n;
+            }
+
+            /* relative speeds:  first the squares, then all roots at once. */
+            double * v2 = &ws.v_rel[0] + batch_size;
+            for ( unsigned int k = 0u; k < n; ++k ) {
+              const PIter pA = aRange.begin() + ws.pair_a[k];
+              const PIter pB = bRange.begin() + ws.pair_b[k];
+              const double dx = velocity(*pA)[0] - velocity(*pB)[0];
+              const double dy = velocity(*pA)[1] - velocity(*pB)[1];
+              const double dz = velocity(*pA)[2] - velocity(*pB)[2];
+              v2[k] = dx*dx + dy*dy + dz*dz;
+              ctd.max_v_rel2 = std::max( ctd.max_v_rel2, v2[k] );
+            }
+
+            for ( unsigned int k = 0u; k < n; ++k )
+              ws.v_rel[k] = std::sqrt( v2[k] );
+
+            eqset.testPairs( ctd.m_s_v, &ws.v_rel[0], n,
+                             &ws.paths[0], &ws.scratch[0], rng );
+
+            /* collide the accepted pairs in order.  Pairs that do not
+             * conflict with earlier pairs are deferred, and all deferred
+             * pairs are collided together before the next conflicting
+             * pair. */
+            for ( unsigned int k = 0u; k < n; ++k ) {
+              CollisionPair pair( aRange.begin() + ws.pair_a[k],
+                                  bRange.begin() + ws.pair_b[k] );
+              std::pair<int,double> path = ws.paths[k];
+
+              if ( !touched_a[ ws.pair_a[k] ] &&
+                   !touched_b[ ws.pair_b[k] ] &&
+                   !Retval::removed( ws, A, ws.pair_a[k] ) &&
+                   !Retval::removed( ws, B, ws.pair_b[k] ) ) {
+                ws.pending_a.push_back( ws.pair_a[k] );
+                ws.pending_b.push_back( ws.pair_b[k] );
+                ws.pending_paths.push_back( path );
+                if ( path.first >= 0 )
+                  touched_a[ ws.pair_a[k] ] = touched_b[ ws.pair_b[k] ] = 1;
+                continue;
+              }
+
+              collidePending( driver, A, B, db, aRange, bRange, result_list,
+                              rng, ws );
+
+              const size_t result_list_sz_i = result_list.size();
+
+              if ( Retval::removed( ws, A, ws.pair_a[k] ) ||
+                   Retval::removed( ws, B, ws.pair_b[k] ) ) {
+                /* replace the pair as NTC would have. */
+                path = std::make_pair(-1,0.0);
+                if ( selectPair( driver, db, A, B, aRange, bRange, rng, ws,
+                                 pair ) &&
+                     acceptWeights( pair, ctd.max_weight, rng ) )
+                  path = eqset.interact( ctd.m_s_v, pair, result_list, rng );
+
+                /* (such that the flags of the new pair are cleared) */
+                ws.pair_a[k] = pair.first  - aRange.begin();
+                ws.pair_b[k] = pair.second - bRange.begin();
+              } else
+                /* the batch test used stale velocities. */
+                path = eqset.interact( ctd.m_s_v, pair, result_list, rng );
+
+              driver.monitor.interactions( db, pair, path, result_list );
+
+              Retval()( path, pair, result_list, result_list_sz_i, ws,
+                        A, B, aRange, bRange );
+
+              if ( path.first >= 0 )
+                touched_a[ ws.pair_a[k] ] = touched_b[ ws.pair_b[k] ] = 1;
+            }
+
+            collidePending( driver, A, B, db, aRange, bRange, result_list,
+                            rng, ws );
+
+            /* clear only the flags that were set. */
+            for ( unsigned int k = 0u; k < n; ++k )
+              touched_a[ ws.pair_a[k] ] = touched_b[ ws.pair_b[k] ] = 0;
+
+            done += n_drawn;
+          }
+
+          ctd.number_tests -= n_total;
+        }
+
+        /** Collide the pairs of a batch that are deferred in the workspace
+         * together and report them to the monitor in order. */
+        template < typename Driver,
+                   typename ChimpDB,
+                   typename Range,
+                   typename BackInsertionSequence,
+                   typename RNG >
+        static void collidePending( Driver & driver,
+                                    const unsigned int & A,
+                                    const unsigned int & B,
+                                    const ChimpDB & db,
+                                    const Range & aRange,
+                                    const Range & bRange,
+                                    BackInsertionSequence & result_list,
+                                    RNG & rng,
+                                    typename Driver::Workspace & ws ) {
+          typedef detail::DriverRetval< ChimpDB::options::inplace_interactions >
+            Retval;
+          typedef typename Range::iterator PIter;
+
+          const unsigned int n = ws.pending_paths.size();
+          if ( n == 0u )
+            return;
+
+          const PendingPairs<PIter> pending( aRange.begin(), bRange.begin(),
+                                             &ws.pending_a[0],
+                                             &ws.pending_b[0] );
+          ws.created.resize( n );
+          db(A,B).performInteractions( &ws.pending_paths[0], pending, n,
+                                       result_list, &ws.created[0], rng );
+
+          for ( unsigned int j = 0u; j < n; ++j ) {
+            const std::pair<PIter,PIter> pair = pending[j];
+            driver.monitor.interactions( db, pair, ws.pending_paths[j],
+                                         result_list );
+            Retval()( ws.pending_paths[j], pair, bool(ws.created[j]), ws,
+                      A, B, aRange, bRange );
+          }
+
+          ws.pending_a.clear();
+          ws.pending_b.clear();
+          ws.pending_paths.clear();
+        }
+      };
+
+    }/* namespace chimp::interaction::scheme */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_scheme_BatchedNTC_h
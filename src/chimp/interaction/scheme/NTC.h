@@ -0,0 +1,201 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * No Time Counter (NTC) scheme for selecting and testing collision pairs.
+ * */
+
+#ifndef chimp_interaction_scheme_NTC_h
+#define chimp_interaction_scheme_NTC_h
+
+#include <chimp/interaction/detail/DriverRetval.h>
+#include <chimp/accessors.h>
+
+#include <xylose/logger.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace chimp {
+  namespace interaction {
+    namespace scheme {
+
+      /** The No Time Counter scheme of Graeme Bird.  The number of pairs
+       * computed by Driver::computeTests are selected (with replacement) by
+       * Driver::pair_selector and each is tested for an interaction against the
+       * maximum of (sigma*v_rel).  If the particles have different weights,
+       * each pair is first accepted with probability max(Fa,Fb)/MAX(F) (see
+       * acceptWeights and Driver::expectedTests).
+       *
+       * A scheme is used by interaction::Driver to perform all of the tests of
+       * one pair of species in a cell.
+       */
+      struct NTC {
+        /** Select, test, and collide the pairs of species A and B. */
+        template < typename Driver,
+                   typename CellInfo,
+                   typename ChimpDB,
+                   typename BackInsertionSequence,
+                   typename ErasureQueue,
+                   typename RNG >
+        void operator() ( Driver & driver,
+                          const unsigned int & A,
+                          const unsigned int & B,
+                          CellInfo & cell,
+                          const ChimpDB & db,
+                          BackInsertionSequence & result_list,
+                          ErasureQueue & eq,
+                          RNG & rng,
+                          typename Driver::Workspace & ws ) const {
+          typedef typename CellInfo::SpeciesRange SpeciesRange;
+          typedef typename SpeciesRange::iterator PIter;
+
+          const typename ChimpDB::Set & eqset = db(A,B);
+          SpeciesRange & aRange = cell.getSpecies(A);
+          SpeciesRange & bRange = cell.getSpecies(B);
+          typename Driver::CollisionTestData & ctd = ws.ctData(A,B);
+
+          while ( ctd.number_tests > 1.0 ) {
+            typedef std::pair<PIter, PIter> CollisionPair;
+
+            if ( !enoughParticles( A, B, aRange, bRange ) )
+              break;
+
+            CollisionPair pair;
+            if ( !selectPair( driver, db, A, B, aRange, bRange, rng, ws,
+                              pair ) ||
+                 !acceptWeights( pair, ctd.max_weight, rng ) ) {
+              driver.monitor.interactions( db, pair, std::make_pair(-1,0.0),
+                                           result_list );
+              ctd.number_tests -= 1.0;
+              continue;
+            }
+
+            recordSpeed( ctd, pair );
+
+            // Picks the correct output equation and uses it...
+            const size_t result_list_sz_i = result_list.size();
+            std::pair<int,double>
+              path = eqset.interact( ctd.m_s_v, pair, result_list, rng );
+
+            driver.monitor.interactions( db, pair, path, result_list );
+
+            detail::DriverRetval< ChimpDB::options::inplace_interactions >()(
+              path, pair,
+              result_list, result_list_sz_i, ws,
+              A, B, aRange, bRange
+            );
+
+            /* one down, ... more to go. */
+            ctd.number_tests -= 1.0;
+          }/* while doing colllision tests */
+        }
+
+        /** Select a pair with Driver::pair_selector, drawing again if either
+         * particle was already removed by an in-place interaction during this
+         * pass over the cell.  After max_removed_draws draws (such as when
+         * most particles are removed), the selection fails.
+         *
+         * @return Whether a pair of particles that are not removed was
+         * selected.
+         */
+        template < typename Driver,
+                   typename ChimpDB,
+                   typename SpeciesRange,
+                   typename RNG,
+                   typename Workspace,
+                   typename PIter >
+        static bool selectPair( Driver & driver,
+                                const ChimpDB & db,
+                                const unsigned int & A,
+                                const unsigned int & B,
+                                SpeciesRange & aRange,
+                                SpeciesRange & bRange,
+                                RNG & rng,
+                                const Workspace & ws,
+                                std::pair<PIter, PIter> & pair ) {
+          typedef detail::DriverRetval<
+            ChimpDB::options::inplace_interactions > Retval;
+          static const unsigned int max_removed_draws = 16u;
+
+          for ( unsigned int n = 0u; n < max_removed_draws; ++n ) {
+            pair = driver.pair_selector( aRange, bRange, rng );
+
+            if ( !Retval::removed( ws, A, pair.first  - aRange.begin() ) &&
+                 !Retval::removed( ws, B, pair.second - bRange.begin() ) )
+              return true;
+          }
+
+          return false;
+        }
+
+        /** Accept the given pair with probability max(Fa,Fb)/max_weight.  No
+         * random number is used if the larger of the two weights equals
+         * max_weight, such as when all particles have the same weight. */
+        template < typename PIter, typename RNG >
+        static bool acceptWeights( const std::pair<PIter, PIter> & pair,
+                                   const double & max_weight,
+                                   RNG & rng ) {
+          using chimp::accessors::particle::weight;
+          const double w = std::max( weight(*pair.first),
+                                     weight(*pair.second) );
+          return w >= max_weight || rng.rand() * max_weight < w;
+        }
+
+        /** Record the relative speed of the given pair in
+         * CollisionTestData::max_v_rel2 (for MaxSigmaVProduct::update). */
+        template < typename CollisionTestData, typename PIter >
+        static void recordSpeed( CollisionTestData & ctd,
+                                 const std::pair<PIter, PIter> & pair ) {
+          using chimp::accessors::particle::velocity;
+          const double dx = velocity(*pair.first)[0]-velocity(*pair.second)[0];
+          const double dy = velocity(*pair.first)[1]-velocity(*pair.second)[1];
+          const double dz = velocity(*pair.first)[2]-velocity(*pair.second)[2];
+          ctd.max_v_rel2 = std::max( ctd.max_v_rel2, dx*dx + dy*dy + dz*dz );
+        }
+
+        /** Whether there are enough particles to select a pair of species A
+         * and B.  A warning is logged if not. */
+        template < typename SpeciesRange >
+        static bool enoughParticles( const unsigned int & A,
+                                     const unsigned int & B,
+                                     const SpeciesRange & aRange,
+                                     const SpeciesRange & bRange ) {
+          if ((A == B && aRange.size() < 2) ||
+              (aRange.size() == 0u || bRange.size() == 0u)) {
+            /* not enough particles? */
+            using xylose::logger::log_warning;
+            log_warning( "Not enough particles to "
+                         "select collision pair %d:%d", A, B );
+            return false;
+          }
+
+          return true;
+        }
+      };
+
+    }/* namespace chimp::interaction::scheme */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_scheme_NTC_h
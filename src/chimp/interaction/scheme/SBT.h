@@ -0,0 +1,141 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Simplified Bernoulli Trials (SBT) scheme for selecting and testing
+ * collision pairs.
+ * */
+
+#ifndef chimp_interaction_scheme_SBT_h
+#define chimp_interaction_scheme_SBT_h
+
+#include <chimp/interaction/scheme/NTC.h>
+#include <chimp/interaction/detail/DriverRetval.h>
+
+#include <utility>
+
+namespace chimp {
+  namespace interaction {
+    namespace scheme {
+
+      /** The Simplified Bernoulli Trials scheme of Stefanov.  Instead of
+       * selecting a number of pairs at random, each particle i of species A
+       * is tested once against a partner chosen at random:  for A == B, the
+       * partner is one of the k = N-1-i particles that follow i in the
+       * range, and for A != B, it is one of the k = N_B particles of species
+       * B.  The pair interacts with probability
+       *    P = k MAX(F) dt (sigma v_rel) / V
+       * (followed by the weight acceptance of NTC::acceptWeights).  This is
+       * done with Set::interact, using V / ( k MAX(F) dt ) in place of the
+       * maximum of (sigma*v_rel).
+       *
+       * SBT remains accurate with only a few particles per cell, but
+       * requires P <= 1, i.e. a time step small enough compared to the
+       * collision time of the cell.
+       *
+       * Driver::computeTests still calculates the number of NTC tests,
+       * which are reported to the monitor but are not used otherwise.  The
+       * partners are chosen by SBT itself rather than by
+       * Driver::pair_selector.  As for NTC, the relative speeds of the
+       * tested pairs are recorded for MaxSigmaVProduct::update.
+       */
+      struct SBT {
+        /** Test the particles of species A against those of species B. */
+        template < typename Driver,
+                   typename CellInfo,
+                   typename ChimpDB,
+                   typename BackInsertionSequence,
+                   typename ErasureQueue,
+                   typename RNG >
+        void operator() ( Driver & driver,
+                          const unsigned int & A,
+                          const unsigned int & B,
+                          CellInfo & cell,
+                          const ChimpDB & db,
+                          BackInsertionSequence & result_list,
+                          ErasureQueue & eq,
+                          RNG & rng,
+                          typename Driver::Workspace & ws ) const {
+          typedef typename CellInfo::SpeciesRange SpeciesRange;
+          typedef typename SpeciesRange::iterator PIter;
+          typedef std::pair<PIter, PIter> CollisionPair;
+
+          const typename ChimpDB::Set & eqset = db(A,B);
+          SpeciesRange & aRange = cell.getSpecies(A);
+          SpeciesRange & bRange = cell.getSpecies(B);
+          typename Driver::CollisionTestData & ctd = ws.ctData(A,B);
+
+          ctd.number_tests = 0.0;
+
+          /* cells with too few particles are common with SBT and are
+           * silently skipped. */
+          if ( ctd.max_weight <= 0.0 || ws.dt <= 0.0 )
+            return;
+
+          /* V / ( MAX(F) dt ) */
+          const double volume_per_weight_dt =
+            cell.volume() / ( ctd.max_weight * ws.dt );
+
+          typedef detail::DriverRetval< ChimpDB::options::inplace_interactions >
+            Retval;
+
+          const unsigned int n_a = aRange.size();
+          const unsigned int n_b = bRange.size();
+          const unsigned int n_tested =
+            ( A == B ) ? ( n_a > 0u ? n_a - 1u : 0u )
+                       : ( n_b > 0u ? n_a : 0u );
+
+          /* particles removed by in-place interactions during this pass are
+           * not tested again, and a removed partner does not interact. */
+          for ( unsigned int i = 0u; i < n_tested; ++i ) {
+            if ( Retval::removed( ws, A, i ) )
+              continue;
+
+            const unsigned int k = ( A == B ) ? n_a - 1u - i : n_b;
+            const unsigned int j = ( A == B ? i + 1u : 0u )
+                                 + static_cast<unsigned int>( k*rng.randExc() );
+            const CollisionPair pair( aRange.begin() + i, bRange.begin() + j );
+
+            std::pair<int,double> path = std::make_pair(-1,0.0);
+            const size_t result_list_sz_i = result_list.size();
+
+            if ( !Retval::removed( ws, B, j ) &&
+                 NTC::acceptWeights( pair, ctd.max_weight, rng ) ) {
+              NTC::recordSpeed( ctd, pair );
+              path = eqset.interact( volume_per_weight_dt / k, pair,
+                                     result_list, rng );
+            }
+
+            driver.monitor.interactions( db, pair, path, result_list );
+
+            Retval()( path, pair, result_list, result_list_sz_i, ws,
+                      A, B, aRange, bRange );
+          }/* for each particle of A */
+        }
+      };
+
+    }/* namespace chimp::interaction::scheme */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_scheme_SBT_h
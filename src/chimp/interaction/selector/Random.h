@@ -0,0 +1,68 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Uniform random selection of collision partners.
+ * */
+
+#ifndef chimp_interaction_selector_Random_h
+#define chimp_interaction_selector_Random_h
+
+#include <chimp/interaction/selectRandomPair.h>
+
+#include <utility>
+
+namespace chimp {
+  namespace interaction {
+    namespace selector {
+
+      /** Pair selector that chooses both partners uniformly from the species
+       * ranges of the whole cell (see selectRandomPair).
+       *
+       * A pair selector is used by the NTC schemes through
+       * Driver::pair_selector.  Driver::performTests calls prepare(cell,A,B)
+       * before the pairs of species A and B of a cell are selected.
+       */
+      struct Random {
+        /** Nothing to prepare. */
+        template < typename CellInfo >
+        void prepare( CellInfo & cell,
+                      const unsigned int & A,
+                      const unsigned int & B ) { }
+
+        /** Select a pair of distinct particles from aRange and bRange. */
+        template < typename SpeciesRange, typename RNG >
+        std::pair< typename SpeciesRange::iterator,
+                   typename SpeciesRange::iterator >
+        operator() ( SpeciesRange & aRange,
+                     SpeciesRange & bRange,
+                     RNG & rng ) {
+          return selectRandomPair( aRange, bRange, rng );
+        }
+      };
+
+    }/* namespace chimp::interaction::selector */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_selector_Random_h
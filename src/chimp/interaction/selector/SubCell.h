@@ -0,0 +1,261 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Selection of collision partners from virtual sub-cells.
+ * */
+
+#ifndef chimp_interaction_selector_SubCell_h
+#define chimp_interaction_selector_SubCell_h
+
+#include <chimp/accessors.h>
+
+#include <xylose/Vector.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <cmath>
+
+namespace chimp {
+  namespace interaction {
+    namespace selector {
+
+      /** Pair selector that chooses the second partner close to the first.
+       * The first partner is chosen uniformly from species A.  The
+       * particles of species B are sorted (transiently, by index) into a
+       * uniform grid of virtual sub-cells over their bounding box, such that
+       * there are about particles_per_subcell particles per sub-cell.  The
+       * second partner is then either chosen at random from the sub-cell of
+       * the first partner, or is the nearest particle of that sub-cell (if
+       * nearest_neighbor is set).  If the sub-cell contains no other
+       * particle, the second partner is chosen uniformly from the whole
+       * range.
+       *
+       * The number of pairs tested is still calculated for the whole cell,
+       * so that cells may be larger than the mean free path while
+       * collisions remain between near neighbors.  The sort is redone
+       * whenever the species range of B changes, such as after in-place
+       * interactions remove particles.
+       */
+      struct SubCell {
+        /* MEMBER STORAGE */
+        /** Target number of particles of species B per sub-cell. */
+        double particles_per_subcell;
+
+        /** Whether the nearest particle of the sub-cell is chosen instead of
+         * a random one. */
+        bool nearest_neighbor;
+
+      private:
+        /** Whether the pairs are of identical species. */
+        bool same_species;
+
+        /** Begin and size of the range that is sorted. */
+        const void * sorted_begin;
+        unsigned int sorted_size;
+
+        /** Lower corner of the bounding box of the sorted particles. */
+        xylose::Vector<double,3> lower;
+
+        /** Inverse of the sub-cell size. */
+        xylose::Vector<double,3> dx_inv;
+
+        /** Number of sub-cells per dimension. */
+        unsigned int n_per_dim;
+
+        /** Offsets of each sub-cell into index (n_per_dim^3 + 1 values). */
+        std::vector<unsigned int> offset;
+
+        /** Indices of the particles of species B, sorted by sub-cell. */
+        std::vector<unsigned int> index;
+
+        /** Sub-cell of each particle of species B. */
+        std::vector<unsigned int> subcell;
+
+        /** Scratch space for the sort. */
+        std::vector<unsigned int> cursor;
+
+
+        /* MEMBER FUNCTIONS */
+      public:
+        /** Constructor. */
+        SubCell( const double & particles_per_subcell = 2.0,
+                 const bool & nearest_neighbor = false )
+          : particles_per_subcell( std::max( particles_per_subcell, 1.0 ) ),
+            nearest_neighbor( nearest_neighbor ),
+            same_species( false ), sorted_begin( 0 ), sorted_size( 0u ),
+            lower( 0.0 ), dx_inv( 0.0 ), n_per_dim( 1u ) { }
+
+        /** Sort the particles of species B of the cell into sub-cells. */
+        template < typename CellInfo >
+        void prepare( CellInfo & cell,
+                      const unsigned int & A,
+                      const unsigned int & B ) {
+          same_species = ( A == B );
+          sort( cell.getSpecies(B) );
+        }
+
+        /** Select a pair of distinct particles from aRange and bRange. */
+        template < typename SpeciesRange, typename RNG >
+        std::pair< typename SpeciesRange::iterator,
+                   typename SpeciesRange::iterator >
+        operator() ( SpeciesRange & aRange,
+                     SpeciesRange & bRange,
+                     RNG & rng ) {
+          typedef typename SpeciesRange::iterator PIter;
+          using chimp::accessors::particle::position;
+
+          const unsigned int Bsz = bRange.size();
+          if ( Bsz == 0u || sorted_size != Bsz ||
+               sorted_begin != static_cast<const void*>( &*bRange.begin() ) )
+            sort( bRange );
+
+          const PIter pA = aRange.begin()
+                         + static_cast<int>( aRange.size() * rng.randExc() );
+          const PIter Bbegin = bRange.begin();
+
+          /* index of pA in the range of B, if it is part of it. */
+          const unsigned int self =
+            same_species ? static_cast<unsigned int>( pA - Bbegin ) : Bsz;
+
+          const unsigned int s =
+            ( self < Bsz ) ? subcell[self] : locate( position(*pA) );
+          const unsigned int * first = &index[0] + offset[s];
+          const unsigned int * last  = &index[0] + offset[s+1u];
+          const unsigned int n_candidates =
+            static_cast<unsigned int>( last - first ) - (self < Bsz ? 1u : 0u);
+
+          if ( n_candidates == 0u ) {
+            /* nothing else in this sub-cell:  select from the whole cell. */
+            PIter pB = pA;
+            while ( pA == pB )
+              pB = Bbegin + static_cast<int>( Bsz * rng.randExc() );
+            return std::make_pair( pA, pB );
+          }
+
+          if ( nearest_neighbor ) {
+            const xylose::Vector<double,3> & xA = position(*pA);
+            unsigned int best = Bsz;
+            double best_r2 = std::numeric_limits<double>::infinity();
+            for ( const unsigned int * i = first; i != last; ++i ) {
+              if ( *i == self )
+                continue;
+
+              const xylose::Vector<double,3> & xB = position(*(Bbegin + *i));
+              const double r2 = ( xB[0] - xA[0] ) * ( xB[0] - xA[0] )
+                              + ( xB[1] - xA[1] ) * ( xB[1] - xA[1] )
+                              + ( xB[2] - xA[2] ) * ( xB[2] - xA[2] );
+              if ( r2 < best_r2 ) {
+                best_r2 = r2;
+                best = *i;
+              }
+            }
+
+            return std::make_pair( pA, Bbegin + best );
+          }
+
+          /* random particle of the sub-cell, skipping pA (the indices of
+           * each sub-cell are sorted). */
+          const unsigned int * j =
+            first + static_cast<int>( n_candidates * rng.randExc() );
+          if ( self < Bsz && *j >= self )
+            ++j;
+
+          return std::make_pair( pA, Bbegin + *j );
+        }
+
+      private:
+        /** The sub-cell that contains the given position (positions outside
+         * of the bounding box are assigned to the nearest sub-cell). */
+        unsigned int locate( const xylose::Vector<double,3> & x ) const {
+          unsigned int s = 0u;
+          for ( int d = 2; d >= 0; --d ) {
+            const double f = ( x[d] - lower[d] ) * dx_inv[d];
+            unsigned int i = 0u;
+            if ( f > 0.0 )
+              i = std::min( static_cast<unsigned int>( f ), n_per_dim - 1u );
+            s = s * n_per_dim + i;
+          }
+          return s;
+        }
+
+        /** Sort the particles of the given range into sub-cells. */
+        template < typename SpeciesRange >
+        void sort( SpeciesRange & range ) {
+          typedef typename SpeciesRange::iterator PIter;
+          using chimp::accessors::particle::position;
+
+          const unsigned int n = range.size();
+          sorted_size = n;
+          sorted_begin = n ? static_cast<const void*>( &*range.begin() ) : 0;
+
+          n_per_dim = std::max( 1u, static_cast<unsigned int>(
+            std::pow( n / particles_per_subcell, 1.0 / 3.0 ) ) );
+
+          /* bounding box */
+          xylose::Vector<double,3> upper( 0.0 );
+          lower = 0.0;
+          if ( n ) {
+            lower = upper = position(*range.begin());
+            for ( PIter i = range.begin(), end = range.end(); i != end; ++i ) {
+              const xylose::Vector<double,3> & x = position(*i);
+              for ( unsigned int d = 0u; d < 3u; ++d ) {
+                lower[d] = std::min( lower[d], x[d] );
+                upper[d] = std::max( upper[d], x[d] );
+              }
+            }
+          }
+
+          for ( unsigned int d = 0u; d < 3u; ++d ) {
+            const double width = upper[d] - lower[d];
+            dx_inv[d] = ( width > 0.0 ) ? n_per_dim / width : 0.0;
+          }
+
+          /* counting sort of the indices by sub-cell. */
+          const unsigned int n_subcells = n_per_dim * n_per_dim * n_per_dim;
+          offset.assign( n_subcells + 1u, 0u );
+          subcell.resize( n );
+          index.resize( n );
+
+          PIter p = range.begin();
+          for ( unsigned int i = 0u; i < n; ++i, ++p ) {
+            subcell[i] = locate( position(*p) );
+            ++offset[ subcell[i] + 1u ];
+          }
+
+          for ( unsigned int s = 0u; s < n_subcells; ++s )
+            offset[s+1u] += offset[s];
+
+          cursor.assign( offset.begin(), offset.end() - 1 );
+          for ( unsigned int i = 0u; i < n; ++i )
+            index[ cursor[ subcell[i] ]++ ] = i;
+        }
+      };
+
+    }/* namespace chimp::interaction::selector */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_selector_SubCell_h
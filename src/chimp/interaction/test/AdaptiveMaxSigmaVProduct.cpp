@@ -0,0 +1,163 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+/** \file
+ * Test file for the AdaptiveMaxSigmaVProduct class.
+ * */
+#define BOOST_TEST_MODULE  AdaptiveMaxSigmaVProduct
+
+
+#include <chimp/interaction/AdaptiveMaxSigmaVProduct.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <utility>
+
+namespace {
+  using chimp::interaction::AdaptiveMaxSigmaVProduct;
+  typedef AdaptiveMaxSigmaVProduct::State State;
+
+  /** Set of equations for which (sigma*v)_max = 2*v_rel_max. */
+  struct MockSet {
+    double findMaxSigmaVProduct( const double & v_rel_max ) const {
+      return 2.0 * v_rel_max;
+    }
+  };
+
+  /** Cell information with a fixed maximum relative velocity and storage of
+   * the adaptive state of each pair of species. */
+  struct MockInfo {
+    double v_rel_max;
+    std::map< std::pair<int,int>, State > states;
+
+    MockInfo( const double & v_rel_max ) : v_rel_max( v_rel_max ) { }
+
+    double maxRelativeVelocity( const int & A, const int & B ) const {
+      return v_rel_max;
+    }
+
+    State & maxSigmaVState( const int & A, const int & B ) {
+      return states[ std::make_pair(A,B) ];
+    }
+  };
+
+  /** The database argument of update is not used. */
+  const int db = 0;
+}
+
+BOOST_AUTO_TEST_SUITE( AdaptiveMaxSigmaVProduct_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( initialization ) {
+    AdaptiveMaxSigmaVProduct msvp;
+    MockSet set;
+    MockInfo info( 50.0 );
+
+    BOOST_CHECK_EQUAL( msvp.get( set, info, 0, 1 ), 100.0 );
+
+    /* the value persists even if the bound of the cell changes. */
+    info.v_rel_max = 10.0;
+    BOOST_CHECK_EQUAL( msvp.get( set, info, 0, 1 ), 100.0 );
+    BOOST_CHECK_EQUAL( msvp.get( set, info, 1, 1 ), 20.0 );
+  }
+
+  BOOST_AUTO_TEST_CASE( immediate_raise ) {
+    AdaptiveMaxSigmaVProduct msvp( 10u, 1.25, 0.5 );
+    MockSet set;
+    MockInfo info( 50.0 );
+    BOOST_REQUIRE_EQUAL( msvp.get( set, info, 0, 1 ), 100.0 );
+
+    /* below the current value:  nothing changes within the window. */
+    msvp.update( db, info, 0, 1, 60.0 );
+    BOOST_CHECK_EQUAL( msvp.get( set, info, 0, 1 ), 100.0 );
+
+    /* above the current value (after the safety factor):  raised at once. */
+    msvp.update( db, info, 0, 1, 90.0 );
+    BOOST_CHECK_EQUAL( msvp.get( set, info, 0, 1 ), 1.25 * 90.0 );
+    BOOST_CHECK_EQUAL( info.maxSigmaVState(0,1).n_updates, 2u );
+
+    /* the other pairs of species are not affected. */
+    BOOST_CHECK_EQUAL( info.maxSigmaVState(1,1).m_s_v, 0.0 );
+  }
+
+  BOOST_AUTO_TEST_CASE( decay_at_window_end ) {
+    AdaptiveMaxSigmaVProduct msvp( 4u, 1.2, 0.5 );
+    MockSet set;
+    MockInfo info( 50.0 );
+    BOOST_REQUIRE_EQUAL( msvp.get( set, info, 0, 1 ), 100.0 );
+    const State & state = info.maxSigmaVState(0,1);
+
+    const double obs[] = { 10.0, 20.0, 15.0 };
+    for ( unsigned int i = 0u; i < 3u; ++i ) {
+      msvp.update( db, info, 0, 1, obs[i] );
+      BOOST_CHECK_EQUAL( state.m_s_v, 100.0 );
+    }
+    BOOST_CHECK_EQUAL( state.window_max, 20.0 );
+
+    /* end of the first window:  halfway towards 1.2 * 20. */
+    msvp.update( db, info, 0, 1, 5.0 );
+    BOOST_CHECK_CLOSE( state.m_s_v, 100.0 - 0.5 * ( 100.0 - 24.0 ), 1e-12 );
+    BOOST_CHECK_EQUAL( state.window_max, 0.0 );
+    BOOST_CHECK_EQUAL( state.n_updates, 0u );
+
+    /* end of the second window. */
+    for ( unsigned int i = 0u; i < 4u; ++i )
+      msvp.update( db, info, 0, 1, 1.0 );
+    BOOST_CHECK_CLOSE( state.m_s_v, 62.0 - 0.5 * ( 62.0 - 1.2 ), 1e-12 );
+
+    /* with complete decay, the value drops to the bound of the window but
+     * not below it. */
+    AdaptiveMaxSigmaVProduct full( 2u, 1.2, 1.0 );
+    full.update( db, info, 0, 1, 3.0 );
+    full.update( db, info, 0, 1, 2.0 );
+    BOOST_CHECK_CLOSE( state.m_s_v, 1.2 * 3.0, 1e-12 );
+
+    /* a value that is already at the bound is not lowered further. */
+    full.update( db, info, 0, 1, 3.0 );
+    full.update( db, info, 0, 1, 3.0 );
+    BOOST_CHECK_CLOSE( state.m_s_v, 1.2 * 3.0, 1e-12 );
+  }
+
+  BOOST_AUTO_TEST_CASE( constructor_clamping ) {
+    const AdaptiveMaxSigmaVProduct low( 0u, 0.5, -1.0 );
+    BOOST_CHECK_EQUAL( low.window, 1u );
+    BOOST_CHECK_EQUAL( low.safety, 1.0 );
+    BOOST_CHECK_EQUAL( low.decay, 0.0 );
+
+    const AdaptiveMaxSigmaVProduct high( 7u, 2.0, 3.0 );
+    BOOST_CHECK_EQUAL( high.window, 7u );
+    BOOST_CHECK_EQUAL( high.safety, 2.0 );
+    BOOST_CHECK_EQUAL( high.decay, 1.0 );
+
+    /* with a window of one update and no decay, the value is never
+     * lowered. */
+    MockSet set;
+    MockInfo info( 50.0 );
+    BOOST_REQUIRE_EQUAL( low.get( set, info, 0, 0 ), 100.0 );
+    low.update( db, info, 0, 0, 10.0 );
+    BOOST_CHECK_EQUAL( low.get( set, info, 0, 0 ), 100.0 );
+    BOOST_CHECK_EQUAL( info.maxSigmaVState(0,0).n_updates, 0u );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
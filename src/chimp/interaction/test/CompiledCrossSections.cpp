@@ -0,0 +1,166 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the interaction::detail::CompiledCrossSections class.
+ * */
+#define BOOST_TEST_MODULE  CompiledCrossSections
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/Equation.h>
+#include <chimp/interaction/detail/CompiledCrossSections.h>
+#include <chimp/interaction/cross_section/VHS.h>
+#include <chimp/interaction/cross_section/DATA.h>
+#include <chimp/interaction/cross_section/Constant.h>
+#include <chimp/interaction/cross_section/detail/AvgEasy.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <physical/physical.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  typedef chimp::make_options<>::type options;
+  typedef chimp::interaction::Equation<options> Equation;
+  typedef chimp::interaction::detail::CompiledCrossSections<options>
+    CompiledCrossSections;
+  typedef chimp::interaction::cross_section::Base<options> Base;
+  typedef chimp::interaction::cross_section::VHS<options> VHS;
+  typedef chimp::interaction::cross_section::DATA<options> DATA;
+  typedef chimp::interaction::cross_section::Constant<options> Constant;
+  typedef chimp::interaction::cross_section::detail::AvgEasy<options>
+    AvgEasy;
+  typedef chimp::interaction::test::PowerLaw<options> PowerLaw;
+  typedef boost::shared_ptr<Base> CSPtr;
+  using chimp::interaction::ReducedMass;
+  using chimp::interaction::cross_section::DoubleDataSet;
+
+  using physical::constant::si::m_e;
+
+  CSPtr makeVHS( const double & cross_section, const double & mu ) {
+    return CSPtr( chimp::interaction::test::newVHS<options>( cross_section,
+                                                             mu ) );
+  }
+
+  /** Tabulated cross section that does not go to zero at the end of the
+   * table (at v = 1e6) and is thus extrapolated beyond. */
+  CSPtr makeDATA() {
+    DoubleDataSet table;
+    for ( double v = 1e4; v <= 1e6; v *= 1.2 )
+      table.insert( std::make_pair( v, 1e-20 * ( 1.0 + 1e4 / v ) ) );
+    return CSPtr( new DATA( table ) );
+  }
+
+  void addEquation( Equation::list & rhs, const CSPtr & cs ) {
+    Equation eq;
+    eq.cs = cs;
+    rhs.push_back( eq );
+  }
+
+  /** One equation of each compiled type and one of a user type. */
+  Equation::list makeEquations() {
+    Equation::list rhs;
+    addEquation( rhs, makeVHS( 1e-19, m_e ) );
+    addEquation( rhs, makeDATA() );
+    addEquation( rhs, CSPtr( new Constant( 3e-20 ) ) );
+    addEquation( rhs, CSPtr( new AvgEasy( makeVHS( 2e-19, 1e-26 ),
+                                          CSPtr( new Constant( 1e-19 ) ) ) ) );
+    addEquation( rhs, CSPtr( new PowerLaw( 1e-20, 0.5 ) ) );
+    return rhs;
+  }
+
+  /** Check the compiled evaluation against the virtual interface of rhs
+   * over the given range of speeds. */
+  void checkEvaluation( const CompiledCrossSections & compiled,
+                        const Equation::list & rhs,
+                        const double & v0, const double & v1 ) {
+    std::vector<double> sigma( rhs.size() );
+    for ( double v = v0; v < v1; v *= 1.37 ) {
+      compiled.evaluate( v, &sigma[0] );
+      for ( unsigned int i = 0u; i < rhs.size(); ++i )
+        BOOST_CHECK_EQUAL( sigma[i], (*rhs[i].cs)( v ) );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( CompiledCrossSections_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( matches_virtual ) {
+    const Equation::list rhs = makeEquations();
+    CompiledCrossSections compiled;
+    compiled.compile( rhs );
+
+    BOOST_CHECK_EQUAL( compiled.size(), rhs.size() );
+    BOOST_CHECK_EQUAL( compiled.numberVirtual(), 1u );
+    BOOST_CHECK( compiled.isCompiled( rhs ) );
+    checkEvaluation( compiled, rhs, 1e3, 1e6 );
+  }
+
+  BOOST_AUTO_TEST_CASE( extrapolations_counted_once ) {
+    const Equation::list rhs = makeEquations();
+    CompiledCrossSections compiled;
+    compiled.compile( rhs );
+
+    const DATA & data = dynamic_cast<const DATA &>( *rhs[1].cs );
+    BOOST_CHECK_EQUAL( data.getNumberExtraps(), 0u );
+
+    /* the compiled evaluation extrapolates the DATA of the equation itself
+     * (not a copy), as does the virtual evaluation. */
+    std::vector<double> sigma( rhs.size() );
+    compiled.evaluate( 2e6, &sigma[0] );
+    BOOST_CHECK_EQUAL( data.getNumberExtraps(), 1u );
+    BOOST_CHECK_EQUAL( sigma[1], data( 2e6 ) );
+    BOOST_CHECK_EQUAL( data.getNumberExtraps(), 2u );
+  }
+
+  BOOST_AUTO_TEST_CASE( changes_seen ) {
+    Equation::list rhs = makeEquations();
+    CompiledCrossSections compiled;
+    compiled.compile( rhs );
+
+    /* changes of the parameters of a cross section are used directly. */
+    ReducedMass mu;
+    mu.value = 4.0 * m_e;
+    static_cast<VHS &>( *rhs[0].cs ).setReducedMass( mu );
+    static_cast<Constant &>( *rhs[2].cs ).value = 5e-20;
+    BOOST_CHECK( compiled.isCompiled( rhs ) );
+    checkEvaluation( compiled, rhs, 1e3, 1e6 );
+
+    /* replaced cross sections are detected. */
+    rhs[2].cs.reset( new Constant( 1e-20 ) );
+    BOOST_CHECK( !compiled.isCompiled( rhs ) );
+
+    rhs.pop_back();
+    compiled.compile( rhs );
+    BOOST_CHECK( compiled.isCompiled( rhs ) );
+    BOOST_CHECK_EQUAL( compiled.numberVirtual(), 0u );
+    checkEvaluation( compiled, rhs, 1e3, 1e6 );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
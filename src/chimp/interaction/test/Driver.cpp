@@ -0,0 +1,467 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+
+/** \file
+ * Test file for the Driver class.
+ * */
+#define BOOST_TEST_MODULE  Driver
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/Driver.h>
+#include <chimp/interaction/Particle.h>
+#include <chimp/interaction/scheme/NTC.h>
+#include <chimp/interaction/scheme/BatchedNTC.h>
+#include <chimp/interaction/scheme/SBT.h>
+#include <chimp/interaction/model/Elastic.h>
+#include <chimp/interaction/model/InElastic.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <xylose/random/Kiss.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <vector>
+#include <set>
+#include <cmath>
+
+namespace {
+  using chimp::interaction::Particle;
+  using chimp::interaction::ReducedMass;
+  using chimp::interaction::DefaultMaxSigmaVProduct;
+  using xylose::V3;
+  namespace scheme = chimp::interaction::scheme;
+
+  typedef chimp::make_options<>::type
+    ::setInplaceInteractions<false>::type options;
+  typedef chimp::make_options<>::type
+    ::setInplaceInteractions<true>::type inplace_options;
+  typedef chimp::interaction::test::MockCell<Particle> Cell;
+  typedef Cell::ParticleIterator PIter;
+  typedef chimp::interaction::test::RecordingMonitor Monitor;
+
+  /** Species 0 and 1 of masses 1 and 4, where species 0 scatters elastically
+   * (in place) and species 0 and 1 react to products of species 2 and 3
+   * (which thus replace the inputs). */
+  template < typename options >
+  chimp::interaction::test::MockDB<options> makeReactiveDB() {
+    typedef chimp::interaction::test::PowerLaw<options> PowerLaw;
+    typedef chimp::interaction::model::InElastic<options> InElastic;
+
+    std::vector<double> mass;
+    mass.push_back( 1.0 );
+    mass.push_back( 4.0 );
+    mass.push_back( 1.0 );
+    mass.push_back( 4.0 );
+    chimp::interaction::test::MockDB<options> db( mass );
+
+    db.addEquation( 0, 0, new PowerLaw( 1.0, 1.0 ),
+      new chimp::interaction::model::Elastic<options>( ReducedMass(1.,1.) ) );
+
+    std::vector<typename InElastic::Product> outputs;
+    outputs.push_back( typename InElastic::Product( 2, 1.0, 0u ) );
+    outputs.push_back( typename InElastic::Product( 3, 4.0, 1u ) );
+    db.addEquation( 0, 1, new PowerLaw( 1.0, 1.0 ),
+                    new InElastic( ReducedMass( 1.0, 4.0 ), 0, 1e-6,
+                                   outputs ) );
+    return db;
+  }
+
+  /** Particles of the given numbers per species (identified by their
+   * position x[0], the index into the particles) with random velocities. */
+  void makeParticles( std::vector<Particle> & particles,
+                      const std::vector<unsigned int> & n,
+                      const unsigned int & seed ) {
+    xylose::random::Kiss rng( seed );
+    particles.clear();
+    for ( unsigned int A = 0u; A < n.size(); ++A )
+      for ( unsigned int i = 0u; i < n[A]; ++i ) {
+        const unsigned int id = particles.size();
+        particles.push_back(
+          Particle( V3( id, 0, 0 ),
+                    V3( rng.rand() - 0.5, rng.rand() - 0.5, rng.rand() - 0.5 ),
+                    A ) );
+      }
+  }
+
+  /** Species 0 and 1 for which sigma*v = v^2, with a model that changes
+   * nothing (such that the cell stays the same).  Only species 0 and 1
+   * interact with each other unless all pairs. */
+  chimp::interaction::test::MockDB<options> makeNullDB( const bool & all ) {
+    typedef chimp::interaction::test::PowerLaw<options> PowerLaw;
+    typedef chimp::interaction::test::Null<options> Null;
+
+    chimp::interaction::test::MockDB<options> db( std::vector<double>(2,1.) );
+    db.addEquation( 0, 1, new PowerLaw( 1.0, 2.0 ), new Null() );
+    if ( all ) {
+      db.addEquation( 0, 0, new PowerLaw( 1.0, 2.0 ), new Null() );
+      db.addEquation( 1, 1, new PowerLaw( 1.0, 2.0 ), new Null() );
+    }
+    return db;
+  }
+
+  /** Run the driver with the given scheme n_trials times over a cell with
+   * n[A] of the given particles of species A (with the model that changes
+   * nothing).  The number of interactions of each pair of particles i and j
+   * is compared with the expected number
+   *    n_trials * max(Fi,Fj) dt (sigma v_ij) / V
+   * if per_pair, and the total of each pair of species otherwise.  If not
+   * all, only the pairs of species 0 and 1 interact.
+   */
+  template < typename Scheme >
+  void checkRates( const Scheme & test_scheme,
+                   const std::vector<unsigned int> & n,
+                   std::vector<Particle> particles,
+                   const double & dt,
+                   const unsigned int & n_trials,
+                   const bool & per_pair,
+                   const bool & all = true ) {
+    typedef chimp::interaction::test::MockDB<options> DB;
+    typedef chimp::interaction::Driver< Monitor, DefaultMaxSigmaVProduct,
+                                        Scheme > Driver;
+    const DB db = makeNullDB( all );
+    Cell cell( particles.begin(), n, 0.5 );
+
+    Monitor monitor;
+    Driver driver( monitor, DefaultMaxSigmaVProduct(), test_scheme );
+    std::vector<Particle> products;
+    xylose::random::Kiss rng(5u);
+    for ( unsigned int t = 0u; t < n_trials; ++t )
+      driver( dt, cell, db, products, rng );
+
+    BOOST_CHECK_EQUAL( products.size(), 0u );
+
+    /* the counts by pair of particles or of species. */
+    typedef std::pair<unsigned int, unsigned int> Key;
+    std::map<Key, double> count, expected;
+    for ( unsigned int k = 0u; k < monitor.accepted.size(); ++k ) {
+      const unsigned int i = monitor.accepted[k].first,
+                         j = monitor.accepted[k].second;
+      BOOST_REQUIRE_NE( i, j );
+      const Key key = per_pair
+        ? Key( std::min(i,j), std::max(i,j) )
+        : Key( particles[i].species, particles[j].species );
+      count[key] += 1.0;
+    }
+
+    for ( unsigned int i = 0u; i < particles.size(); ++i )
+      for ( unsigned int j = i + 1u; j < particles.size(); ++j ) {
+        const Particle & pi = particles[i], & pj = particles[j];
+        if ( !all && pi.species == pj.species )
+          continue;
+
+        const Key key = per_pair ? Key(i,j) : Key( pi.species, pj.species );
+        expected[key] += n_trials * std::max( pi.weight, pj.weight ) * dt
+                       * ( pi.v - pj.v ) * ( pi.v - pj.v ) / cell.volume();
+      }
+
+    for ( std::map<Key, double>::const_iterator i = expected.begin();
+                                          i != expected.end(); ++i ) {
+      /* the variance of a sum of Bernoulli trials is at most its mean. */
+      BOOST_CHECK_GT( i->second, 100.0 );
+      BOOST_CHECK_SMALL( count[i->first] - i->second,
+                         5.0 * std::sqrt( i->second ) );
+    }
+
+    BOOST_CHECK_EQUAL( count.size(), expected.size() );
+  }
+
+  /** Particles with the given velocities (identified by their position
+   * x[0], the index into the particles). */
+  std::vector<Particle> makeParticles( const unsigned int & n,
+                                       const double v[][3],
+                                       const int & species = 0 ) {
+    std::vector<Particle> particles;
+    for ( unsigned int i = 0u; i < n; ++i )
+      particles.push_back( Particle( V3( i, 0, 0 ),
+                                     V3( v[i][0], v[i][1], v[i][2] ),
+                                     species ) );
+    return particles;
+  }
+
+  /** MaxSigmaVProduct that records the largest value given to update. */
+  struct RecordingMaxSigmaVProduct : DefaultMaxSigmaVProduct {
+    double * updated;
+
+    RecordingMaxSigmaVProduct( double * updated ) : updated(updated) { }
+
+    template < typename ChimpDB,
+               typename CrossSpeciesInfo >
+    void update( const ChimpDB & db,
+                 const CrossSpeciesInfo & info,
+                 const int & A,
+                 const int & B,
+                 const double & m_s_v ) const {
+      *updated = std::max( *updated, m_s_v );
+    }
+  };
+
+  /** Run the driver with the given scheme once over a cell of species 0
+   * and 1 (for which sigma*v = v^2) and check the value given to
+   * MaxSigmaVProduct::update against the largest relative speed of the
+   * pairs of species 0 and 1. */
+  template < typename Scheme >
+  void checkUpdate( const Scheme & test_scheme ) {
+    typedef chimp::interaction::test::MockDB<options> DB;
+    typedef chimp::interaction::Driver< Monitor, RecordingMaxSigmaVProduct,
+                                        Scheme > Driver;
+    const DB db = makeNullDB( false );
+
+    std::vector<unsigned int> n( 2u, 50u );
+    std::vector<Particle> particles;
+    makeParticles( particles, n, 7u );
+    Cell cell( particles.begin(), n );
+
+    double v2_max = 0.0;
+    for ( unsigned int i = 0u; i < n[0]; ++i )
+      for ( unsigned int j = n[0]; j < particles.size(); ++j )
+        v2_max = std::max( v2_max, ( particles[i].v - particles[j].v )
+                                 * ( particles[i].v - particles[j].v ) );
+
+    double updated = 0.0;
+    Monitor monitor;
+    Driver driver( monitor, RecordingMaxSigmaVProduct( &updated ),
+                   test_scheme );
+    std::vector<Particle> products;
+    xylose::random::Kiss rng(9u);
+    driver( 0.01, cell, db, products, rng );
+
+    BOOST_CHECK_GT( monitor.tests, 0u );
+    BOOST_CHECK_GT( updated, 0.0 );
+    BOOST_CHECK_LE( updated, v2_max * ( 1.0 + 1e-12 ) );
+  }
+
+  /** Run the driver with the given scheme over one cell of reacting
+   * species and check the in-place removal of the reacting particles. */
+  template < typename Scheme >
+  void checkInplace( const Scheme & test_scheme ) {
+    typedef chimp::interaction::test::MockDB<inplace_options> DB;
+    typedef chimp::interaction::Driver< Monitor, DefaultMaxSigmaVProduct,
+                                        Scheme > Driver;
+    const DB db = makeReactiveDB<inplace_options>();
+
+    std::vector<unsigned int> n;
+    n.push_back( 400u );
+    n.push_back( 300u );
+
+    std::vector<Particle> particles;
+    makeParticles( particles, n, 3u );
+    Cell cell( particles.begin(), n );
+    const std::vector<Cell::SpeciesRange> initial = cell.species;
+
+    Monitor monitor;
+    Driver driver( monitor, DefaultMaxSigmaVProduct(), test_scheme );
+    std::vector<Particle> products;
+    std::set<PIter> eq;
+    xylose::random::Kiss rng(1u);
+    driver( 0.002, cell, db, products, eq, rng );
+
+    /* no interacting pair contains a particle that reacted before. */
+    std::set<double> removed;
+    unsigned int n_reused = 0u, n_reactions = 0u;
+    for ( unsigned int k = 0u; k < monitor.accepted.size(); ++k ) {
+      const std::pair<double,double> & ids = monitor.accepted[k];
+      n_reused += removed.count( ids.first ) + removed.count( ids.second );
+
+      if ( ids.first < n[0] && ids.second >= n[0] ) {
+        /* the reaction of species 0 and 1. */
+        removed.insert( ids.first );
+        removed.insert( ids.second );
+        ++n_reactions;
+      }
+    }
+
+    BOOST_CHECK_EQUAL( n_reused, 0u );
+    BOOST_CHECK_GT( n_reactions, 50u );
+    BOOST_CHECK_EQUAL( products.size(), 2u * n_reactions );
+    BOOST_CHECK_LT( monitor.accepted.size(), monitor.tests );
+
+    std::set<PIter> tails;
+    for ( unsigned int A = 0u; A < 2u; ++A ) {
+      const Cell::SpeciesRange & range = cell.getSpecies(A);
+      BOOST_CHECK( range.begin() == initial[A].begin() );
+
+      /* the removed particles are compacted out of the range, and the
+       * others are kept (in any order). */
+      std::set<double> expected, kept;
+      for ( unsigned int i = 0u; i < n[A]; ++i ) {
+        const double id = ( A == 0u ? 0u : n[0] ) + i;
+        if ( !removed.count( id ) )
+          expected.insert( id );
+      }
+      for ( PIter i = range.begin(); i != range.end(); ++i ) {
+        BOOST_CHECK_EQUAL( i->species, int(A) );
+        kept.insert( i->x[0] );
+      }
+
+      BOOST_CHECK_EQUAL( kept.size(), range.size() );
+      BOOST_CHECK( kept == expected );
+
+      /* the vacated positions at the end of the range are queued. */
+      for ( PIter i = range.end(); i != initial[A].end(); ++i )
+        tails.insert( i );
+    }
+
+    BOOST_CHECK_EQUAL( eq.size(), 2u * n_reactions );
+    BOOST_CHECK( eq == tails );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( Driver_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( inplace_NTC ) {
+    checkInplace( scheme::NTC() );
+  }
+
+  BOOST_AUTO_TEST_CASE( inplace_BatchedNTC ) {
+    checkInplace( scheme::BatchedNTC( 32u, 16.0 ) );
+  }
+
+  BOOST_AUTO_TEST_CASE( inplace_SBT ) {
+    checkInplace( scheme::SBT() );
+  }
+
+  BOOST_AUTO_TEST_CASE( SBT_rates_identical_species ) {
+    /* the partners of particle i are i+1 .. N-1. */
+    const double v[][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 2, 0 } };
+    std::vector<unsigned int> n( 1u, 2u );
+    checkRates( scheme::SBT(), n, makeParticles( 2u, v ), 0.2, 5000u, true );
+
+    n[0] = 3u;
+    checkRates( scheme::SBT(), n, makeParticles( 3u, v ), 0.05, 5000u, true );
+  }
+
+  BOOST_AUTO_TEST_CASE( rates_different_species ) {
+    /* two particles of species 0 and three of species 1 (of which one has a
+     * larger weight).  NTC is used as a reference. */
+    const double v[][3] = { { 0, 0, 0 }, { 1, 0, 0 },
+                            { 0, 1, 0 }, { 1, 2,-1 }, { .5,.5,.5 } };
+    std::vector<Particle> particles = makeParticles( 5u, v, 1 );
+    particles[0].species = particles[1].species = 0;
+    particles[3].weight = 2.0f;
+
+    std::vector<unsigned int> n;
+    n.push_back( 2u );
+    n.push_back( 3u );
+
+    checkRates( scheme::SBT(), n, particles, 0.01, 20000u, true, false );
+    checkRates( scheme::NTC(), n, particles, 0.01, 20000u, true, false );
+
+    /* all pairs, including those of the same species. */
+    checkRates( scheme::SBT(), n, particles, 0.01, 20000u, true );
+  }
+
+  BOOST_AUTO_TEST_CASE( SBT_rates_many_particles ) {
+    xylose::random::Kiss rng(11u);
+    std::vector<unsigned int> n;
+    n.push_back( 20u );
+    n.push_back( 15u );
+
+    std::vector<Particle> particles;
+    for ( unsigned int A = 0u; A < 2u; ++A )
+      for ( unsigned int i = 0u; i < n[A]; ++i )
+        particles.push_back(
+          Particle( V3( particles.size(), 0, 0 ),
+                    V3( rng.rand() - 0.5, rng.rand(), 2.0 * rng.rand() ),
+                    A, 1.0f + ( i % 3u == 0u ) ) );
+
+    checkRates( scheme::SBT(), n, particles, 0.002, 2000u, false );
+  }
+
+  BOOST_AUTO_TEST_CASE( max_sigma_v_updated ) {
+    /* the speeds of the tested pairs are given to MaxSigmaVProduct::update
+     * by each of the schemes. */
+    checkUpdate( scheme::NTC() );
+    checkUpdate( scheme::BatchedNTC( 16u, 8.0 ) );
+    checkUpdate( scheme::SBT() );
+  }
+
+  BOOST_AUTO_TEST_CASE( triples ) {
+    /* e + e + ion --> e + atom (species 0, 0, 2 --> 0, 1) is the only
+     * interaction, for which sigma*v = v. */
+    typedef chimp::interaction::test::MockDB<options> DB;
+    typedef chimp::interaction::test::PowerLaw<options> PowerLaw;
+    typedef chimp::interaction::model::InElastic<options> InElastic;
+    typedef chimp::interaction::Driver<Monitor> Driver;
+
+    std::vector<double> mass;
+    mass.push_back( 1.0 );
+    mass.push_back( 100.0 );
+    mass.push_back( 99.0 );
+    DB db( mass );
+
+    std::vector<double> input_mass;
+    input_mass.push_back( mass[0] );
+    input_mass.push_back( mass[0] );
+    input_mass.push_back( mass[2] );
+    std::vector<InElastic::Product> outputs;
+    outputs.push_back( InElastic::Product( 0, mass[0], 1u ) );
+    outputs.push_back( InElastic::Product( 1, mass[1], 2u ) );
+    db.addEquation( 0, 0, 2, new PowerLaw( 1.0, 1.0 ),
+                    new InElastic( input_mass, 0, -5.0, outputs ) );
+
+    std::vector<unsigned int> n;
+    n.push_back( 40u );
+    n.push_back( 0u );
+    n.push_back( 20u );
+
+    std::vector<Particle> particles;
+    makeParticles( particles, n, 7u );
+    Cell cell( particles.begin(), n );
+
+    Monitor monitor;
+    Driver driver( monitor );
+    std::vector<Particle> products;
+    xylose::random::Kiss rng(3u);
+    const unsigned int n_trials = 20u;
+    for ( unsigned int t = 0u; t < n_trials; ++t )
+      driver( 5e-4, cell, db, products, rng );
+
+    /* each trial tests the number of triples reported (rounded down). */
+    BOOST_CHECK_EQUAL( monitor.tests, 0ul );
+    BOOST_CHECK_GT( monitor.triple_tests, 1000ul );
+    BOOST_CHECK_LE( monitor.triple_tests, monitor.pairtests_sum );
+    BOOST_CHECK_GT( monitor.triple_tests, monitor.pairtests_sum - n_trials );
+
+    BOOST_CHECK_GT( monitor.triples.size(), 0u );
+    BOOST_CHECK_LT( monitor.triples.size(), monitor.triple_tests );
+    BOOST_CHECK_EQUAL( products.size(), 2u * monitor.triples.size() );
+
+    /* each interacting triple is of two electrons and one ion. */
+    for ( unsigned int k = 0u; k < monitor.triples.size(); ++k ) {
+      const chimp::interaction::Triple<double> & ids = monitor.triples[k];
+      std::multiset<int> species;
+      species.insert( particles[ids.first].species );
+      species.insert( particles[ids.second].species );
+      species.insert( particles[ids.third].species );
+      BOOST_CHECK_EQUAL( species.count(0), 2u );
+      BOOST_CHECK_EQUAL( species.count(2), 1u );
+      BOOST_CHECK_NE( ids.first, ids.second );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,263 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+
+/** \file
+ * Test file for the ParallelDriver class.
+ * */
+#define BOOST_TEST_MODULE  ParallelDriver
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/ParallelDriver.h>
+#include <chimp/interaction/Particle.h>
+#include <chimp/interaction/model/Elastic.h>
+#include <chimp/interaction/model/InElastic.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <xylose/random/Kiss.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace {
+  using chimp::interaction::Particle;
+  using chimp::interaction::ReducedMass;
+  using xylose::V3;
+
+  typedef chimp::make_options<>::type
+    ::setInplaceInteractions<false>::type options;
+  typedef chimp::interaction::test::MockDB<options> DB;
+  typedef chimp::interaction::test::MockCell<Particle> Cell;
+  typedef chimp::interaction::test::RecordingMonitor Monitor;
+  typedef chimp::interaction::test::PowerLaw<options> PowerLaw;
+  typedef chimp::interaction::model::Elastic<options> Elastic;
+  typedef chimp::interaction::model::InElastic<options> InElastic;
+  typedef chimp::interaction::ParallelDriver<Monitor> ParallelDriver;
+
+  /** Two species with elastic interactions and an excitation of the first
+   * species by the second. */
+  DB makeDB() {
+    std::vector<double> mass;
+    mass.push_back( 1.0 );
+    mass.push_back( 4.0 );
+    DB db( mass );
+
+    db.addEquation( 0, 0, new PowerLaw( 1.0, 1.0 ),
+                    new Elastic( ReducedMass( 1.0, 1.0 ) ) );
+    db.addEquation( 0, 1, new PowerLaw( 0.5, 1.5 ),
+                    new Elastic( ReducedMass( 1.0, 4.0 ) ) );
+
+    std::vector<InElastic::Product> outputs;
+    outputs.push_back( InElastic::Product( 1, 4.0, 1u ) );
+    outputs.push_back( InElastic::Product( 0, 1.0, 0u ) );
+    db.addEquation( 0, 1, new PowerLaw( 0.2, 2.0 ),
+                    new InElastic( ReducedMass( 1.0, 4.0 ), 0, 0.1,
+                                   outputs ) );
+    db.addEquation( 1, 1, new PowerLaw( 0.3, 0.5 ),
+                    new Elastic( ReducedMass( 4.0, 4.0 ) ) );
+    return db;
+  }
+
+  /** Cells of very different numbers of particles (identified by their
+   * position x[0], the index into the particles). */
+  void makeCells( std::vector<Particle> & particles,
+                  std::vector<Cell> & cells ) {
+    xylose::random::Kiss rng(7u);
+    const unsigned int n_cells = 200u;
+
+    std::vector< std::vector<unsigned int> > n( n_cells );
+    unsigned int n_total = 0u;
+    for ( unsigned int c = 0u; c < n_cells; ++c ) {
+      const unsigned int scale = ( c % 37u == 0u ) ? 120u : 10u;
+      n[c].push_back( scale + c % 13u );
+      n[c].push_back( scale / 2u + c % 7u );
+      n_total += n[c][0] + n[c][1];
+    }
+
+    particles.resize( n_total );
+    for ( unsigned int i = 0u; i < n_total; ++i ) {
+      particles[i].x = V3( i, 0, 0 );
+      particles[i].v = V3( rng.rand() - 0.5, rng.rand() - 0.5,
+                           rng.rand() - 0.5 );
+    }
+
+    cells.clear();
+    std::vector<Particle>::iterator first = particles.begin();
+    for ( unsigned int c = 0u; c < n_cells; ++c ) {
+      for ( unsigned int A = 0u; A < 2u; ++A )
+        for ( unsigned int i = 0u; i < n[c][A]; ++i )
+          (first + i + ( A ? n[c][0] : 0u ))->species = A;
+      cells.push_back( Cell( first, n[c] ) );
+      first += n[c][0] + n[c][1];
+    }
+  }
+
+  /** The products and monitor of two calls of a ParallelDriver with the
+   * given number of threads. */
+  struct Run {
+    std::vector<Particle> products;
+    Monitor monitor;
+    std::vector<double> cell_cost;
+
+    Run( const int & n_threads, const bool & balance ) {
+#ifdef _OPENMP
+      omp_set_num_threads( n_threads );
+#endif
+      const DB db = makeDB();
+      std::vector<Particle> particles;
+      std::vector<Cell> cells;
+      makeCells( particles, cells );
+
+      ParallelDriver driver( monitor, 4u, balance, 16u );
+      xylose::random::Kiss rng(1u);
+
+      /* the costs recorded by the first call are used by the second. */
+      driver( 0.2, cells.begin(), cells.end(), db, products, rng );
+      cell_cost = driver.cell_cost;
+      driver( 0.2, cells.begin(), cells.end(), db, products, rng );
+    }
+  };
+
+  /** Monitor that only counts the pairs tested, relying on MonitorBase for
+   * the other hooks. */
+  struct CountingMonitor : chimp::interaction::MonitorBase {
+    unsigned long tests;
+
+    CountingMonitor() : tests(0ul) { }
+
+    using chimp::interaction::MonitorBase::interactions;
+
+    template < typename ChimpDB,
+               typename PIter,
+               typename BackInsertionSequence >
+    void interactions( const ChimpDB & db,
+                       const std::pair<PIter, PIter> & pair,
+                       const std::pair<int,double> & path,
+                       const BackInsertionSequence & result_list ) {
+      ++tests;
+    }
+
+    void merge( const CountingMonitor & other ) {
+      tests += other.tests;
+    }
+  };
+
+  void checkSame( const Run & r1, const Run & r2 ) {
+    BOOST_CHECK_EQUAL( r1.monitor.tests, r2.monitor.tests );
+    BOOST_CHECK_EQUAL( r1.monitor.pairtests_sum, r2.monitor.pairtests_sum );
+    BOOST_CHECK( r1.monitor.accepted == r2.monitor.accepted );
+    BOOST_CHECK( r1.monitor.paths == r2.monitor.paths );
+
+    BOOST_REQUIRE_EQUAL( r1.products.size(), r2.products.size() );
+    unsigned int n_different = 0u;
+    for ( unsigned int i = 0u; i < r1.products.size(); ++i ) {
+      const Particle & p1 = r1.products[i], & p2 = r2.products[i];
+      bool same = p1.species == p2.species && p1.weight == p2.weight;
+      for ( unsigned int j = 0u; j < 3u; ++j )
+        same = same && p1.x[j] == p2.x[j] && p1.v[j] == p2.v[j];
+      if ( !same )
+        ++n_different;
+    }
+    BOOST_CHECK_EQUAL( n_different, 0u );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( ParallelDriver_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( independent_of_threads ) {
+    int n_threads = 4;
+#ifdef _OPENMP
+    n_threads = std::max( n_threads, omp_get_max_threads() );
+#endif
+
+    for ( int balance = 0; balance < 2; ++balance ) {
+      const Run serial( 1, balance );
+      const Run parallel( n_threads, balance );
+
+      BOOST_CHECK_GT( serial.monitor.accepted.size(), 1000u );
+      BOOST_CHECK_GT( serial.products.size(), 2000u );
+      checkSame( serial, parallel );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( recorded_costs ) {
+    /* the cost exported by the first pass is the same as the estimate
+     * (before any interaction changes the cells). */
+    const DB db = makeDB();
+    std::vector<Particle> particles;
+    std::vector<Cell> cells;
+    makeCells( particles, cells );
+
+    Monitor monitor;
+    ParallelDriver driver( monitor );
+    std::vector<double> estimate( cells.size() );
+    for ( unsigned int i = 0u; i < cells.size(); ++i )
+      estimate[i] = ParallelDriver::SerialDriver( monitor )
+                      .estimateCost( 0.2, cells[i], db );
+
+    std::vector<Particle> products;
+    xylose::random::Kiss rng(1u);
+    driver( 0.2, cells.begin(), cells.end(), db, products, rng );
+
+    BOOST_REQUIRE_EQUAL( driver.cell_cost.size(), cells.size() );
+    for ( unsigned int i = 0u; i < cells.size(); ++i )
+      BOOST_CHECK_CLOSE( driver.cell_cost[i], estimate[i], 1e-10 );
+
+    driver.clearCosts();
+    BOOST_CHECK( driver.cell_cost.empty() );
+  }
+
+  BOOST_AUTO_TEST_CASE( monitor_base_defaults ) {
+    /* a monitor that defines only some of the hooks. */
+    const DB db = makeDB();
+    std::vector<Particle> particles;
+    std::vector<Cell> cells;
+    makeCells( particles, cells );
+
+    CountingMonitor monitor;
+    chimp::interaction::ParallelDriver<CountingMonitor> driver( monitor );
+    std::vector<Particle> products;
+    xylose::random::Kiss rng(1u);
+    driver( 0.2, cells.begin(), cells.end(), db, products, rng );
+
+    /* the same run of the same (unchanged) cells with a full monitor. */
+    makeCells( particles, cells );
+    Monitor reference;
+    ParallelDriver ref_driver( reference );
+    std::vector<Particle> ref_products;
+    xylose::random::Kiss ref_rng(1u);
+    ref_driver( 0.2, cells.begin(), cells.end(), db, ref_products, ref_rng );
+
+    BOOST_CHECK_GT( monitor.tests, 0ul );
+    BOOST_CHECK_EQUAL( monitor.tests, reference.tests );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,202 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the PreComputedSet class.
+ * */
+#define BOOST_TEST_MODULE  PreComputedSet
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/PreComputedSet.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  typedef chimp::make_options<>::type::setInteractionSet<
+    chimp::interaction::PreComputedSet
+  >::type options;
+  typedef chimp::RuntimeDB<options> DB;
+  typedef DB::Set Set;
+
+  using chimp::interaction::test::loadXe;
+  using chimp::interaction::test::makeTableSet;
+
+  /** Cross section of equation i at v as used by the set:  interpolated
+   * within the table and evaluated directly beyond it. */
+  double setSigma( const Set & set, const unsigned int & i, const double & v ) {
+    const double x = v * set.dv_inv;
+    if ( x >= set.n_bins )
+      return (*set.rhs[i].cs)( v );
+
+    const unsigned int k = static_cast<unsigned int>( x );
+    const double sv0 = set.sigma_v[ k * set.n_eq + i ];
+    const double sv1 = set.sigma_v[ (k+1u) * set.n_eq + i ];
+    return ( sv0 + ( x - k ) * ( sv1 - sv0 ) ) / v;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( PreComputedSet_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( tables ) {
+    DB db;
+    loadXe(db);
+
+    const Set & set = db("e^-", "Xe");
+    BOOST_REQUIRE( set.rhs.size() > 1u );
+    BOOST_CHECK( set.isPrecomputed() );
+    BOOST_CHECK_EQUAL( set.n_bins, db.default_PreComputedSet_nbins );
+    BOOST_CHECK_EQUAL( set.sigma_v_total.size(), set.n_bins + 1u );
+
+    /* at each of the nodes, the tables should match the cross sections. */
+    double max_sv = 0.0;
+    for ( unsigned int k = 1u; k < set.n_bins; ++k ) {
+      const double v = k * set.dv;
+      double sv = 0.0;
+      for ( unsigned int i = 0u; i < set.rhs.size(); ++i )
+        sv += v * (*set.rhs[i].cs)(v);
+
+      max_sv = std::max( max_sv, sv );
+      BOOST_CHECK_CLOSE( set.sigma_v_total[k], sv, 1e-8 );
+      BOOST_CHECK_CLOSE( set.max_sigma_v[k], max_sv, 1e-8 );
+    }
+
+    /* beyond the table, the runtime calculation is used. */
+    typedef chimp::interaction::Set<options> BaseSet;
+    BOOST_CHECK_EQUAL(
+      set.findMaxSigmaVProduct( 2.0 * set.v_max ),
+      static_cast<const BaseSet&>(set).findMaxSigmaVProduct( 2.0 * set.v_max )
+    );
+  }
+
+  BOOST_AUTO_TEST_CASE( path_sampling ) {
+    DB db;
+    loadXe(db);
+
+    const Set & set = db("e^-", "Xe");
+    BOOST_REQUIRE( set.rhs.size() > 1u );
+
+    options::RNG rng;
+
+    /* sample at a velocity between two nodes (~50 eV). */
+    const double v = ( set.n_bins / 2u + 0.5 ) * set.dv;
+
+    std::vector<double> sigma( set.rhs.size() );
+    double sigma_tot = 0.0;
+    for ( unsigned int i = 0u; i < set.rhs.size(); ++i ) {
+      const unsigned int k = set.n_bins / 2u;
+      sigma[i] = 0.5 * ( set.sigma_v[ k    * set.n_eq + i ] +
+                         set.sigma_v[(k+1) * set.n_eq + i ] ) / v;
+      sigma_tot += sigma[i];
+    }
+    BOOST_REQUIRE( sigma_tot > 0.0 );
+
+    /* with max_sigma_relspeed == 0, every test is accepted. */
+    const unsigned int N = 200000u;
+    std::vector<unsigned int> count( set.rhs.size(), 0u );
+    for ( unsigned int n = 0u; n < N; ++n ) {
+      Set::OutPath path = set.calculateOutPath( 0.0, v, rng );
+      BOOST_REQUIRE( path.first >= 0 );
+      BOOST_REQUIRE( path.first < static_cast<int>(set.rhs.size()) );
+      BOOST_CHECK_CLOSE( path.second, sigma[path.first], 1e-8 );
+      ++count[path.first];
+    }
+
+    for ( unsigned int i = 0u; i < set.rhs.size(); ++i ) {
+      const double p = sigma[i] / sigma_tot;
+      BOOST_CHECK_SMALL( double(count[i]) / N - p,
+                         5.0 * std::sqrt( p * (1.0 - p) / N ) + 1e-12 );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( batch_out_paths ) {
+    Set set;
+    makeTableSet<options>( set );
+    set.tabulateMaxSigmaV( 4e6 );
+    set.precompute( 2e6, 200u );
+    BOOST_REQUIRE( set.isPrecomputed() );
+
+    /* speeds within and beyond the table. */
+    const unsigned int n = 200u, n_eq = set.rhs.size();
+    std::vector<double> v( n ), sigma( n * n_eq ), sigma_tot( n, 0.0 );
+    std::vector<double> scratch( ( n_eq + Set::TESTPAIRS_SCRATCH_ROWS ) * n );
+    std::vector<Set::OutPath> paths( n );
+    for ( unsigned int k = 0u; k < n; ++k ) {
+      v[k] = 1e4 * std::pow( 400.0, double(k) / (n - 1u) );
+      for ( unsigned int i = 0u; i < n_eq; ++i )
+        sigma_tot[k] += sigma[k * n_eq + i] = setSigma( set, i, v[k] );
+    }
+    BOOST_REQUIRE( v.back() > set.v_max );
+
+    options::RNG rng;
+
+    /* with max_sigma_relspeed == 0, every test is accepted.  The counts of
+     * the paths are compared with the sum of their probabilities over all
+     * of the speeds. */
+    const unsigned int N = 2000u;
+    std::vector<unsigned int> count( n_eq, 0u );
+    std::vector<double> p_sum( n_eq, 0.0 ), var( n_eq, 0.0 );
+    for ( unsigned int t = 0u; t < N; ++t ) {
+      set.testPairs( 0.0, &v[0], n, &paths[0], &scratch[0], rng );
+      for ( unsigned int k = 0u; k < n; ++k ) {
+        BOOST_REQUIRE( paths[k].first >= 0 );
+        BOOST_REQUIRE( paths[k].first < static_cast<int>(n_eq) );
+        BOOST_CHECK_CLOSE( paths[k].second,
+                           sigma[k * n_eq + paths[k].first], 1e-8 );
+        ++count[ paths[k].first ];
+      }
+    }
+
+    for ( unsigned int k = 0u; k < n; ++k )
+      for ( unsigned int i = 0u; i < n_eq; ++i ) {
+        const double p = sigma[k * n_eq + i] / sigma_tot[k];
+        p_sum[i] += N * p;
+        var[i] += N * p * ( 1.0 - p );
+      }
+
+    for ( unsigned int i = 0u; i < n_eq; ++i )
+      BOOST_CHECK_SMALL( count[i] - p_sum[i], 5.0 * std::sqrt( var[i] ) );
+
+    /* the frequency of acceptance of each speed. */
+    const double max_sigma_v = set.findMaxSigmaVProduct( 4e6 );
+    std::vector<unsigned int> accepted( n, 0u );
+    const unsigned int M = 20000u;
+    for ( unsigned int t = 0u; t < M; ++t ) {
+      set.testPairs( max_sigma_v, &v[0], n, &paths[0], &scratch[0], rng );
+      for ( unsigned int k = 0u; k < n; ++k )
+        accepted[k] += ( paths[k].first >= 0 );
+    }
+
+    for ( unsigned int k = 0u; k < n; ++k ) {
+      const double p = sigma_tot[k] * v[k] / max_sigma_v;
+      BOOST_CHECK_SMALL( double(accepted[k]) / M - p,
+                         5.0 * std::sqrt( p * ( 1.0 - p ) / M ) + 1e-12 );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,118 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the product sinks.
+ * */
+#define BOOST_TEST_MODULE  ProductSink
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/ProductSink.h>
+#include <chimp/interaction/ReducedMass.h>
+#include <chimp/interaction/model/Elastic.h>
+
+#include <xylose/random/Kiss.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+namespace {
+  using chimp::interaction::Particle;
+  using chimp::interaction::ProductSlab;
+  using xylose::V3;
+
+  typedef chimp::make_options<>::type
+    ::setInplaceInteractions<false>::type
+    ::setProductSink< chimp::interaction::SlabSink >::type options;
+
+  typedef chimp::interaction::model::Elastic<options> Elastic;
+
+  /** Reduced mass of two particles of equal (unit) mass. */
+  chimp::interaction::ReducedMass unitMass() {
+    chimp::interaction::ReducedMass mu;
+    mu.value = 0.5;
+    mu.over_m1 = mu.over_m2 = 0.5;
+    return mu;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( ProductSink_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( slab ) {
+    std::vector<Particle> storage(2);
+    ProductSlab<Particle> slab( &storage[0], storage.size() );
+
+    BOOST_CHECK( slab.empty() );
+    BOOST_CHECK_EQUAL( slab.capacity(), 2u );
+
+    slab.push_back( Particle( V3(1,2,3), V3(4,5,6), 1 ) );
+    slab.push_back( Particle( V3(1,2,3), V3(7,8,9), 2 ) );
+    BOOST_CHECK_EQUAL( slab.size(), 2u );
+    BOOST_CHECK_EQUAL( slab.back().species, 2 );
+    /* written directly into the caller's storage. */
+    BOOST_CHECK_EQUAL( storage[0].v, V3(4,5,6) );
+    BOOST_CHECK_EQUAL( &slab[1], &storage[1] );
+
+    BOOST_CHECK_THROW( slab.push_back( Particle() ), std::length_error );
+    BOOST_CHECK_THROW( slab.reserve( 3u ), std::length_error );
+
+    slab.clear();
+    BOOST_CHECK( slab.empty() );
+    BOOST_CHECK_THROW( ProductSlab<Particle>().push_back( Particle() ),
+                       std::length_error );
+  }
+
+  BOOST_AUTO_TEST_CASE( elastic_into_slab ) {
+    xylose::random::Kiss rng(1u);
+    Elastic el( unitMass() );
+
+    const Particle p0( V3(0,0,0), V3( 10,-3, 2), 0, 1.0f ),
+                   p1( V3(1,1,1), V3(-20, 4, 7), 0, 1.0f ),
+                   p2( V3(1,1,1), V3(-20, 4, 7), 0, 3.0f );
+
+    std::vector<Particle> storage(5);
+    ProductSlab<Particle> slab( &storage[0], storage.size() );
+
+    /* equal weights:  two products. */
+    el.interact( p0, p1, slab, rng );
+    BOOST_REQUIRE_EQUAL( slab.size(), 2u );
+    BOOST_CHECK_CLOSE( (storage[0].v + storage[1].v)[0],
+                       (p0.v + p1.v)[0], 1e-12 );
+    BOOST_CHECK_EQUAL( storage[1].x, p1.x );
+
+    /* unequal weights:  three products, filling the slab. */
+    el.interact( p0, p2, slab, rng );
+    BOOST_REQUIRE_EQUAL( slab.size(), 5u );
+    BOOST_CHECK_EQUAL( storage[4].weight, 2.0f );
+    BOOST_CHECK_EQUAL( storage[4].v, p2.v );
+
+    /* a full slab is not overrun. */
+    BOOST_CHECK_THROW( el.interact( p0, p1, slab, rng ), std::length_error );
+    BOOST_CHECK_EQUAL( slab.size(), 5u );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
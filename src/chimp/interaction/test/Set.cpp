@@ -0,0 +1,372 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+/** \file
+ * Test file for the interaction::Set class.
+ * */
+#define BOOST_TEST_MODULE  Set
+
+
+#include <chimp/interaction/Set.h>
+#include <chimp/interaction/cross_section/Lotz.h>
+#include <chimp/interaction/cross_section/DATA.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <physical/physical.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  typedef chimp::make_options<>::type options;
+  typedef chimp::interaction::Set<options> Set;
+  typedef chimp::interaction::cross_section::Base<options> Base;
+  typedef chimp::interaction::cross_section::Lotz<options> Lotz;
+  typedef chimp::interaction::cross_section::DATA<options> DATA;
+  using chimp::interaction::cross_section::DoubleDataSet;
+  using chimp::interaction::test::addEquation;
+  using chimp::interaction::test::newVHS;
+
+  using physical::constant::si::eV;
+  using physical::constant::si::m_e;
+
+  /** Lotz cross section of a single shell with the given binding energy. */
+  Lotz * makeLotz( const double & P, const double & q ) {
+    Lotz * lotz = new Lotz();
+    lotz->parameters.resize( 1u );
+    Lotz::Parameters & p = lotz->parameters[0];
+    p.P = P;
+    p.beta = m_e / ( 2.0 * P );
+    p.q = q;
+    p.a = 4e-18 * eV * eV; /* 4e-14 cm^2 eV^2 */
+    p.b = 0.0;
+    p.c = 0.0;
+    lotz->threshold = 1.0 / std::sqrt( p.beta );
+    return lotz;
+  }
+
+  /** Narrow gaussian peak of sigma*v without any breakpoints.  The analytic
+   * derivative keeps its sign away from the peak, such that the peak is
+   * found by tabulateMaxSigmaV. */
+  struct Peak : Base {
+    double v0, width, height;
+
+    Peak( const double & v0, const double & width, const double & height )
+      : v0(v0), width(width), height(height) { }
+
+    virtual double operator() ( const double & v ) const {
+      const double x = ( v - v0 ) / width;
+      return height * std::exp( -x * x ) / v;
+    }
+
+    virtual double dSigmaV( const double & v ) const {
+      const double x = ( v - v0 ) / width;
+      return -2.0 * x / width * height * std::exp( -x * x );
+    }
+
+    virtual bool hasExactExtrema() const { return true; }
+
+    virtual std::pair<double,double>
+    findMaxSigmaV( const double & v_rel_max ) const {
+      const double v = std::min( v0, v_rel_max );
+      return std::make_pair( v * operator()(v), v );
+    }
+
+    virtual Peak * new_load( const chimp::xml::Context & x,
+                      const chimp::interaction::Equation<options> & eq,
+                      const chimp::RuntimeDB<options> & db ) const {
+      return 0;
+    }
+
+    virtual std::string getLabel() const { return "peak"; }
+  };
+
+  /** Narrow gaussian peak of sigma*v that relies on the defaults of
+   * cross_section::Base for dSigmaV, getBreakpoints, and hasExactExtrema,
+   * as a user-registered cross section would. */
+  struct UserPeak : Base {
+    double v0, width, height;
+
+    UserPeak( const double & v0, const double & width, const double & height )
+      : v0(v0), width(width), height(height) { }
+
+    virtual double operator() ( const double & v ) const {
+      const double x = ( v - v0 ) / width;
+      return height * std::exp( -x * x ) / v;
+    }
+
+    virtual std::pair<double,double>
+    findMaxSigmaV( const double & v_rel_max ) const {
+      const double v = std::min( v0, v_rel_max );
+      return std::make_pair( v * operator()(v), v );
+    }
+
+    virtual UserPeak * new_load( const chimp::xml::Context & x,
+                          const chimp::interaction::Equation<options> & eq,
+                          const chimp::RuntimeDB<options> & db ) const {
+      return 0;
+    }
+
+    virtual std::string getLabel() const { return "user-peak"; }
+  };
+
+  /** Check findMaxSigmaVProduct against the maximum of a dense sampling of
+   * the sum of sigma*v over (0, v_max]. */
+  void checkMajorant( const Set & set,
+                      const double & v_max,
+                      const double & rel_tol ) {
+    const unsigned int n = 200000u;
+    double max_sv = 0.0;
+    for ( unsigned int k = 1u; k <= n; ++k ) {
+      const double v = v_max * k / n;
+      double sv = 0.0;
+      for ( unsigned int i = 0u; i < set.rhs.size(); ++i )
+        sv += v * (*set.rhs[i].cs)(v);
+      max_sv = std::max( max_sv, sv );
+
+      if ( k % 1000u == 0u ) {
+        const double m = set.findMaxSigmaVProduct( v );
+        BOOST_CHECK_GE( m, max_sv * ( 1.0 - 1e-12 ) );
+        BOOST_CHECK_LE( m, max_sv * ( 1.0 + rel_tol ) );
+        BOOST_CHECK_GE( set.localMaxSigmaV( v ), sv );
+      }
+    }
+  }
+
+  /** Set of n_eq tabulated cross sections, each with a single peak, and
+   * one VHS cross section. */
+  void makeDataSet( Set & set, const unsigned int & n_eq ) {
+    for ( unsigned int q = 0u; q < n_eq; ++q ) {
+      DoubleDataSet table;
+      const double E0 = 30.0 + ( q % 5u ) * 50.0;
+      for ( double E = 5.0 + 10.0 * ( q % 2u ); E < 1e3; E *= 1.15 ) {
+        const double l = std::log( E / E0 );
+        table.insert( std::make_pair( std::sqrt(E) * 1e5,
+                                      1e-20 * ( 1 + q % 3u ) * std::exp(-l*l)));
+      }
+      addEquation( set, new DATA( table ) );
+    }
+
+    addEquation( set, newVHS<options>( 1e-19, m_e ) );
+  }
+
+  /** Check the frequencies of acceptance and of each output path of
+   * calculateOutPath (or of testPairs if batch is set) against
+   * sigma_tot*v/max_sigma_v and sigma_i/sigma_tot. */
+  void checkOutPaths( const Set & set,
+                      const double & max_sigma_v,
+                      const double & v,
+                      const bool & batch = false ) {
+    const unsigned int n_eq = set.rhs.size();
+    std::vector<double> sigma( n_eq );
+    double sigma_tot = 0.0;
+    for ( unsigned int i = 0u; i < n_eq; ++i )
+      sigma_tot += sigma[i] = (*set.rhs[i].cs)( v );
+
+    options::RNG rng;
+    std::vector<unsigned int> count( n_eq, 0u );
+    unsigned int accepted = 0u;
+    const unsigned int N = 400000u;
+    /* The batches alternate between v and other speeds such that the pairs
+     * that are kept after the early rejection are not contiguous. */
+    const unsigned int n_batch = 64u;
+    std::vector<double> v_batch( n_batch ), scratch;
+    std::vector<Set::OutPath> paths( n_batch );
+    for ( unsigned int k = 0u; k < n_batch; ++k )
+      v_batch[k] = ( k % 2u == 0u ? v : v * ( 0.25 + 0.01 * k ) );
+    scratch.resize( ( n_eq + Set::TESTPAIRS_SCRATCH_ROWS ) * n_batch );
+
+    for ( unsigned int k = 0u; k < N; ++k ) {
+      Set::OutPath path;
+      if ( !batch )
+        path = set.calculateOutPath( max_sigma_v, v, rng );
+      else {
+        const unsigned int b = ( 2u * k ) % n_batch;
+        if ( b == 0u )
+          set.testPairs( max_sigma_v, &v_batch[0], n_batch, &paths[0],
+                         &scratch[0], rng );
+        path = paths[b];
+      }
+
+      if ( path.first < 0 )
+        continue;
+
+      BOOST_REQUIRE_LT( path.first, int(n_eq) );
+      if ( !batch )
+        BOOST_CHECK_EQUAL( path.second, sigma[path.first] );
+      else /* (the batch evaluation may differ by round-off) */
+        BOOST_CHECK_CLOSE( path.second, sigma[path.first], 1e-10 );
+      ++accepted;
+      ++count[path.first];
+    }
+
+    /* 5 standard deviations */
+    const double p_acc = sigma_tot * v / max_sigma_v;
+    BOOST_CHECK_SMALL( double(accepted) / N - p_acc,
+                       5.0 * std::sqrt( p_acc * ( 1.0 - p_acc ) / N ) );
+
+    BOOST_REQUIRE( accepted > 0u );
+    for ( unsigned int i = 0u; i < n_eq; ++i ) {
+      const double p = sigma[i] / sigma_tot;
+      BOOST_CHECK_SMALL( double(count[i]) / accepted - p,
+                         5.0 * std::sqrt( p * ( 1.0 - p ) / accepted )
+                         + 1e-12 );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( Set_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( max_sigma_v_close_lotz_peaks ) {
+    /* The peaks of v*sigma of the two shells are closer together than the
+     * spacing of the samples of tabulateMaxSigmaV. */
+    Set set;
+    addEquation( set, makeLotz( 10.0 * eV, 2.0 ) );
+    addEquation( set, makeLotz( 11.0 * eV, 1.0 ) );
+
+    const double v_max = std::sqrt( 2.0 * 1000.0 * eV / m_e );
+    const double v_peak0 = std::sqrt( 2.0 * 10.0 * eV * M_E * M_E / m_e );
+    const double v_peak1 = std::sqrt( 2.0 * 11.0 * eV * M_E * M_E / m_e );
+    BOOST_REQUIRE_LT( v_peak1 - v_peak0, v_max / 16.0 );
+
+    set.tabulateMaxSigmaV( v_max );
+    checkMajorant( set, v_max, 2e-3 );
+  }
+
+  BOOST_AUTO_TEST_CASE( max_sigma_v_narrow_peaks ) {
+    /* Two narrow peaks within one sample spacing on top of a rising
+     * background:  the derivative of the sum has the same sign at all of the
+     * samples, so the maxima can only be found from the single terms. */
+    Set set;
+    addEquation( set, new Peak( 400.0, 2.0, 1.0 ) );
+    addEquation( set, new Peak( 410.0, 2.0, 1.5 ) );
+    addEquation( set, new Peak( 1e4,  4e3, 10.0 ) );
+
+    set.tabulateMaxSigmaV( 1000.0 );
+    checkMajorant( set, 1000.0, 2e-3 );
+  }
+
+  BOOST_AUTO_TEST_CASE( max_sigma_v_user_narrow_peak ) {
+    /* The central difference of the default dSigmaV is zero at all of the
+     * samples of tabulateMaxSigmaV, such that the table misses the peak. */
+    const double v_max = 3e6;
+    const double v0 = 0.53 * v_max;
+    Set set;
+    makeDataSet( set, 3u );
+    addEquation( set, new UserPeak( v0, 1e-4 * v_max, 5.3e-15 ) );
+    set.tabulateMaxSigmaV( v_max );
+
+    double sv0 = 0.0;
+    for ( unsigned int i = 0u; i < set.rhs.size(); ++i )
+      sv0 += v0 * (*set.rhs[i].cs)(v0);
+    BOOST_CHECK_GE( set.findMaxSigmaVProduct( v_max ), sv0 );
+    BOOST_CHECK_GE( set.findMaxSigmaVProduct( v0 ), sv0 );
+
+    /* no early rejection for this set. */
+    BOOST_CHECK( !( set.localMaxSigmaV( v0 ) < 1e300 ) );
+    checkOutPaths( set, set.findMaxSigmaVProduct( v_max ), v0 );
+    checkOutPaths( set, set.findMaxSigmaVProduct( v_max ), v0, true );
+  }
+
+  BOOST_AUTO_TEST_CASE( max_sigma_v_below_v_min ) {
+    /* The tabulated range starts at 1e-9 * v_max.  Below, the maxima of the
+     * single cross sections are used. */
+    const double v_max = 1000.0;
+    Set set;
+    addEquation( set, new Peak( 5e-8, 1e-8, 1.0 ) );
+    addEquation( set, new Peak( 400.0, 2.0, 1.0 ) );
+    set.tabulateMaxSigmaV( v_max );
+
+    const double v[] = { 2e-8, 5e-8, 1e-6, 1e-3 };
+    for ( unsigned int k = 0u; k < 4u; ++k ) {
+      double sv = 0.0;
+      for ( unsigned int i = 0u; i < set.rhs.size(); ++i )
+        sv += v[k] * (*set.rhs[i].cs)(v[k]);
+      BOOST_CHECK_GE( set.findMaxSigmaVProduct( v[k] ), sv );
+      BOOST_CHECK_GE( set.localMaxSigmaV( v[k] ), sv );
+    }
+    BOOST_CHECK_GE( set.findMaxSigmaVProduct( 1e-3 ), 1.0 );
+  }
+
+  BOOST_AUTO_TEST_CASE( out_path_frequencies ) {
+    /* the small set buffers the cross sections, the large set evaluates
+     * them again for the path selection. */
+    const unsigned int n_eqs[] = { 3u, Set::OUTPATH_BUFFER_SIZE + 8u };
+    const double v[] = { 3e5, 1e6, 2.5e6 };
+    const double v_max = 3e6;
+
+    for ( unsigned int j = 0u; j < 2u; ++j ) {
+      /* the plain set does not reject tests early. */
+      Set plain, set;
+      makeDataSet( plain, n_eqs[j] );
+      makeDataSet( set, n_eqs[j] );
+      set.tabulateMaxSigmaV( v_max );
+      BOOST_CHECK( set.localMaxSigmaV( v[0] ) < 1e300 );
+      BOOST_CHECK( !( plain.localMaxSigmaV( v[0] ) < 1e300 ) );
+
+      const double max_sigma_v = set.findMaxSigmaVProduct( v_max );
+      for ( unsigned int k = 0u; k < 3u; ++k ) {
+        checkOutPaths( plain, max_sigma_v, v[k] );
+        checkOutPaths( set, max_sigma_v, v[k] );
+      }
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( batch_out_path_frequencies ) {
+    /* testPairs rejects early with the bound of localMaxSigmaV before the
+     * batch evaluation of the remaining pairs. */
+    const double v[] = { 3e5, 1e6, 2.5e6 };
+    const double v_max = 3e6;
+
+    Set plain, set;
+    makeDataSet( plain, 5u );
+    makeDataSet( set, 5u );
+    set.tabulateMaxSigmaV( v_max );
+
+    const double max_sigma_v = set.findMaxSigmaVProduct( v_max );
+    for ( unsigned int k = 0u; k < 3u; ++k ) {
+      checkOutPaths( plain, max_sigma_v, v[k], true );
+      checkOutPaths( set, max_sigma_v, v[k], true );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( out_path_frequencies_narrow_peaks ) {
+    /* early rejection near maxima of the sum that lie between the
+     * samples of tabulateMaxSigmaV. */
+    Set set;
+    addEquation( set, new Peak( 400.0, 2.0, 1.0 ) );
+    addEquation( set, new Peak( 410.0, 2.0, 1.5 ) );
+    addEquation( set, new Peak( 1e4,  4e3, 10.0 ) );
+    set.tabulateMaxSigmaV( 1000.0 );
+
+    const double max_sigma_v = set.findMaxSigmaVProduct( 1000.0 );
+    for ( double v = 396.0; v < 414.0; v += 1.7 )
+      checkOutPaths( set, max_sigma_v, v );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,141 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the SharedGridSet class.
+ * */
+#define BOOST_TEST_MODULE  SharedGridSet
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/SharedGridSet.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace {
+  typedef chimp::make_options<>::type::setInteractionSet<
+    chimp::interaction::SharedGridSet
+  >::type options;
+  typedef chimp::RuntimeDB<options> DB;
+  typedef DB::Set Set;
+
+  using chimp::interaction::test::loadXe;
+  using chimp::interaction::test::makeTableSet;
+}
+
+BOOST_AUTO_TEST_SUITE( SharedGridSet_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( common_grid ) {
+    DB db;
+    loadXe(db);
+
+    const Set & set = db("e^-", "Xe");
+    BOOST_REQUIRE( set.rhs.size() > 1u );
+    BOOST_REQUIRE( set.isShared() );
+    BOOST_CHECK( set.grid_index.size() > 0u );
+    BOOST_CHECK_EQUAL( set.coeffs.size(),
+                       2u * set.grid_index.size() * (set.grid.size() - 1u) );
+
+    options::RNG rng;
+
+    /* with max_sigma_relspeed == 0, every test is accepted and the returned
+     * cross section must match the direct evaluation of the chosen path. */
+    for ( unsigned int k = 0u; k + 1u < set.grid.size(); ++k ) {
+      for ( unsigned int m = 1u; m <= 4u; ++m ) {
+        const double v = set.grid[k] + 0.25 * m * (set.grid[k+1] - set.grid[k]);
+        Set::OutPath path = set.calculateOutPath( 0.0, v, rng );
+        if ( path.first < 0 )
+          continue; /* all cross sections are zero here. */
+
+        BOOST_REQUIRE( path.first < static_cast<int>(set.rhs.size()) );
+        const double sigma = (*set.rhs[path.first].cs)(v);
+        BOOST_CHECK_CLOSE( path.second, sigma, 1e-6 );
+      }
+    }
+
+    /* beyond the grid, the runtime calculation is used. */
+    const double v = 2.0 * set.grid.back();
+    Set::OutPath path = set.calculateOutPath( 0.0, v, rng );
+    BOOST_REQUIRE( path.first >= 0 );
+    BOOST_CHECK_EQUAL( path.second, (*set.rhs[path.first].cs)(v) );
+  }
+
+  BOOST_AUTO_TEST_CASE( batch_out_paths ) {
+    Set set;
+    makeTableSet<options>( set );
+    const double v_max = 4e6;
+    set.tabulateMaxSigmaV( v_max );
+    set.share();
+    BOOST_REQUIRE( set.isShared() );
+    BOOST_REQUIRE_EQUAL( set.grid_index.size(), 3u );
+
+    /* speeds below, within, and beyond the common grid. */
+    const unsigned int n = 200u, n_eq = set.rhs.size();
+    std::vector<double> v( n ), sigma_tot( n, 0.0 );
+    std::vector<double> scratch( ( n_eq + Set::TESTPAIRS_SCRATCH_ROWS ) * n );
+    std::vector<Set::OutPath> paths( n );
+    for ( unsigned int k = 0u; k < n; ++k ) {
+      v[k] = 1e4 * std::pow( v_max / 1e4, double(k) / (n - 1u) );
+      for ( unsigned int i = 0u; i < n_eq; ++i )
+        sigma_tot[k] += (*set.rhs[i].cs)( v[k] );
+    }
+    BOOST_REQUIRE( v.front() < set.grid.front() );
+    BOOST_REQUIRE( v.back() > set.grid.back() );
+
+    options::RNG rng;
+
+    /* with max_sigma_relspeed == 0, every test is accepted and the returned
+     * cross section must match the direct evaluation of the chosen path. */
+    for ( unsigned int t = 0u; t < 20u; ++t ) {
+      set.testPairs( 0.0, &v[0], n, &paths[0], &scratch[0], rng );
+      for ( unsigned int k = 0u; k < n; ++k ) {
+        BOOST_REQUIRE( paths[k].first >= 0 );
+        BOOST_REQUIRE( paths[k].first < static_cast<int>(n_eq) );
+        const double sigma = (*set.rhs[paths[k].first].cs)( v[k] );
+        BOOST_CHECK_CLOSE( paths[k].second, sigma, 1e-6 );
+      }
+    }
+
+    /* the frequency of acceptance, including the early rejection. */
+    const double max_sigma_v = set.findMaxSigmaVProduct( v_max );
+    std::vector<unsigned int> accepted( n, 0u );
+    const unsigned int N = 20000u;
+    for ( unsigned int t = 0u; t < N; ++t ) {
+      set.testPairs( max_sigma_v, &v[0], n, &paths[0], &scratch[0], rng );
+      for ( unsigned int k = 0u; k < n; ++k )
+        accepted[k] += ( paths[k].first >= 0 );
+    }
+
+    for ( unsigned int k = 0u; k < n; ++k ) {
+      const double p = sigma_tot[k] * v[k] / max_sigma_v;
+      BOOST_CHECK_SMALL( double(accepted[k]) / N - p,
+                         5.0 * std::sqrt( p * ( 1.0 - p ) / N ) + 1e-12 );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,267 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+/** \file
+ * Test file for the StatisticsMonitor class.
+ * */
+#define BOOST_TEST_MODULE  StatisticsMonitor
+
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/make_options.h>
+#include <chimp/interaction/StatisticsMonitor.h>
+#include <chimp/interaction/Particle.h>
+#include <chimp/interaction/Triple.h>
+#include <chimp/interaction/test/fixtures.h>
+
+#include <xylose/Vector.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace {
+  using chimp::interaction::Particle;
+  using xylose::V3;
+
+  typedef chimp::make_options<>::type options;
+  typedef chimp::interaction::test::MockDB<options> DB;
+  typedef chimp::interaction::test::PowerLaw<options> PowerLaw;
+  typedef chimp::interaction::test::Null<options> Null;
+  typedef chimp::interaction::StatisticsMonitor<> Monitor;
+  typedef std::vector<Particle>::iterator PIter;
+
+  /** Species named such that the CSV and JSON fields need quoting, with two
+   * equations for species 0 and 1, one for species 0, 0, and 1, and none
+   * for the others. */
+  DB makeDB() {
+    std::vector<double> mass( 3u, 1.0 );
+    DB db( mass );
+    db.props[0].chimp::property::name::value = "e";
+    db.props[1].chimp::property::name::value = "Xe, excited";
+    db.props[2].chimp::property::name::value = "Q\"";
+    db.addEquation( 0u, 1u, new PowerLaw( 1.0, 1.0 ), new Null );
+    db.addEquation( 0u, 1u, new PowerLaw( 2.0, 1.0 ), new Null );
+    db.addEquation( 0u, 0u, 1u, new PowerLaw( 3.0, 1.0 ), new Null );
+    return db;
+  }
+
+  /** Report n tests of the pair of species A and B with the given path. */
+  void record( Monitor & monitor, const DB & db,
+               const int & A, const int & B,
+               const int & path, const unsigned int & n ) {
+    std::vector<Particle> p;
+    p.push_back( Particle( 0.0, V3(0,0,0), A, 1.0f ) );
+    p.push_back( Particle( 0.0, V3(0,0,0), B, 1.0f ) );
+    const std::pair<PIter,PIter> pair( p.begin(), p.begin() + 1 );
+    const std::vector<Particle> products;
+    for ( unsigned int k = 0u; k < n; ++k )
+      monitor.interactions( db, pair, std::make_pair(path, 1.0), products );
+  }
+
+  /** Report n tests of the triple of species A, B, and C with the given
+   * path. */
+  void record( Monitor & monitor, const DB & db,
+               const int & A, const int & B, const int & C,
+               const int & path, const unsigned int & n ) {
+    std::vector<Particle> p;
+    p.push_back( Particle( 0.0, V3(0,0,0), A, 1.0f ) );
+    p.push_back( Particle( 0.0, V3(0,0,0), B, 1.0f ) );
+    p.push_back( Particle( 0.0, V3(0,0,0), C, 1.0f ) );
+    const chimp::interaction::Triple<PIter> triple( p.begin(), p.begin() + 1,
+                                                    p.begin() + 2 );
+    const std::vector<Particle> products;
+    for ( unsigned int k = 0u; k < n; ++k )
+      monitor.interactions( db, triple, std::make_pair(path, 1.0), products );
+  }
+
+  /** Printed form of equation i of species 0 and 1. */
+  std::string equation( const DB & db, const unsigned int & i ) {
+    std::ostringstream out;
+    db(0,1).rhs[i].print( out, db );
+    return out.str();
+  }
+
+  /** Printed form of the equation of species 0, 0, and 1. */
+  std::string tripleEquation( const DB & db ) {
+    std::ostringstream out;
+    db.getTernaryInteractions().begin()->second.rhs[0].print( out, db );
+    return out.str();
+  }
+
+  /** Two monitors:  the first of species 0 and 1 and of the triple 0, 0,
+   * and 1 and the second also of species 1 and 2 and of the triple 1, 2,
+   * and 2, merged into the first. */
+  void makeMerged( Monitor & m1, const DB & db ) {
+    record( m1, db, 0, 1, -1, 3u );
+    record( m1, db, 1, 0,  0, 2u );
+    record( m1, db, 0, 1,  1, 1u );
+    record( m1, db, 1, 0, 0, -1, 2u );
+    record( m1, db, 0, 1, 0,  0, 1u );
+    m1.pairtests( 5.5 );
+
+    Monitor m2;
+    record( m2, db, 0, 1,  1, 1u );
+    record( m2, db, 2, 1,  0, 2u );
+    record( m2, db, 0, 0, 1,  0, 1u );
+    record( m2, db, 2, 1, 2, -1, 1u );
+    m2.pairtests( 2.0 );
+
+    m1.merge( m2 );
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( StatisticsMonitor_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( merge ) {
+    const DB db = makeDB();
+    Monitor m;
+    makeMerged( m, db );
+
+    BOOST_CHECK_EQUAL( m.planned_tests, 7.5 );
+
+    const Monitor::PairStatistics s01 = m.get(1,0);
+    BOOST_CHECK_EQUAL( s01.tests, 7ul );
+    BOOST_CHECK_EQUAL( s01.accepted, 4ul );
+    BOOST_REQUIRE_EQUAL( s01.paths.size(), 2u );
+    BOOST_CHECK_EQUAL( s01.paths[0], 2ul );
+    BOOST_CHECK_EQUAL( s01.paths[1], 2ul );
+
+    const Monitor::PairStatistics s12 = m.get(1,2);
+    BOOST_CHECK_EQUAL( s12.tests, 2ul );
+    BOOST_CHECK_EQUAL( s12.accepted, 2ul );
+    BOOST_REQUIRE_EQUAL( s12.paths.size(), 1u );
+    BOOST_CHECK_EQUAL( s12.paths[0], 2ul );
+
+    BOOST_CHECK_EQUAL( m.get(0,0).tests, 0ul );
+    BOOST_CHECK_EQUAL( m.get(2,2).tests, 0ul );
+    BOOST_CHECK_EQUAL( m.get(5,1).tests, 0ul );
+
+    /* the triples are kept apart from the pairs. */
+    const Monitor::PairStatistics s001 = m.get(1,0,0);
+    BOOST_CHECK_EQUAL( s001.tests, 4ul );
+    BOOST_CHECK_EQUAL( s001.accepted, 2ul );
+    BOOST_REQUIRE_EQUAL( s001.paths.size(), 1u );
+    BOOST_CHECK_EQUAL( s001.paths[0], 2ul );
+
+    const Monitor::PairStatistics s122 = m.get(2,2,1);
+    BOOST_CHECK_EQUAL( s122.tests, 1ul );
+    BOOST_CHECK_EQUAL( s122.accepted, 0ul );
+
+    BOOST_CHECK_EQUAL( m.get(0,1,2).tests, 0ul );
+  }
+
+  BOOST_AUTO_TEST_CASE( csv ) {
+    const DB db = makeDB();
+    Monitor m;
+    makeMerged( m, db );
+
+    std::ostringstream out;
+    Monitor::writeCSVHeader( out );
+    m.writeCSV( out, db, "step \"1\"" );
+
+    const std::string label = "\"step \"\"1\"\"\",";
+    const std::string pair01 = label + "\"e\",\"Xe, excited\",\"\",";
+    const std::string pair12 = label + "\"Xe, excited\",\"Q\"\"\",\"\",";
+    const std::string triple001 =
+      label + "\"e\",\"e\",\"Xe, excited\",";
+    const std::string triple122 =
+      label + "\"Xe, excited\",\"Q\"\"\",\"Q\"\"\",";
+    BOOST_CHECK_EQUAL( out.str(),
+      "label,A,B,C,equation,tests,accepted,cycles\n"
+      + pair01 + "\"all\",7,4,0\n"
+      + pair01 + '"' + equation(db,0) + "\",7,2,\n"
+      + pair01 + '"' + equation(db,1) + "\",7,2,\n"
+      + pair12 + "\"all\",2,2,0\n"
+      + pair12 + "\"#0\",2,2,\n"
+      + triple001 + "\"all\",4,2,0\n"
+      + triple001 + '"' + tripleEquation(db) + "\",4,2,\n"
+      + triple122 + "\"all\",1,0,0\n" );
+  }
+
+  BOOST_AUTO_TEST_CASE( json ) {
+    const DB db = makeDB();
+    Monitor m;
+    makeMerged( m, db );
+
+    std::ostringstream out;
+    m.writeJSON( out, db, "step \"1\"" );
+
+    BOOST_CHECK_EQUAL( out.str(),
+      "{\"label\": \"step \\\"1\\\"\", \"planned_tests\": 7.5, \"pairs\": ["
+      "\n  {\"A\": \"e\", \"B\": \"Xe, excited\", \"tests\": 7, "
+      "\"accepted\": 4, \"cycles\": 0, \"equations\": ["
+      "{\"equation\": \"" + equation(db,0) + "\", \"selected\": 2}, "
+      "{\"equation\": \"" + equation(db,1) + "\", \"selected\": 2}]},"
+      "\n  {\"A\": \"Xe, excited\", \"B\": \"Q\\\"\", \"tests\": 2, "
+      "\"accepted\": 2, \"cycles\": 0, \"equations\": ["
+      "{\"equation\": \"#0\", \"selected\": 2}]}"
+      "\n], \"triples\": ["
+      "\n  {\"A\": \"e\", \"B\": \"e\", \"C\": \"Xe, excited\", "
+      "\"tests\": 4, \"accepted\": 2, \"cycles\": 0, \"equations\": ["
+      "{\"equation\": \"" + tripleEquation(db) + "\", \"selected\": 2}]},"
+      "\n  {\"A\": \"Xe, excited\", \"B\": \"Q\\\"\", "
+      "\"C\": \"Q\\\"\", \"tests\": 1, \"accepted\": 0, "
+      "\"cycles\": 0, \"equations\": []}"
+      "\n]}\n" );
+  }
+
+  BOOST_AUTO_TEST_CASE( reset ) {
+    const DB db = makeDB();
+    Monitor m;
+    makeMerged( m, db );
+    m.reset();
+
+    BOOST_CHECK_EQUAL( m.planned_tests, 0.0 );
+    BOOST_CHECK_EQUAL( m.get(0,1).tests, 0ul );
+    BOOST_CHECK_EQUAL( m.get(1,2).accepted, 0ul );
+    BOOST_CHECK_EQUAL( m.get(0,0,1).tests, 0ul );
+
+    std::ostringstream csv, json;
+    m.writeCSV( csv, db, "x" );
+    m.writeJSON( json, db, "x" );
+    BOOST_CHECK_EQUAL( csv.str(), "" );
+    BOOST_CHECK_EQUAL( json.str(),
+                       "{\"label\": \"x\", \"planned_tests\": 0, "
+                       "\"pairs\": [\n], \"triples\": [\n]}\n" );
+
+    /* the statistics are collected again after the reset. */
+    record( m, db, 0, 1, 1, 1u );
+    BOOST_CHECK_EQUAL( m.get(0,1).paths.at(1), 1ul );
+  }
+
+  BOOST_AUTO_TEST_CASE( timing ) {
+    chimp::interaction::StatisticsMonitor<true> m;
+    m.beginPairType( 0u, 1u );
+    volatile double x = 0.0;
+    for ( int i = 0; i < 1000; ++i )
+      x = x + i;
+    m.endPairType( 1u, 0u );
+    BOOST_CHECK_GT( m.get(0,1).cycles, 0.0 );
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
@@ -0,0 +1,160 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+/** \file
+ * Test file for the selector::SubCell class.
+ * */
+#define BOOST_TEST_MODULE  SubCell
+
+
+#include <chimp/interaction/Particle.h>
+#include <chimp/interaction/selector/SubCell.h>
+
+#include <xylose/random/Kiss.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <limits>
+
+namespace {
+  using chimp::interaction::Particle;
+  using xylose::V3;
+  typedef std::vector<Particle>::iterator PIter;
+
+  /** Minimal species range. */
+  struct Range {
+    typedef PIter iterator;
+    PIter b, e;
+    Range( const PIter & b, const PIter & e ) : b(b), e(e) { }
+    PIter begin() const { return b; }
+    PIter end() const { return e; }
+    unsigned int size() const { return e - b; }
+  };
+
+  /** Minimal cell of species ranges. */
+  struct Cell {
+    std::vector<Range> species;
+    Range & getSpecies( const unsigned int & i ) { return species[i]; }
+  };
+
+  /** Two clusters of particles, one around the origin and one around
+   * (100,0,0). */
+  std::vector<Particle> clusters( const unsigned int & n,
+                                  xylose::random::Kiss & rng ) {
+    std::vector<Particle> p( n );
+    for ( unsigned int i = 0u; i < n; ++i )
+      p[i].x = V3( 100.0 * (i % 2) + rng.rand(), rng.rand(), rng.rand() );
+    return p;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( SubCell_tests ); // {
+
+  BOOST_AUTO_TEST_CASE( same_subcell ) {
+    xylose::random::Kiss rng;
+    std::vector<Particle> p = clusters( 200u, rng );
+    Cell cell;
+    cell.species.push_back( Range( p.begin(), p.end() ) );
+
+    chimp::interaction::selector::SubCell select( 20.0 );
+    select.prepare( cell, 0u, 0u );
+
+    for ( int i = 0; i < 1000; ++i ) {
+      std::pair<PIter,PIter> pair =
+        select( cell.getSpecies(0), cell.getSpecies(0), rng );
+      BOOST_CHECK( pair.first != pair.second );
+      /* both particles must come from the same cluster. */
+      BOOST_CHECK_EQUAL( (pair.first - p.begin()) % 2,
+                         (pair.second - p.begin()) % 2 );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( different_species ) {
+    xylose::random::Kiss rng;
+    std::vector<Particle> p = clusters( 220u, rng );
+    /* species 0 only in the first cluster. */
+    for ( unsigned int i = 0u; i < 20u; ++i )
+      p[i].x[0] = rng.rand();
+
+    Cell cell;
+    cell.species.push_back( Range( p.begin(), p.begin() + 20 ) );
+    cell.species.push_back( Range( p.begin() + 20, p.end() ) );
+
+    chimp::interaction::selector::SubCell select( 20.0 );
+    select.prepare( cell, 0u, 1u );
+
+    for ( int i = 0; i < 1000; ++i ) {
+      std::pair<PIter,PIter> pair =
+        select( cell.getSpecies(0), cell.getSpecies(1), rng );
+      BOOST_CHECK_LT( pair.first  - p.begin(), 20 );
+      BOOST_CHECK_GE( pair.second - p.begin(), 20 );
+      BOOST_CHECK_LT( pair.second->x[0], 50.0 );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( nearest_neighbor ) {
+    xylose::random::Kiss rng;
+    std::vector<Particle> p = clusters( 50u, rng );
+    Cell cell;
+    cell.species.push_back( Range( p.begin(), p.end() ) );
+
+    /* a single sub-cell:  the partner is the nearest of all particles. */
+    chimp::interaction::selector::SubCell select( 1000.0, true );
+    select.prepare( cell, 0u, 0u );
+
+    for ( int i = 0; i < 200; ++i ) {
+      std::pair<PIter,PIter> pair =
+        select( cell.getSpecies(0), cell.getSpecies(0), rng );
+
+      double r_min = std::numeric_limits<double>::infinity();
+      for ( PIter j = p.begin(); j != p.end(); ++j )
+        if ( j != pair.first )
+          r_min = std::min( r_min, (j->x - pair.first->x).abs() );
+
+      BOOST_CHECK_EQUAL( (pair.second->x - pair.first->x).abs(), r_min );
+    }
+  }
+
+  BOOST_AUTO_TEST_CASE( resort_on_removal ) {
+    xylose::random::Kiss rng;
+    std::vector<Particle> p = clusters( 40u, rng );
+    Cell cell;
+    cell.species.push_back( Range( p.begin(), p.end() ) );
+
+    chimp::interaction::selector::SubCell select( 10.0 );
+    select.prepare( cell, 0u, 0u );
+
+    /* shrink the range as in-place interactions do. */
+    cell.species[0] = Range( p.begin(), p.begin() + 30 );
+
+    for ( int i = 0; i < 1000; ++i ) {
+      std::pair<PIter,PIter> pair =
+        select( cell.getSpecies(0), cell.getSpecies(0), rng );
+      BOOST_CHECK_LT( pair.first  - p.begin(), 30 );
+      BOOST_CHECK_LT( pair.second - p.begin(), 30 );
+      BOOST_CHECK( pair.first != pair.second );
+    }
+  }
+
+BOOST_AUTO_TEST_SUITE_END(); // }
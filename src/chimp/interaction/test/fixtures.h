@@ -0,0 +1,399 @@
+/*==============================================================================
+ * Public Domain Contributions 2009 United States Government                   *
+ * as represented by the U.S. Air Force Research Laboratory.                   *
+ * Copyright (C) 2006, 2008 Spencer E. Olson                                   *
+ *                                                                             *
+ * This file is part of CHIMP                                                  *
+ *                                                                             *
+ * This program is free software: you can redistribute it and/or modify it     *
+ * under the terms of the GNU Lesser General Public License as published by    *
+ * the Free Software Foundation, either version 3 of the License, or (at your  *
+ * option) any later version.                                                  *
+ *                                                                             *
+ * This program is distributed in the hope that it will be useful, but WITHOUT *
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public        *
+ * License for more details.                                                   *
+ *                                                                             *
+ * You should have received a copy of the GNU Lesser General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.       *
+ *                                                                             *
+ -----------------------------------------------------------------------------*/
+
+
+
+
+/** \file
+ * Mock database, cell, monitor, cross section, and interaction model used
+ * by the tests of the drivers and schemes, and helpers to build the sets of
+ * equations used by the tests of the Set classes.
+ * */
+
+#ifndef chimp_interaction_test_fixtures_h
+#define chimp_interaction_test_fixtures_h
+
+#include <chimp/RuntimeDB.h>
+#include <chimp/interaction/Set.h>
+#include <chimp/interaction/Input.h>
+#include <chimp/interaction/Term.h>
+#include <chimp/interaction/Triple.h>
+#include <chimp/interaction/Equation.h>
+#include <chimp/interaction/ReducedMass.h>
+#include <chimp/interaction/cross_section/Base.h>
+#include <chimp/interaction/cross_section/VHS.h>
+#include <chimp/interaction/cross_section/DATA.h>
+#include <chimp/interaction/filter/Null.h>
+#include <chimp/interaction/model/Base.h>
+#include <chimp/property/mass.h>
+#include <chimp/accessors.h>
+
+#include <xylose/Vector.h>
+#include <xylose/IteratorRange.h>
+#include <xylose/upper_triangle.h>
+
+#include <physical/physical.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace chimp {
+  namespace interaction {
+    namespace test {
+
+      /** Cross section for which sigma*v = c * v^p. */
+      template < typename options >
+      struct PowerLaw : cross_section::Base<options> {
+        double c, p;
+
+        PowerLaw( const double & c, const double & p ) : c(c), p(p) { }
+
+        virtual double operator() ( const double & v ) const {
+          return c * std::pow( v, p - 1.0 );
+        }
+
+        virtual std::pair<double,double>
+        findMaxSigmaV( const double & v_rel_max ) const {
+          return std::make_pair( c * std::pow( v_rel_max, p ), v_rel_max );
+        }
+
+        virtual PowerLaw * new_load( const xml::Context & x,
+                                     const Equation<options> & eq,
+                                     const RuntimeDB<options> & db ) const {
+          return 0;
+        }
+
+        virtual std::string getLabel() const { return "power-law"; }
+      };
+
+      /** VHS cross section (T_ref = 273 K and a viscosity temperature law of
+       * 0.8) with the given reference cross section and reduced mass. */
+      template < typename options >
+      cross_section::VHS<options> * newVHS( const double & cross_section,
+                                            const double & mu ) {
+        cross_section::detail::VHSInfo info;
+        info.cross_section = cross_section;
+        info.T_ref = 273.0;
+        info.visc_T_law = 0.8;
+        info.compute_gamma_visc_inv();
+        ReducedMass rm;
+        rm.value = mu;
+        return new cross_section::VHS<options>( info, rm );
+      }
+
+      /** Append an equation with the given cross section (and no interaction
+       * model) to the set. */
+      template < typename SetT, typename CS >
+      void addEquation( SetT & set, CS * cs ) {
+        typename SetT::Equation eq;
+        eq.cs.reset( cs );
+        set.rhs.push_back( eq );
+      }
+
+      /** Fill the set with one VHS cross section and three tabulated cross
+       * sections with different knots and peaks. */
+      template < typename options, typename SetT >
+      void makeTableSet( SetT & set ) {
+        using physical::constant::si::m_e;
+        addEquation( set, newVHS<options>( 1e-20, m_e ) );
+
+        for ( unsigned int q = 0u; q < 3u; ++q ) {
+          cross_section::DoubleDataSet table;
+          const double E0 = 30.0 + q * 50.0;
+          for ( double E = 5.0 + 3.0 * q; E < 1e3; E *= 1.15 + 0.05 * q ) {
+            const double l = std::log( E / E0 );
+            table.insert( std::make_pair(
+              std::sqrt(E) * 1e5, 1e-20 * ( 1 + q ) * std::exp(-l*l) ) );
+          }
+          addEquation( set, new cross_section::DATA<options>( table ) );
+        }
+      }
+
+      /** Add the species of the xenon data to the database and load all of
+       * their binary interactions. */
+      template < typename DB >
+      void loadXe( DB & db ) {
+        db.addParticleType("e^-");
+        db.addParticleType("Xe");
+        db.addParticleType("Xe^+");
+        db.addParticleType("Xe(1s5)");
+        db.addParticleType("Xe(1s4)");
+
+        db.filter.reset( new filter::Null );
+        db.initBinaryInteractions();
+      }
+
+
+      /** Interaction model that neither changes the particles nor creates
+       * products (such that the velocities of a cell stay the same). */
+      template < typename options >
+      struct Null : model::Base<options> {
+        typedef model::Base<options> super;
+
+        virtual std::string getLabel() const { return "null"; }
+
+        virtual void interact( typename super::ParticleArgRef part1,
+                               typename super::ParticleArgRef part2,
+                               typename super::ProductSink & products,
+                               typename options::RNG & rng ) { }
+
+        virtual Null * new_load( const xml::Context & x,
+                                 const Equation<options> & eq,
+                                 const RuntimeDB<options> & db ) const {
+          return 0;
+        }
+      };
+
+
+      /** ChimpDB of the given species masses whose interactions are added by
+       * the tests instead of being loaded from xml data. */
+      template < typename _options >
+      struct MockDB {
+        /* TYPEDEFS */
+        typedef _options options;
+        typedef typename options::Properties Properties;
+        typedef typename options::InteractionSet Set;
+        typedef std::map< Input, Set > TernaryInteractionTable;
+
+
+        /* MEMBER STORAGE */
+        std::vector<Properties> props;
+        xylose::upper_triangle< Set, xylose::SymmetryFix > interactions;
+        TernaryInteractionTable ternary_interactions;
+
+
+        /* MEMBER FUNCTIONS */
+        /** Constructor for species of the given masses without any
+         * interactions. */
+        MockDB( const std::vector<double> & mass )
+          : props( mass.size() ), interactions( mass.size() ) {
+          for ( unsigned int A = 0u; A < mass.size(); ++A ) {
+            props[A].property::mass::value = mass[A];
+            for ( unsigned int B = A; B < mass.size(); ++B )
+              interactions(A,B).lhs = Input( Term(A,1), Term(B,1) );
+          }
+        }
+
+        /** Add an equation with the given cross section and interaction
+         * model to the set of inputs A and B. */
+        void addEquation( const unsigned int & A,
+                          const unsigned int & B,
+                          cross_section::Base<options> * cs,
+                          model::Base<options> * interaction ) {
+          Set & set = interactions(A,B);
+          Equation<options> eq;
+          eq.A = set.lhs.A;
+          eq.B = set.lhs.B;
+          eq.reducedMass = ReducedMass( props[A].property::mass::value,
+                                        props[B].property::mass::value );
+          eq.cs.reset( cs );
+          eq.interaction.reset( interaction );
+          set.rhs.push_back( eq );
+        }
+
+        /** Add an equation with the given cross section and interaction
+         * model to the set of the three inputs A <= B <= C. */
+        void addEquation( const unsigned int & A,
+                          const unsigned int & B,
+                          const unsigned int & C,
+                          cross_section::Base<options> * cs,
+                          model::Base<options> * interaction ) {
+          const Input in( Term(A,1), Term(B,1), Term(C,1) );
+          Set & set = ternary_interactions[in];
+          set.lhs = in;
+
+          Equation<options> eq;
+          eq.A = in.A;
+          eq.B = in.B;
+          eq.C = in.C;
+          eq.reducedMass = ReducedMass( props[A].property::mass::value,
+                                        props[B].property::mass::value );
+          eq.cs.reset( cs );
+          eq.interaction.reset( interaction );
+          set.rhs.push_back( eq );
+        }
+
+        const std::vector<Properties> & getProps() const { return props; }
+
+        const Properties & operator[] ( const int & i ) const {
+          return props[i];
+        }
+
+        const Set & operator() ( const int & i, const int & j ) const {
+          return interactions(i,j);
+        }
+
+        const TernaryInteractionTable & getTernaryInteractions() const {
+          return ternary_interactions;
+        }
+      };
+
+
+      /** Cell whose particles of each species are consecutive in an external
+       * vector of particles. */
+      template < typename Particle >
+      struct MockCell {
+        /* TYPEDEFS */
+        typedef typename std::vector<Particle>::iterator ParticleIterator;
+        typedef xylose::IteratorRange<ParticleIterator> SpeciesRange;
+
+
+        /* MEMBER STORAGE */
+        std::vector<SpeciesRange> species;
+        double V;
+
+
+        /* MEMBER FUNCTIONS */
+        /** Constructor of the cell with n[A] particles of species A,
+         * starting at first. */
+        MockCell( const ParticleIterator & first,
+                  const std::vector<unsigned int> & n,
+                  const double & V = 1.0 )
+          : V(V) {
+          ParticleIterator i = first;
+          for ( unsigned int A = 0u; A < n.size(); ++A ) {
+            species.push_back( SpeciesRange( i, i + n[A] ) );
+            i += n[A];
+          }
+        }
+
+        std::size_t getNumberOfSpecies() const { return species.size(); }
+
+        SpeciesRange & getSpecies( const unsigned int & A ) {
+          return species[A];
+        }
+
+        /** The sum of the largest speeds of species A and B, which bounds
+         * their relative speeds. */
+        double maxRelativeVelocity( const unsigned int & A,
+                                    const unsigned int & B ) const {
+          return maxSpeed( species[A] ) + maxSpeed( species[B] );
+        }
+
+        double volume() const { return V; }
+
+        static double maxSpeed( const SpeciesRange & range ) {
+          using chimp::accessors::particle::velocity;
+          double v = 0.0;
+          for ( ParticleIterator i = range.begin(); i != range.end(); ++i )
+            v = std::max( v, velocity(*i).abs() );
+          return v;
+        }
+      };
+
+
+      /** Monitor that counts the tests and records the particles (by their
+       * first position coordinate) of each pair or triple that interacted. */
+      struct RecordingMonitor {
+        /* MEMBER STORAGE */
+        /** Number of pairs tested. */
+        unsigned long tests;
+
+        /** Number of triples tested. */
+        unsigned long triple_tests;
+
+        /** Sum of the number of tests reported by the driver. */
+        double pairtests_sum;
+
+        /** Identifiers of the two particles of each interacting pair, in the
+         * order of the interactions. */
+        std::vector< std::pair<double,double> > accepted;
+
+        /** Output path of each interacting pair. */
+        std::vector<int> paths;
+
+        /** Identifiers of the three particles of each interacting triple, in
+         * the order of the interactions. */
+        std::vector< Triple<double> > triples;
+
+
+        /* MEMBER FUNCTIONS */
+        RecordingMonitor()
+          : tests(0ul), triple_tests(0ul), pairtests_sum(0.0) { }
+
+        template < typename ChimpDB,
+                   typename PIter,
+                   typename BackInsertionSequence >
+        void interactions( const ChimpDB & db,
+                           const std::pair<PIter, PIter> & pair,
+                           const std::pair<int,double> & path,
+                           const BackInsertionSequence & result_list ) {
+          using chimp::accessors::particle::position;
+          ++tests;
+          if ( path.first < 0 )
+            return;
+
+          accepted.push_back( std::make_pair( position(*pair.first)[0],
+                                              position(*pair.second)[0] ) );
+          paths.push_back( path.first );
+        }
+
+        template < typename ChimpDB,
+                   typename PIter,
+                   typename BackInsertionSequence >
+        void interactions( const ChimpDB & db,
+                           const Triple<PIter> & triple,
+                           const std::pair<int,double> & path,
+                           const BackInsertionSequence & result_list ) {
+          using chimp::accessors::particle::position;
+          ++triple_tests;
+          if ( path.first < 0 )
+            return;
+
+          triples.push_back( Triple<double>( position(*triple.first)[0],
+                                             position(*triple.second)[0],
+                                             position(*triple.third)[0] ) );
+        }
+
+        void pairtests( const double & number_of_pairtests ) {
+          pairtests_sum += number_of_pairtests;
+        }
+
+        void beginPairType( const unsigned int & A,
+                            const unsigned int & B ) const { }
+        void endPairType( const unsigned int & A,
+                          const unsigned int & B ) const { }
+
+        void merge( const RecordingMonitor & other ) {
+          tests += other.tests;
+          triple_tests += other.triple_tests;
+          pairtests_sum += other.pairtests_sum;
+          accepted.insert( accepted.end(), other.accepted.begin(),
+                           other.accepted.end() );
+          paths.insert( paths.end(), other.paths.begin(), other.paths.end() );
+          triples.insert( triples.end(), other.triples.begin(),
+                          other.triples.end() );
+        }
+      };
+
+    }/* namespace chimp::interaction::test */
+  }/* namespace chimp::interaction */
+}/* namespace chimp */
+
+#endif // chimp_interaction_test_fixtures_h
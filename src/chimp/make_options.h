@@ -29,12 +29,17 @@
 #define chimp_make_options_h
 
 #include <chimp/interaction/Particle.h>
+#include <chimp/interaction/ProductSink.h>
 #include <chimp/property/DefaultSet.h>
 
 #include <xylose/random/Kiss.hpp>
 
 namespace chimp {
 
+  namespace interaction {
+    template < typename options > struct Set;
+  }
+
   /** Metafunction to generate the chimp::options class.
    * @tparam _Particle
    *   Class that is used for the collision/interaction functions.
@@ -106,6 +111,32 @@ namespace chimp {
    *   environment variable.  If this variable is set to 'no' then extrapolation
    *   will not be allowed.  Anything else will allow extrapolation.
    *   [Default:  true]
+   *
+   * @tparam _InteractionSet
+   *   The class template used for each set of equations (with common input)
+   *   in the RuntimeDB interaction table.  This template is instantiated with
+   *   the resulting options type.  See chimp::interaction::PreComputedSet for
+   *   an alternative that tabulates the cross sections.
+   *   [Default:  chimp::interaction::Set]
+   *
+   * @tparam _ProductSink
+   *   Metafunction of the Particle type that gives the type of the product
+   *   sink into which the interaction models write the products of the
+   *   interactions (see chimp::interaction::VectorSink for the requirements
+   *   on this type).  See chimp::interaction::SlabSink for an alternative
+   *   that writes into caller-owned storage.
+   *   [Default:  chimp::interaction::VectorSink]
+   *
+   * @tparam _split_weights
+   *   Whether the elastic interaction models split the heavier particle of a
+   *   pair of unequal weights (see
+   *   chimp::interaction::model::detail::splitWeights), which conserves
+   *   momentum and energy exactly but adds a particle for each such
+   *   collision.  If false, no particle is split and the heavier particle
+   *   only takes its post-collision velocity with probability
+   *   w_light/w_heavy (see chimp::interaction::model::detail::scatterUnsplit),
+   *   such that the number of particles stays constant.
+   *   [Default:  true]
    * */
   template <
     typename _Particle          = chimp::interaction::Particle,
@@ -113,7 +144,10 @@ namespace chimp {
     bool _inplace_interactions  = true,
     bool _auto_create_missing_elastic = false,
     typename _RNG               = xylose::random::Kiss,
-    bool _cross_section_data_extrapolation_allowed = true
+    bool _cross_section_data_extrapolation_allowed = true,
+    template < typename > class _InteractionSet = chimp::interaction::Set,
+    template < typename > class _ProductSink = chimp::interaction::VectorSink,
+    bool _split_weights         = true
   >
   struct make_options {
     /** The result of the chimp::make_options template metafunction. */
@@ -145,6 +179,18 @@ namespace chimp {
       static const bool cross_section_data_extrapolation_allowed
         = _cross_section_data_extrapolation_allowed;
 
+      /** The type of each set of equations in the RuntimeDB interaction
+       * table. */
+      typedef _InteractionSet<type> InteractionSet;
+
+      /** The type of the product sink into which the interaction models
+       * write the products of the interactions. */
+      typedef typename _ProductSink<Particle>::type ProductSink;
+
+      /** Whether the elastic interaction models split the heavier particle of
+       * a pair of unequal weights. */
+      static const bool split_weights = _split_weights;
+
       /** Set options with the given Particle type. */
       template < typename T >
       struct setParticle {
@@ -154,7 +200,10 @@ namespace chimp {
           inplace_interactions,
           auto_create_missing_elastic,
           RNG,
-          cross_section_data_extrapolation_allowed
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          _ProductSink,
+          split_weights
         >::type type;
       };/* setParticle */
 
@@ -167,7 +216,10 @@ namespace chimp {
           inplace_interactions,
           auto_create_missing_elastic,
           RNG,
-          cross_section_data_extrapolation_allowed
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          _ProductSink,
+          split_weights
         >::type type;
       };/* setProperties */
 
@@ -180,7 +232,10 @@ namespace chimp {
           B,
           auto_create_missing_elastic,
           RNG,
-          cross_section_data_extrapolation_allowed
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          _ProductSink,
+          split_weights
         >::type type;
       };/* setInplaceInteractions */
 
@@ -193,7 +248,10 @@ namespace chimp {
           inplace_interactions,
           B,
           RNG,
-          cross_section_data_extrapolation_allowed
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          _ProductSink,
+          split_weights
         >::type type;
       };/* setAutoCreateMissingElastic */
 
@@ -206,7 +264,10 @@ namespace chimp {
           inplace_interactions,
           auto_create_missing_elastic,
           T,
-          cross_section_data_extrapolation_allowed
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          _ProductSink,
+          split_weights
         >::type type;
       };/* setRNG */
 
@@ -219,9 +280,63 @@ namespace chimp {
           inplace_interactions,
           auto_create_missing_elastic,
           RNG,
-          B
+          B,
+          _InteractionSet,
+          _ProductSink,
+          split_weights
         >::type type;
-      };/* setRNG */
+      };/* setCrossSectionExtrapolAllowed */
+
+      /** Set options with the given class template for the sets of equations
+       * in the RuntimeDB interaction table. */
+      template < template < typename > class T >
+      struct setInteractionSet {
+        typedef typename make_options<
+          Particle,
+          Properties,
+          inplace_interactions,
+          auto_create_missing_elastic,
+          RNG,
+          cross_section_data_extrapolation_allowed,
+          T,
+          _ProductSink,
+          split_weights
+        >::type type;
+      };/* setInteractionSet */
+
+      /** Set options with the given metafunction for the type of the product
+       * sink. */
+      template < template < typename > class T >
+      struct setProductSink {
+        typedef typename make_options<
+          Particle,
+          Properties,
+          inplace_interactions,
+          auto_create_missing_elastic,
+          RNG,
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          T,
+          split_weights
+        >::type type;
+      };/* setProductSink */
+
+      /** Set options with the given choice of splitting particles of unequal
+       * weights. */
+      template < bool T >
+      struct setSplitWeights {
+        typedef typename make_options<
+          Particle,
+          Properties,
+          inplace_interactions,
+          auto_create_missing_elastic,
+          RNG,
+          cross_section_data_extrapolation_allowed,
+          _InteractionSet,
+          _ProductSink,
+          T
+        >::type type;
+      };/* setSplitWeights */
     };/* struct type */
   };/* make_options */
 
@@ -30,13 +30,23 @@
 #include <chimp/RuntimeDB.h>
 #include <chimp/interaction/filter/Or.h>
 #include <chimp/interaction/filter/Not.h>
+#include <chimp/interaction/filter/Null.h>
 #include <chimp/interaction/filter/EqIO.h>
 #include <chimp/interaction/filter/Label.h>
 #include <chimp/interaction/filter/Elastic.h>
 
+#include <xylose/XSTR.h>
+
+#include <physical/physical.h>
+
 #include <boost/test/unit_test.hpp>
 
 #include <sstream>
+#include <cmath>
+
+#ifndef TERNARY_FILENAME
+#  error The filename was supposed to already be defined on the command line
+#endif
 
 BOOST_AUTO_TEST_SUITE( RuntimeDB_tests ); // {
 
@@ -162,6 +172,82 @@ BOOST_AUTO_TEST_SUITE( RuntimeDB_tests ); // {
     BOOST_CHECK_EQUAL( db("Hg^+","Hg^+").rhs.size(), 0u );
   }
 
+  BOOST_AUTO_TEST_CASE( find_ternary_interactions ) {
+    namespace filter = chimp::interaction::filter;
+    typedef boost::shared_ptr<filter::Base> SP;
+    using chimp::interaction::Input;
+
+    typedef chimp::RuntimeDB<> DB;
+    DB db;
+    db.addParticleType("e^-");
+    db.addParticleType("O2");
+    db.addParticleType("O2^-");
+    db.initBinaryInteractions();
+
+    const int i_e  = db.findParticleIndx("e^-");
+    const int i_O2 = db.findParticleIndx("O2");
+
+    /* the default filter only allows elastic interactions. */
+    db.initTernaryInteractions();
+    BOOST_CHECK_EQUAL( db.getTernaryInteractions().size(), 0u );
+    BOOST_CHECK_EQUAL( db(i_O2, i_e, i_O2).rhs.size(), 0u );
+
+    db.filter = SP( new filter::Null );
+    DB::LHSRelatedInteractionCtx ctxs = db.findAllTernaryInteractionCtx();
+
+    // NOTE:  if we add new collisions data, we will have to change these:
+    BOOST_CHECK_EQUAL( ctxs.size(), 1u );
+    BOOST_CHECK_EQUAL( ctxs[ Input(i_e, i_O2, i_O2) ].size(), 1u );
+  }
+
+  BOOST_AUTO_TEST_CASE( load_ternary_interactions ) {
+    namespace filter = chimp::interaction::filter;
+    typedef boost::shared_ptr<filter::Base> SP;
+    using physical::constant::si::eV;
+
+    typedef chimp::RuntimeDB<> DB;
+    DB db;
+    db.addParticleType("e^-");
+    db.addParticleType("Hg");
+    db.addParticleType("Hg^+");
+    db.initBinaryInteractions();
+
+    /* the test data has cross sections in m^5. */
+    db.addXMLData( XSTR(TERNARY_FILENAME) );
+    db.filter = SP( new filter::Null );
+    db.initTernaryInteractions();
+
+    const int i_e   = db.findParticleIndx("e^-");
+    const int i_Hg  = db.findParticleIndx("Hg");
+    const int i_Hgp = db.findParticleIndx("Hg^+");
+
+    BOOST_CHECK_EQUAL( db.getTernaryInteractions().size(), 2u );
+    BOOST_CHECK_EQUAL( db(i_Hg, i_e, i_Hg).rhs.size(), 0u );
+
+    {
+      const DB::Set & set = db(i_Hgp, i_e, i_e);
+      BOOST_REQUIRE_EQUAL( set.rhs.size(), 1u );
+      BOOST_CHECK( set.lhs.isTernary() );
+      BOOST_CHECK( set.rhs[0].isTernary() );
+      BOOST_CHECK_EQUAL( set.rhs[0].interaction->getLabel(), "inelastic" );
+      BOOST_CHECK_EQUAL( set.rhs[0].cs->getLabel(), "constant" );
+      BOOST_CHECK_CLOSE( (*set.rhs[0].cs)( 1e5 ), 1e-40, 1e-10 );
+    }
+
+    {
+      const DB::Set & set = db(i_e, i_Hgp, i_Hg);
+      BOOST_REQUIRE_EQUAL( set.rhs.size(), 1u );
+      BOOST_CHECK( set.lhs.isTernary() );
+      BOOST_CHECK_EQUAL( set.rhs[0].cs->getLabel(), "data" );
+
+      /* 1e-42 m^5 at 1 eV, going to zero above 10 eV. */
+      const double v_1eV =
+        std::sqrt( 2.0 * eV / set.rhs[0].reducedMass.value );
+      BOOST_CHECK_CLOSE( (*set.rhs[0].cs)( v_1eV ), 1e-42, 1e-3 );
+      BOOST_CHECK_EQUAL( (*set.rhs[0].cs)( 1e8 ), 0.0 );
+    }
+  }
+
   BOOST_AUTO_TEST_SUITE( create_missing_elastic_tests ); // {
     /* reused check code */
     template < typename DB >